@@ -0,0 +1,19 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+
+// 全局堆分配计数(仅链接进基准测试程序)
+// alloc_counter.cpp 替换了全局 operator new/delete, 用于验证求解循环不访问全局堆
+
+/**
+ * @brief 程序启动以来全局 operator new 的调用次数
+ */
+size_t globalAllocationCount();
+
+/**
+ * @brief 程序启动以来全局 operator new 申请的总字节数
+ */
+size_t globalAllocatedBytes();
+
+#endif // ALLOC_COUNTER_H
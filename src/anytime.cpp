@@ -0,0 +1,211 @@
+#include "anytime.h"
+#include "arena.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+
+const char* anytimeStopName(AnytimeStop stop) {
+    switch (stop) {
+    case AnytimeStop::Rounds:    return "轮数上限";
+    case AnytimeStop::Deadline:  return "时间预算用完";
+    case AnytimeStop::Cancelled: return "已取消";
+    case AnytimeStop::Callback:  return "回调要求停止";
+    }
+    return "";
+}
+
+AnytimeSolver::AnytimeSolver(const std::vector<Laboratory>& labs,
+                             const std::vector<LabRequest>& requests,
+                             std::span<const SlotMask> allowedMasks,
+                             const OccupancyGrid& initial,
+                             std::pmr::memory_resource* resource)
+    : labs(labs), requests(requests), allowedMasks(allowedMasks), initial(initial), resource(resource) {}
+
+void AnytimeSolver::setOrderingStrategy(OrderingStrategy strategy, int bandWidth) {
+    ordering = strategy;
+    this->bandWidth = bandWidth;
+}
+
+void AnytimeSolver::setRoomSharing(RoomSharing mode, std::span<const CourseKey> courseKeys) {
+    sharing = mode;
+    this->courseKeys = courseKeys;
+}
+
+void AnytimeSolver::setRequestGroups(const SlotPatternTable& patterns, const RequestGroups& groups) {
+    this->patterns = &patterns;
+    this->groups = &groups;
+}
+
+void AnytimeSolver::runGreedy(OrderingStrategy strategy, std::span<const int> order,
+                              std::pmr::vector<Placement>& result, std::pmr::memory_resource* scratch) {
+    result.clear();
+    GreedySolver solver(labs, requests, allowedMasks, initial, scratch);
+    solver.setOrderingStrategy(strategy, bandWidth);
+    solver.setRoomSharing(sharing, courseKeys);
+    solver.setFairnessGroups(fairnessGroups);
+    solver.setPhaseTiming(phaseTiming);
+    if (patterns && groups) {
+        solver.setRequestGroups(*patterns, *groups);
+    }
+    solver.solve(order, result);
+    stats.add(solver.counters());
+}
+
+// 一次求解的实际处理顺序: 成功的申请按分配顺序, 失败的申请按原顺序排在最后
+static void processingOrder(std::span<const int> subset, const std::pmr::vector<Placement>& result,
+                            size_t requestCount, std::pmr::vector<int>& order,
+                            std::pmr::memory_resource* scratch) {
+    std::pmr::vector<char> placed(requestCount, 0, scratch);
+    order.clear();
+    for (const auto& placement : result) {
+        order.push_back(placement.requestIndex);
+        placed[placement.requestIndex] = 1;
+    }
+    for (int index : subset) {
+        if (!placed[index]) {
+            order.push_back(index);
+        }
+    }
+}
+
+// 挤压: 分配失败的申请前移至多 n/4 个位置, 只得到备选时间段的前移至多 n/8 个位置
+static void squeeze(std::pmr::vector<int>& order, const std::pmr::vector<Placement>& result,
+                    size_t requestCount, std::mt19937& rng, std::pmr::memory_resource* scratch) {
+    std::pmr::vector<char> blame(requestCount, 2, scratch);
+    for (const auto& placement : result) {
+        blame[placement.requestIndex] = placement.preferred ? 0 : 1;
+    }
+    double reach = std::max(4.0, order.size() / 8.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::pmr::vector<std::pair<double, int>> keyed(scratch);
+    keyed.reserve(order.size());
+    for (size_t position = 0; position < order.size(); position++) {
+        int index = order[position];
+        keyed.emplace_back(position - blame[index] * reach * unit(rng), index);
+    }
+    std::stable_sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    for (size_t position = 0; position < order.size(); position++) {
+        order[position] = keyed[position].second;
+    }
+}
+
+AnytimeResult AnytimeSolver::solve(std::span<const int> subset, std::pmr::vector<Placement>& placements,
+                                   const AnytimeOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    auto elapsed = [start]() {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    AnytimeResult result;
+    ScheduleEvaluator evaluator(labs, requests, objectiveWeights);
+    auto evaluate = [&](const std::pmr::vector<Placement>& candidate) {
+        evaluator.clear();
+        evaluator.placeAll(fixedPlacements);
+        evaluator.placeAll(candidate);
+        return evaluator.scores();
+    };
+
+    std::pmr::vector<Placement> best(resource);
+    std::pmr::vector<Placement> current(resource);
+    std::pmr::vector<Placement> combined(resource);
+    // 通知回调, 返回 false 表示停止
+    auto notify = [&](int round, const char* engine) {
+        if (!options.onIncumbent) {
+            return true;
+        }
+        combined.assign(fixedPlacements.begin(), fixedPlacements.end());
+        combined.insert(combined.end(), best.begin(), best.end());
+        std::sort(combined.begin(), combined.end(), [](const Placement& a, const Placement& b) {
+            return a.requestIndex < b.requestIndex;
+        });
+        AnytimeIncumbent incumbent{round, engine, elapsed(), result.scores, combined, labs, requests};
+        return options.onIncumbent(incumbent);
+    };
+
+    // 每轮的内核、占用副本与临时向量放在本轮的内存区域中, 下一轮开始时整体回收,
+    // 轮数再多内存也不增长; 跨轮保留的课表与处理顺序在 resource 中, 容量不超过申请数
+    RunArena roundArena(RunArena::estimateBytes(labs.size(), requests.size()));
+    std::pmr::memory_resource* scratch = roundArena.resource();
+
+    // 第 0 轮: 按所选策略求解, 总会完成
+    runGreedy(ordering, subset, best, scratch);
+    result.scores = evaluate(best);
+    std::pmr::vector<int> bestOrder(resource);
+    processingOrder(subset, best, requests.size(), bestOrder, scratch);
+    bool keepGoing = notify(0, orderingStrategyName(ordering));
+
+    // 改进轮次: 先尝试其余排序策略, 再反复挤压
+    std::pmr::vector<OrderingStrategy> portfolio(resource);
+    for (OrderingStrategy strategy : {OrderingStrategy::Priority, OrderingStrategy::FewestFeasible,
+                                      OrderingStrategy::LargestClass, OrderingStrategy::PriorityBands}) {
+        if (strategy != ordering) {
+            portfolio.push_back(strategy);
+        }
+    }
+    size_t nextStrategy = 0;
+    std::pmr::vector<int> order(resource);
+    std::mt19937 rng(options.seed);
+    int stale = 0;
+    bool squeezing = false;
+
+    for (int round = 1;; round++) {
+        if (!keepGoing) {
+            result.stop = AnytimeStop::Callback;
+            break;
+        }
+        if (!options.enabled() || (options.maxRounds > 0 && result.rounds >= options.maxRounds)) {
+            result.stop = AnytimeStop::Rounds;
+            break;
+        }
+        if (options.cancel && options.cancel->cancelled()) {
+            result.stop = AnytimeStop::Cancelled;
+            break;
+        }
+        if (options.timeBudget > 0 && elapsed() >= options.timeBudget) {
+            result.stop = AnytimeStop::Deadline;
+            break;
+        }
+
+        roundArena.release();
+        const char* engine;
+        if (nextStrategy < portfolio.size()) {
+            OrderingStrategy strategy = portfolio[nextStrategy++];
+            engine = orderingStrategyName(strategy);
+            runGreedy(strategy, subset, current, scratch);
+            processingOrder(subset, current, requests.size(), order, scratch);
+        } else {
+            if (!squeezing || stale >= kRestartAfter) {
+                // 从最优课表出发挤压
+                order = bestOrder;
+                current = best;
+                squeezing = true;
+                stale = 0;
+            }
+            engine = "squeaky-wheel";
+            squeeze(order, current, requests.size(), rng, scratch);
+            runGreedy(OrderingStrategy::Priority, order, current, scratch);
+        }
+        result.rounds++;
+
+        ObjectiveScores scores = evaluate(current);
+        if (scores.total > result.scores.total) {
+            best = current;
+            bestOrder = order;
+            result.scores = scores;
+            result.improvements++;
+            result.bestRound = round;
+            stale = 0;
+            keepGoing = notify(round, engine);
+        } else {
+            stale++;
+        }
+    }
+
+    placements.insert(placements.end(), best.begin(), best.end());
+    result.seconds = elapsed();
+    return result;
+}
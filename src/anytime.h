@@ -0,0 +1,167 @@
+#ifndef ANYTIME_H
+#define ANYTIME_H
+
+#include "lab_types.h"
+#include "objective.h"
+#include "occupancy.h"
+#include "request_order.h"
+#include "slot_pattern.h"
+#include "solver.h"
+#include <atomic>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief 取消标记: 由其他线程(如界面或脚本的"停止")置位, 求解方在每轮之间检查
+ */
+class CancellationToken {
+public:
+    void cancel() { flag.store(true, std::memory_order_relaxed); }
+    void reset() { flag.store(false, std::memory_order_relaxed); }
+    bool cancelled() const { return flag.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> flag{false};
+};
+
+/**
+ * @brief 求解过程中找到的一个更好的完整课表
+ *
+ * placements 按申请下标排序, 包含固定的分配(见 AnytimeSolver::setFixedPlacements),
+ * 下标对应 labs/requests; 只在回调期间有效。
+ */
+struct AnytimeIncumbent {
+    int round;              // 产生该课表的轮次(0 为按所选策略的初始贪心解)
+    const char* engine;     // 产生该课表的方法
+    double seconds;         // 自开始求解以来的时间
+    ObjectiveScores scores;
+    std::span<const Placement> placements;
+    const std::vector<Laboratory>& labs;
+    const std::vector<LabRequest>& requests;
+};
+
+// 返回 false 时停止求解(当前课表已足够好)
+using IncumbentCallback = std::function<bool(const AnytimeIncumbent&)>;
+
+/**
+ * @brief 随时可停的求解设置
+ *
+ * 时间预算、轮数上限与取消标记任一给出即启用; 只给出取消标记时一直改进到被取消。
+ */
+struct AnytimeOptions {
+    double timeBudget = 0;                      // 墙钟时间预算(秒), <= 0 表示不限时间
+    int maxRounds = 0;                          // 改进轮数上限(不含初始解), <= 0 表示不限轮数
+    const CancellationToken* cancel = nullptr;  // 由调用方持有
+    IncumbentCallback onIncumbent;              // 每找到一个更好的课表调用一次(在求解线程中)
+    unsigned seed = 1;                          // 改进轮次的随机数种子, 相同输入与种子的结果相同
+
+    bool enabled() const { return timeBudget > 0 || maxRounds > 0 || cancel != nullptr; }
+};
+
+/**
+ * @brief 随时可停的求解为何结束
+ */
+enum class AnytimeStop {
+    Rounds,     // 达到轮数上限
+    Deadline,   // 时间预算用完
+    Cancelled,  // 取消标记被置位
+    Callback    // 回调返回 false
+};
+
+const char* anytimeStopName(AnytimeStop stop);
+
+struct AnytimeResult {
+    int rounds = 0;                        // 完成的改进轮数(不含初始解)
+    int improvements = 0;                  // 找到更好课表的次数(不含初始解)
+    int bestRound = 0;                     // 最优课表所在的轮次
+    AnytimeStop stop = AnytimeStop::Rounds;
+    ObjectiveScores scores;                // 最优课表的目标函数(含固定的分配)
+    double seconds = 0;
+};
+
+/**
+ * @brief 随时可停的求解器: 先得到一个完整可行的课表, 之后在预算内不断尝试改进
+ *
+ * 第 0 轮按所选排序策略贪心求解, 无论预算多少都会完成, 因此总有一个完整可行的课表。
+ * 之后每一轮都是一次完整的贪心求解, 只在轮次之间检查截止时间、取消标记与回调结果:
+ *   1. 依次尝试其余排序策略(Priority/FewestFeasible/LargestClass/PriorityBands)
+ *   2. 挤压轮(squeaky wheel): 按上一轮的结果, 把分配失败或只得到备选时间段的申请
+ *      在处理顺序中随机前移(失败的前移更多), 再按新顺序求解;
+ *      连续若干轮没有改进时从最优课表的处理顺序重新开始
+ * 每轮的课表用 ScheduleEvaluator 评价, 总分严格更高时成为新的最优课表并通知回调。
+ *
+ * 改进轮次按目标函数而不是申请优先级取舍: 为了多分配一个大班, 可能让优先级更高的申请
+ * 改用备选时间段甚至分配失败。
+ */
+class AnytimeSolver {
+public:
+    /**
+     * @param initial 初始占用(每轮从它的副本开始)
+     */
+    AnytimeSolver(const std::vector<Laboratory>& labs,
+                  const std::vector<LabRequest>& requests,
+                  std::span<const SlotMask> allowedMasks,
+                  const OccupancyGrid& initial,
+                  std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // 以下设置与 GreedySolver 的同名设置相同, 用于第 0 轮及后续各轮
+    void setOrderingStrategy(OrderingStrategy strategy, int bandWidth);
+    void setRoomSharing(RoomSharing mode, std::span<const CourseKey> courseKeys);
+    void setFairnessGroups(std::span<const int> groups) { fairnessGroups = groups; }
+    void setRequestGroups(const SlotPatternTable& patterns, const RequestGroups& groups);
+    void setPhaseTiming(bool enabled) { phaseTiming = enabled; }
+
+    void setObjectiveWeights(const ObjectiveWeights& weights) { objectiveWeights = weights; }
+
+    /**
+     * @brief 已经固定、不参与求解的分配(如粘性重新生成保留的安排), 由调用方持有
+     *
+     * 固定的分配已计入初始占用, 这里只用于目标函数与回调中的完整课表。
+     */
+    void setFixedPlacements(std::span<const Placement> fixed) { fixedPlacements = fixed; }
+
+    /**
+     * @brief 在预算内求解 subset 中的申请
+     * @param subset 待分配申请的下标(按优先级顺序)
+     * @param placements 最优课表中 subset 部分的分配结果追加到此处
+     */
+    AnytimeResult solve(std::span<const int> subset, std::pmr::vector<Placement>& placements,
+                        const AnytimeOptions& options);
+
+    /**
+     * @brief 各轮内核计数器之和
+     */
+    const SolverCounters& counters() const { return stats; }
+
+private:
+    const std::vector<Laboratory>& labs;
+    const std::vector<LabRequest>& requests;
+    std::span<const SlotMask> allowedMasks;
+    const OccupancyGrid& initial;
+    std::pmr::memory_resource* resource;
+    OrderingStrategy ordering = OrderingStrategy::Priority;
+    int bandWidth = 10;
+    RoomSharing sharing = RoomSharing::Off;
+    std::span<const CourseKey> courseKeys;
+    std::span<const int> fairnessGroups;
+    const SlotPatternTable* patterns = nullptr;
+    const RequestGroups* groups = nullptr;
+    bool phaseTiming = false;
+    ObjectiveWeights objectiveWeights;
+    std::span<const Placement> fixedPlacements;
+    SolverCounters stats;
+
+    // 连续多少轮挤压没有改进后从最优课表的处理顺序重新开始
+    static constexpr int kRestartAfter = 16;
+
+    /**
+     * @brief 按策略贪心求解一次(每次使用新的内核与初始占用的副本)
+     * @param scratch 本轮的内存区域: 内核及其占用副本、队列从这里分配, 结果写入 result 自己的资源
+     */
+    void runGreedy(OrderingStrategy strategy, std::span<const int> order, std::pmr::vector<Placement>& result,
+                   std::pmr::memory_resource* scratch);
+};
+
+#endif // ANYTIME_H
@@ -0,0 +1,88 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+/**
+ * @brief 统计分配次数与字节数的内存资源(转发给上游资源)
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {}
+
+    size_t allocationCount() const { return allocations; }
+    size_t bytesAllocated() const { return bytes; }
+
+private:
+    std::pmr::memory_resource* upstream;
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+    void* do_allocate(size_t size, size_t alignment) override {
+        allocations++;
+        bytes += size;
+        return upstream->allocate(size, alignment);
+    }
+
+    void do_deallocate(void* p, size_t size, size_t alignment) override {
+        upstream->deallocate(p, size, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * @brief 单次调度运行的内存区域
+ *
+ * 一次 generateSchedule 中的临时数据(占用表副本、排序队列、分配结果等)
+ * 都从这里以指针递增的方式分配, 单个释放为空操作, 运行结束时整体一次性释放。
+ * 初始缓冲区按问题规模预估, 一次性申请; 不够时才向上游申请新的块。
+ *
+ * 与 std::pmr::monotonic_buffer_resource 一样不是线程安全的,
+ * 并行求解时每个工作线程使用自己的内存区域。
+ */
+class RunArena {
+public:
+    explicit RunArena(size_t initialBytes)
+        : initialSize(initialBytes > 0 ? initialBytes : 1),
+          buffer(std::make_unique_for_overwrite<std::byte[]>(initialSize)),
+          monotonic(buffer.get(), initialSize, &upstream) {}
+
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &monotonic; }
+
+    /**
+     * @brief 释放向上游追加的块并回到初始缓冲区的开头, 供下一轮复用
+     *
+     * 之前从本区域分配的对象都不能再使用。
+     */
+    void release() { monotonic.release(); }
+
+    size_t initialBytes() const { return initialSize; }
+
+    // 初始缓冲区用尽后向上游追加申请的次数与字节数
+    size_t overflowCount() const { return upstream.allocationCount(); }
+    size_t overflowBytes() const { return upstream.bytesAllocated(); }
+
+    /**
+     * @brief 按问题规模估算一次运行所需的内存
+     */
+    static size_t estimateBytes(size_t labCount, size_t requestCount) {
+        return 64 * 1024 + labCount * 128 + requestCount * 160;
+    }
+
+private:
+    size_t initialSize;
+    std::unique_ptr<std::byte[]> buffer;
+    CountingResource upstream;
+    std::pmr::monotonic_buffer_resource monotonic;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,1557 @@
+#include "alloc_counter.h"
+#include "arena.h"
+#include "core_scheduler.h"
+#include "database.h"
+#include "scheduler.h"
+#include "sharding.h"
+#include "timetable_cache.h"
+#include "timetable_export.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+// 基准测试: 随机生成实验室与申请, 比较不同调度配置的成功率与耗时
+// 用法: benchmark [申请数量] [实验室数量] [随机种子] [week]
+//       第4个参数为 week 时, 每种时间段模式只落在某一周内(可按周分区)
+
+struct BenchConfig {
+    int requestCount = 2000;
+    int labCount = 110;
+    unsigned seed = 42;
+    bool weekLocal = false;
+    double featureShare = 0.0;  // 需要特定设备的申请比例
+    int sectionsPerCourse = 0;  // 每门课程的平均班级数, 0 表示不设置课程
+    double shareableShare = 0.0;  // 允许与其他课程共用实验室的申请比例
+};
+
+// 时间段模式: 真实数据中大量申请共享同一组期望/排除时间段
+struct SlotPattern {
+    std::vector<TimeSlot> preferred;
+    std::vector<TimeSlot> excluded;
+};
+
+static SlotPattern randomPattern(std::mt19937& rng, int excludedCount, bool weekLocal) {
+    std::vector<int> slots(kSlotCount);
+    for (int s = 0; s < kSlotCount; s++) {
+        slots[s] = s;
+    }
+    std::shuffle(slots.begin(), slots.end(), rng);
+
+    SlotPattern pattern;
+    if (weekLocal) {
+        // 排除另一周的全部时间段, 本周内再排除少量时间段
+        const int slotsPerWeek = kDaysPerWeek * kPeriodsPerDay;
+        int week = rng() % kWeekCount;
+        std::stable_partition(slots.begin(), slots.end(), [week](int s) {
+            return s / slotsPerWeek != week;
+        });
+        excludedCount = kSlotCount - slotsPerWeek + std::min(excludedCount / 2, slotsPerWeek - 4);
+    }
+
+    int preferredCount = 1 + rng() % 4;
+    for (int k = 0; k < excludedCount; k++) {
+        pattern.excluded.push_back(slotFromIndex(slots[k]));
+    }
+    for (int k = 0; k < preferredCount; k++) {
+        pattern.preferred.push_back(slotFromIndex(slots[excludedCount + k]));
+    }
+    return pattern;
+}
+
+// 生成随机实例: 大班容量要求高且可用时间段少, 小班时间灵活
+static void populate(Database& db, const BenchConfig& config) {
+    std::mt19937 rng(config.seed);
+    const int capacities[] = {30, 40, 40, 50, 60, 80, 120};
+
+    // 设备特性使用独立的随机数序列, 不影响其余数据的生成
+    std::mt19937 featureRng(config.seed + 1);
+    const std::string featureNames[] = {"fume_hood", "gpu", "oscilloscope", "network_rack"};
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    // 课程与共享标记同样使用独立的随机数序列
+    std::mt19937 courseRng(config.seed + 2);
+    int courseCount = config.sectionsPerCourse > 0
+                          ? std::max(1, config.requestCount / config.sectionsPerCourse) : 0;
+
+    for (int i = 0; i < config.labCount; i++) {
+        int capacity = capacities[rng() % 7];
+        std::vector<std::string> features;
+        if (config.featureShare > 0) {
+            for (const auto& name : featureNames) {
+                if (unit(featureRng) < 0.3) {
+                    features.push_back(name);
+                }
+            }
+        }
+        db.addLaboratory("实验楼" + std::string(1, char('A' + i % 6)) + std::to_string(100 + i),
+                         capacity, features);
+    }
+
+    std::vector<SlotPattern> smallPatterns, largePatterns;
+    for (int i = 0; i < 24; i++) {
+        smallPatterns.push_back(randomPattern(rng, rng() % 4, config.weekLocal));
+    }
+    for (int i = 0; i < 8; i++) {
+        largePatterns.push_back(randomPattern(rng, 12 + rng() % 6, config.weekLocal));
+    }
+
+    std::uniform_int_distribution<int> smallSize(15, 45);
+    std::uniform_int_distribution<int> largeSize(55, 115);
+    for (int i = 0; i < config.requestCount; i++) {
+        LabRequest req;
+        bool large = rng() % 5 == 0;
+        req.classId = "C" + std::to_string(100000 + i);
+        req.studentCount = large ? largeSize(rng) : smallSize(rng);
+        req.teacher = "T" + std::to_string(rng() % (config.requestCount / 8 + 1));
+        req.priority = i;
+
+        // 大部分申请沿用常见模式, 少数为独立的随机模式
+        SlotPattern pattern;
+        if (rng() % 10 == 0) {
+            pattern = randomPattern(rng, large ? 12 + rng() % 6 : rng() % 4, config.weekLocal);
+        } else if (large) {
+            pattern = largePatterns[rng() % largePatterns.size()];
+        } else {
+            pattern = smallPatterns[rng() % smallPatterns.size()];
+        }
+        req.preferredSlots = pattern.preferred;
+        req.excludedSlots = pattern.excluded;
+        if (unit(featureRng) < config.featureShare) {
+            req.requiredFeatures.push_back(featureNames[featureRng() % 4]);
+        }
+        if (courseCount > 0) {
+            req.course = "K" + std::to_string(courseRng() % courseCount);
+        }
+        req.shareable = unit(courseRng) < config.shareableShare;
+        db.addRequest(req);
+    }
+}
+
+static void benchmarkOrdering(Database& db) {
+    std::cout << "\n[排序策略] 成功率与耗时" << std::endl;
+    std::cout << std::left << std::setw(18) << "策略"
+              << std::right << std::setw(10) << "成功数"
+              << std::setw(12) << "成功率(%)"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority,
+        OrderingStrategy::FewestFeasible,
+        OrderingStrategy::LargestClass,
+        OrderingStrategy::PriorityBands
+    };
+    for (OrderingStrategy strategy : strategies) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setOrderingStrategy(strategy, 200);
+
+        auto start = std::chrono::steady_clock::now();
+        int success = scheduler.generateSchedule();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        auto stats = scheduler.getScheduleStats();
+        std::cout << std::left << std::setw(18) << orderingStrategyName(strategy)
+                  << std::right << std::setw(10) << success
+                  << std::setw(12) << std::fixed << std::setprecision(2) << stats.successRate
+                  << std::setw(12) << ms << std::endl;
+    }
+}
+
+static bool sameSchedules(const std::vector<Schedule>& a, const std::vector<Schedule>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].requestId != b[i].requestId || a[i].labId != b[i].labId ||
+            !(a[i].timeSlot == b[i].timeSlot)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void benchmarkParallel(Database& db) {
+    std::cout << "\n[分区并行] 顺序求解 vs 并行求解" << std::endl;
+    std::cout << std::left << std::setw(18) << "策略"
+              << std::right << std::setw(12) << "顺序(ms)"
+              << std::setw(12) << "并行(ms)"
+              << std::setw(10) << "结果" << std::endl;
+
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority,
+        OrderingStrategy::FewestFeasible
+    };
+    for (OrderingStrategy strategy : strategies) {
+        double ms[2];
+        std::vector<Schedule> results[2];
+        for (int mode = 0; mode < 2; mode++) {
+            Scheduler scheduler(&db);
+            scheduler.setVerbose(false);
+            scheduler.setOrderingStrategy(strategy, 200);
+            scheduler.setParallel(mode == 1);
+
+            auto start = std::chrono::steady_clock::now();
+            scheduler.generateSchedule();
+            auto end = std::chrono::steady_clock::now();
+            ms[mode] = std::chrono::duration<double, std::milli>(end - start).count();
+            results[mode] = db.getAllSchedules();
+        }
+        std::cout << std::left << std::setw(18) << orderingStrategyName(strategy)
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(2) << ms[0]
+                  << std::setw(12) << ms[1]
+                  << std::setw(10) << (sameSchedules(results[0], results[1]) ? "一致" : "不一致")
+                  << std::endl;
+    }
+}
+
+static bool samePlacements(const std::pmr::vector<Placement>& a, const std::pmr::vector<Placement>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].requestIndex != b[i].requestIndex || a[i].labIndex != b[i].labIndex ||
+            a[i].slot != b[i].slot || a[i].preferred != b[i].preferred) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 推测并行: 随机实例上与顺序求解的差分测试, 以及内核耗时与确认阶段占比
+static void benchmarkSpeculative(Database& db, const BenchConfig& base) {
+    std::cout << "\n[推测并行] 与顺序求解的差分测试及内核耗时" << std::endl;
+
+    // 规模、实验室数、设备要求各不相同的随机实例, 逐个比较分配结果
+    int cases = 0;
+    int mismatches = 0;
+    for (unsigned k = 1; k <= 24; k++) {
+        BenchConfig config;
+        config.seed = base.seed + k;
+        config.requestCount = 200 + static_cast<int>(k * 397 % 3000);
+        config.labCount = 5 + static_cast<int>(k * 37 % 120);
+        config.featureShare = k % 3 == 0 ? 0.3 : 0.0;
+        Database caseDb(":memory:");
+        if (!caseDb.initialize()) {
+            return;
+        }
+        populate(caseDb, config);
+
+        std::vector<Laboratory> labs = caseDb.getAllLaboratories();
+        std::vector<LabRequest> requests = caseDb.getAllRequests();
+        OccupancyGrid grid;
+        grid.reset(labs);
+        std::pmr::vector<SlotMask> allowedMasks;
+        buildAllowedMasks(requests, allowedMasks);
+        std::vector<int> all(requests.size());
+        std::iota(all.begin(), all.end(), 0);
+
+        for (OrderingStrategy strategy : {OrderingStrategy::Priority, OrderingStrategy::LargestClass}) {
+            GreedySolver sequential(labs, requests, allowedMasks, grid);
+            sequential.setOrderingStrategy(strategy, 200);
+            std::pmr::vector<Placement> expected;
+            sequential.solve(all, expected);
+            for (int threads : {2, 4, 8}) {
+                ThreadPool pool(threads);
+                GreedySolver speculative(labs, requests, allowedMasks, grid);
+                speculative.setOrderingStrategy(strategy, 200);
+                std::pmr::vector<Placement> placements;
+                speculative.solveSpeculative(all, placements, pool);
+                cases++;
+                if (!samePlacements(expected, placements)) {
+                    mismatches++;
+                    std::cout << "不一致: 种子 " << config.seed << ", 策略 " << orderingStrategyName(strategy)
+                              << ", " << threads << " 个线程" << std::endl;
+                }
+            }
+        }
+    }
+    std::cout << "随机实例差分测试: " << cases << " 组, 不一致 " << mismatches << std::endl;
+
+    // 完整 generateSchedule 写入数据库的课表
+    std::vector<Schedule> results[2];
+    for (int mode = 0; mode < 2; mode++) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setParallel(mode == 1, 4, ParallelMode::Speculative);
+        scheduler.generateSchedule();
+        results[mode] = db.getAllSchedules();
+    }
+    std::cout << "generateSchedule 顺序 vs 推测并行: "
+              << (sameSchedules(results[0], results[1]) ? "一致" : "不一致") << std::endl;
+
+    // 内核耗时; 确认阶段在调用线程中串行执行, 其余为可并行的推测
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+    OccupancyGrid grid;
+    grid.reset(labs);
+    std::pmr::vector<SlotMask> allowedMasks;
+    buildAllowedMasks(requests, allowedMasks);
+    std::vector<int> all(requests.size());
+    std::iota(all.begin(), all.end(), 0);
+
+    std::cout << std::left << std::setw(10) << "线程数"
+              << std::right << std::setw(12) << "求解(ms)"
+              << std::setw(12) << "确认(ms)"
+              << std::setw(12) << "冲突数"
+              << std::setw(14) << "候选实验室"
+              << std::setw(10) << "结果" << std::endl;
+    std::pmr::vector<Placement> expected;
+    for (int threads : {1, 2, 4, 8}) {
+        ThreadPool pool(threads);
+        GreedySolver solver(labs, requests, allowedMasks, grid);
+        std::pmr::vector<Placement> placements;
+        auto start = std::chrono::steady_clock::now();
+        solver.solveSpeculative(all, placements, pool);
+        auto end = std::chrono::steady_clock::now();
+        if (threads == 1) {
+            expected = placements;
+        }
+        std::cout << std::left << std::setw(10) << threads
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double, std::milli>(end - start).count()
+                  << std::setw(12) << solver.counters().confirmNanos / 1e6
+                  << std::setw(12) << solver.counters().speculativeConflicts
+                  << std::setw(14) << solver.counters().labsScanned
+                  << std::setw(10) << (samePlacements(expected, placements) ? "一致" : "不一致") << std::endl;
+    }
+    std::cout << "(1 个线程即顺序求解; 硬件并发数 " << std::thread::hardware_concurrency() << ")" << std::endl;
+}
+
+// 时间段模式与申请分组: 分组后每组共用候选实验室列表, 并从上一个成员的分配位置续扫
+static void benchmarkPatterns(Database& db) {
+    std::cout << "\n[模式分组] 时间段模式表与候选单元分组" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<LabRequest> requests = db.getAllRequests();
+    auto end = std::chrono::steady_clock::now();
+    double loadMillis = std::chrono::duration<double, std::milli>(end - start).count();
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    OccupancyGrid grid;
+    grid.reset(labs);
+
+    start = std::chrono::steady_clock::now();
+    SlotPatternTable patterns;
+    patterns.build(requests);
+    RequestGroups groups;
+    groups.build(requests, patterns, grid);
+    end = std::chrono::steady_clock::now();
+    std::cout << "读取申请 " << std::fixed << std::setprecision(2) << loadMillis << " ms; "
+              << requests.size() << " 个申请, 时间段模式 " << patterns.size()
+              << " 个, 分组 " << groups.size() << " 个, 候选实验室列表 " << groups.candidateListCount()
+              << " 个, 建立耗时 " << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms" << std::endl;
+
+    std::cout << std::left << std::setw(18) << "策略"
+              << std::right << std::setw(12) << "不分组(ms)"
+              << std::setw(12) << "分组(ms)"
+              << std::setw(14) << "候选实验室"
+              << std::setw(14) << "分组后"
+              << std::setw(10) << "结果" << std::endl;
+    std::vector<int> all(requests.size());
+    std::iota(all.begin(), all.end(), 0);
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority,
+        OrderingStrategy::FewestFeasible,
+        OrderingStrategy::LargestClass,
+        OrderingStrategy::PriorityBands
+    };
+    for (OrderingStrategy strategy : strategies) {
+        double ms[2];
+        uint64_t scanned[2];
+        std::pmr::vector<Placement> results[2];
+        for (int grouped = 0; grouped < 2; grouped++) {
+            GreedySolver solver(labs, requests, patterns.allowedMasks(), grid);
+            solver.setOrderingStrategy(strategy, 200);
+            if (grouped) {
+                solver.setRequestGroups(patterns, groups);
+            }
+            start = std::chrono::steady_clock::now();
+            solver.solve(all, results[grouped]);
+            end = std::chrono::steady_clock::now();
+            ms[grouped] = std::chrono::duration<double, std::milli>(end - start).count();
+            scanned[grouped] = solver.counters().labsScanned;
+        }
+        std::cout << std::left << std::setw(18) << orderingStrategyName(strategy)
+                  << std::right << std::setw(12) << ms[0]
+                  << std::setw(12) << ms[1]
+                  << std::setw(14) << scanned[0]
+                  << std::setw(14) << scanned[1]
+                  << std::setw(10) << (samePlacements(results[0], results[1]) ? "一致" : "不一致") << std::endl;
+    }
+}
+
+static void benchmarkFeatures(const BenchConfig& base) {
+    BenchConfig config = base;
+    config.featureShare = 0.3;
+
+    Database db(":memory:");
+    if (!db.initialize()) {
+        return;
+    }
+    populate(db, config);
+
+    std::cout << "\n[设备特性] 30% 的申请需要特定设备, 约 30% 的实验室具备每种设备" << std::endl;
+    std::cout << std::left << std::setw(18) << "策略"
+              << std::right << std::setw(10) << "成功数"
+              << std::setw(12) << "成功率(%)"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority,
+        OrderingStrategy::FewestFeasible
+    };
+    for (OrderingStrategy strategy : strategies) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setOrderingStrategy(strategy);
+
+        auto start = std::chrono::steady_clock::now();
+        int success = scheduler.generateSchedule();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        std::cout << std::left << std::setw(18) << orderingStrategyName(strategy)
+                  << std::right << std::setw(10) << success
+                  << std::setw(12) << std::fixed << std::setprecision(2)
+                  << success * 100.0 / config.requestCount
+                  << std::setw(12) << ms << std::endl;
+    }
+}
+
+// 可行性预检: 实验室充足与紧张时的成功数上界, 以及剪枝对内核扫描量的影响
+static void benchmarkFeasibility(const BenchConfig& base) {
+    std::cout << "\n[可行性预检] 成功数上界(松弛问题最大匹配)与空闲单元计数剪枝" << std::endl;
+    std::cout << std::left << std::setw(10) << "实验室数"
+              << std::right << std::setw(10) << "上界"
+              << std::setw(12) << "无可行单元"
+              << std::setw(12) << "Hall缺口"
+              << std::setw(12) << "预检(ms)"
+              << std::setw(8) << "剪枝"
+              << std::setw(10) << "成功数"
+              << std::setw(10) << "直接跳过"
+              << std::setw(14) << "候选实验室"
+              << std::setw(12) << "求解(ms)" << std::endl;
+
+    const int labCounts[] = {base.labCount, base.labCount / 2, base.labCount / 4};
+    for (int labCount : labCounts) {
+        BenchConfig config = base;
+        config.labCount = labCount;
+        Database db(":memory:");
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, config);
+
+        std::vector<Laboratory> labs = db.getAllLaboratories();
+        std::vector<LabRequest> requests = db.getAllRequests();
+        OccupancyGrid grid;
+        grid.reset(labs);
+        std::pmr::vector<SlotMask> allowedMasks;
+        buildAllowedMasks(requests, allowedMasks);
+        std::vector<int> all(requests.size());
+        std::iota(all.begin(), all.end(), 0);
+
+        auto start = std::chrono::steady_clock::now();
+        FeasibilityReport report = analyzeFeasibility(grid, requests, allowedMasks);
+        auto end = std::chrono::steady_clock::now();
+        double analyzeMillis = std::chrono::duration<double, std::milli>(end - start).count();
+
+        for (bool pruning : {false, true}) {
+            GreedySolver solver(labs, requests, allowedMasks, grid);
+            solver.setPruning(pruning);
+            std::pmr::vector<Placement> placements;
+            start = std::chrono::steady_clock::now();
+            int success = solver.solve(all, placements);
+            end = std::chrono::steady_clock::now();
+
+            std::cout << std::left << std::setw(10) << labCount
+                      << std::right << std::setw(10) << report.maxPlacements
+                      << std::setw(12) << report.unplaceable.size()
+                      << std::setw(12) << report.hallShortfall
+                      << std::setw(12) << std::fixed << std::setprecision(2) << analyzeMillis
+                      << std::setw(8) << (pruning ? "是" : "否")
+                      << std::setw(10) << success
+                      << std::setw(10) << solver.counters().hopelessSkipped
+                      << std::setw(14) << solver.counters().labsScanned
+                      << std::setw(12)
+                      << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+        }
+    }
+}
+
+// 教室共享: 比较成功数、使用的实验室时间段数与座位利用率
+static void benchmarkRoomSharing(const BenchConfig& base) {
+    std::cout << "\n[教室共享] 每门课程约 4 个班级, 30% 的申请允许跨课程共用" << std::endl;
+    std::cout << std::left << std::setw(10) << "实验室数"
+              << std::setw(12) << "模式"
+              << std::right << std::setw(10) << "成功数"
+              << std::setw(12) << "使用单元"
+              << std::setw(12) << "共用班级"
+              << std::setw(14) << "座位利用率(%)"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    // 实验室充足与实验室紧张两种情形
+    const int labCounts[] = {base.labCount, base.labCount * 6 / 10};
+    for (int labCount : labCounts) {
+        BenchConfig config = base;
+        config.labCount = labCount;
+        config.sectionsPerCourse = 4;
+        config.shareableShare = 0.3;
+
+        Database db(":memory:");
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, config);
+
+        std::vector<Laboratory> labs = db.getAllLaboratories();
+        std::vector<LabRequest> requests = db.getAllRequests();
+        std::map<int, int> capacityOf, studentsOf;
+        for (const auto& lab : labs) {
+            capacityOf[lab.id] = lab.capacity;
+        }
+        for (const auto& request : requests) {
+            studentsOf[request.id] = request.studentCount;
+        }
+
+        const RoomSharing modes[] = {RoomSharing::Off, RoomSharing::FirstFit, RoomSharing::BestFit};
+        for (RoomSharing mode : modes) {
+            Scheduler scheduler(&db);
+            scheduler.setVerbose(false);
+            scheduler.setRoomSharing(mode);
+
+            auto start = std::chrono::steady_clock::now();
+            int success = scheduler.generateSchedule();
+            auto end = std::chrono::steady_clock::now();
+
+            // 同一 (实验室, 时间段) 的多个安排只计一次容量
+            std::map<std::tuple<int, int, int, int>, int> cells;
+            long long students = 0;
+            for (const auto& schedule : db.getAllSchedules()) {
+                cells[{schedule.labId, schedule.timeSlot.week, schedule.timeSlot.day,
+                       schedule.timeSlot.period}]++;
+                students += studentsOf[schedule.requestId];
+            }
+            long long seats = 0;
+            int sharedClasses = 0;
+            for (const auto& [cell, count] : cells) {
+                seats += capacityOf[std::get<0>(cell)];
+                if (count > 1) {
+                    sharedClasses += count;
+                }
+            }
+
+            std::cout << std::left << std::setw(10) << labCount
+                      << std::setw(12) << roomSharingName(mode)
+                      << std::right << std::setw(10) << success
+                      << std::setw(12) << cells.size()
+                      << std::setw(12) << sharedClasses
+                      << std::setw(14) << std::fixed << std::setprecision(2)
+                      << (seats > 0 ? students * 100.0 / seats : 0.0)
+                      << std::setw(12)
+                      << std::chrono::duration<double, std::milli>(end - start).count()
+                      << std::endl;
+        }
+    }
+}
+
+// 随时可停求解: 不同时间预算下最优课表的目标函数与改进过程
+static void benchmarkAnytime(const BenchConfig& base) {
+    std::cout << "\n[随时可停求解] 时间预算内不断改进, 保留目标函数最高的完整课表" << std::endl;
+    std::cout << std::left << std::setw(10) << "实验室数"
+              << std::setw(10) << "预算(s)"
+              << std::right << std::setw(10) << "成功数"
+              << std::setw(10) << "期望"
+              << std::setw(10) << "备选"
+              << std::setw(12) << "总分"
+              << std::setw(8) << "轮数"
+              << std::setw(8) << "改进"
+              << std::setw(12) << "最优轮次"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    // 实验室充足与实验室紧张两种情形
+    const int labCounts[] = {base.labCount, base.labCount * 6 / 10};
+    for (int labCount : labCounts) {
+        BenchConfig config = base;
+        config.labCount = labCount;
+        Database db(":memory:");
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, config);
+
+        for (double budget : {0.0, 0.1, 0.5, 2.0}) {
+            Scheduler scheduler(&db);
+            scheduler.setVerbose(false);
+            AnytimeOptions options;
+            options.timeBudget = budget;
+            scheduler.setAnytime(options);
+
+            auto start = std::chrono::steady_clock::now();
+            int success = scheduler.generateSchedule();
+            auto end = std::chrono::steady_clock::now();
+            const ObjectiveScores& scores = scheduler.getScheduleStats().objective;
+            const AnytimeResult& result = scheduler.lastAnytimeResult();
+
+            std::cout << std::left << std::setw(10) << labCount
+                      << std::setw(10) << (budget > 0 ? std::to_string(budget).substr(0, 3) : "-")
+                      << std::right << std::setw(10) << success
+                      << std::setw(10) << scores.preferred
+                      << std::setw(10) << scores.fallback
+                      << std::setw(12) << std::fixed << std::setprecision(1) << scores.total
+                      << std::setw(8) << result.rounds
+                      << std::setw(8) << result.improvements
+                      << std::setw(12) << result.bestRound
+                      << std::setw(12) << std::setprecision(2)
+                      << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+        }
+    }
+}
+
+// 以 baseline 中各申请的安排为准, 统计 schedules 中位置改变或不再有安排的申请数
+static int countChanged(const std::vector<Schedule>& baseline, const std::vector<Schedule>& schedules) {
+    std::map<int, std::tuple<int, int, int, int>> cellOf;
+    for (const auto& schedule : schedules) {
+        cellOf[schedule.requestId] = {schedule.labId, schedule.timeSlot.week, schedule.timeSlot.day,
+                                      schedule.timeSlot.period};
+    }
+    int changed = 0;
+    for (const auto& schedule : baseline) {
+        auto cell = cellOf.find(schedule.requestId);
+        if (cell == cellOf.end() || cell->second != std::make_tuple(schedule.labId, schedule.timeSlot.week,
+                                                                     schedule.timeSlot.day, schedule.timeSlot.period)) {
+            changed++;
+        }
+    }
+    return changed;
+}
+
+// 数据变化后重新生成: 从零求解与粘性重新生成(保留仍然有效的安排)比较调整的班级数、写入行数与耗时
+static void benchmarkSticky(const BenchConfig& base) {
+    std::cout << "\n[粘性重新生成] 相对已公布课表调整的班级数" << std::endl;
+    std::cout << std::left << std::setw(18) << "数据变化"
+              << std::setw(10) << "模式"
+              << std::right << std::setw(10) << "成功数"
+              << std::setw(12) << "调整班级"
+              << std::setw(12) << "写入行数"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    const char* const changes[] = {"不变", "新增5%申请", "删除2个实验室"};
+    for (int change = 0; change < 3; change++) {
+        Database db(":memory:");
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, base);
+        Scheduler published(&db);
+        published.setVerbose(false);
+        published.generateSchedule();
+        std::vector<Schedule> baseline = db.getAllSchedules();
+
+        std::vector<LabRequest> requests = db.getAllRequests();
+        std::vector<Laboratory> labs = db.getAllLaboratories();
+        if (change == 1) {
+            std::mt19937 rng(base.seed + 5);
+            int added = base.requestCount / 20;
+            for (int i = 0; i < added; i++) {
+                LabRequest request = requests[rng() % requests.size()];
+                request.classId = "N" + std::to_string(100000 + i);
+                request.priority = base.requestCount + i;
+                db.addRequest(request);
+            }
+        } else if (change == 2) {
+            db.deleteLaboratory(labs[0].id);
+            db.deleteLaboratory(labs[labs.size() / 2].id);
+        }
+
+        for (bool sticky : {false, true}) {
+            // 每种模式都从同一份已公布课表出发
+            db.clearSchedules();
+            db.addSchedules(baseline);
+            Scheduler scheduler(&db);
+            scheduler.setVerbose(false);
+            scheduler.setStickyRegenerate(sticky);
+
+            auto start = std::chrono::steady_clock::now();
+            int success = scheduler.generateSchedule();
+            auto end = std::chrono::steady_clock::now();
+
+            std::cout << std::left << std::setw(18) << changes[change]
+                      << std::setw(10) << (sticky ? "粘性" : "从零求解")
+                      << std::right << std::setw(10) << success
+                      << std::setw(12) << countChanged(baseline, db.getAllSchedules())
+                      << std::setw(12) << scheduler.lastRunProfile().database.rowsWritten
+                      << std::setw(12) << std::fixed << std::setprecision(2)
+                      << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+        }
+    }
+}
+
+// 抢占: 课表公布后加入紧急申请, 粘性重新生成时不抢占与按不同连锁深度抢占的比较
+static void benchmarkPreemption(const BenchConfig& base) {
+    std::cout << "\n[抢占] 公布课表后加入 5% 紧急申请(priority 0), 粘性重新生成, 优先级类别宽度 100" << std::endl;
+    std::cout << std::left << std::setw(16) << "紧急申请"
+              << std::setw(20) << "模式"
+              << std::right << std::setw(14) << "紧急申请成功"
+              << std::setw(10) << "成功数"
+              << std::setw(12) << "调整班级"
+              << std::setw(10) << "被取代"
+              << std::setw(12) << "未能重分配"
+              << std::setw(10) << "最长连锁"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    const char* const kinds[] = {"随机班级", "大班(>=55人)"};
+    for (int kind = 0; kind < 2; kind++) {
+        Database db(":memory:");
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, base);
+        Scheduler published(&db);
+        published.setVerbose(false);
+        published.generateSchedule();
+        std::vector<Schedule> baseline = db.getAllSchedules();
+
+        // 紧急申请复制已有申请的人数、时间段与设备要求; 大班只能使用少数大实验室, 冲突更多
+        std::vector<LabRequest> requests = db.getAllRequests();
+        std::mt19937 rng(base.seed + 7);
+        int urgentCount = base.requestCount / 20;
+        for (int i = 0; i < urgentCount; i++) {
+            LabRequest request = requests[rng() % requests.size()];
+            while (kind == 1 && request.studentCount < 55) {
+                request = requests[rng() % requests.size()];
+            }
+            request.classId = "U" + std::to_string(100000 + i);
+            request.priority = 0;
+            db.addRequest(request);
+        }
+        std::set<int> urgentIds;
+        for (const auto& request : db.getAllRequests()) {
+            if (request.classId[0] == 'U') {
+                urgentIds.insert(request.id);
+            }
+        }
+
+        for (int depth : {0, 1, 2, 4}) {
+            // 每种模式都从同一份已公布课表出发
+            db.clearSchedules();
+            db.addSchedules(baseline);
+            Scheduler scheduler(&db);
+            scheduler.setVerbose(false);
+            scheduler.setStickyRegenerate(true);
+            PreemptionOptions options;
+            if (depth > 0) {
+                options.classWidth = 100;
+                options.maxDepth = depth;
+            }
+            scheduler.setPreemption(options);
+
+            auto start = std::chrono::steady_clock::now();
+            int success = scheduler.generateSchedule();
+            auto end = std::chrono::steady_clock::now();
+
+            std::vector<Schedule> schedules = db.getAllSchedules();
+            int urgentPlaced = static_cast<int>(std::count_if(schedules.begin(), schedules.end(),
+                [&](const Schedule& schedule) { return urgentIds.count(schedule.requestId) > 0; }));
+            const PreemptionReport& report = scheduler.lastPreemptionReport();
+            std::string mode = depth == 0 ? "不抢占" : "抢占, 深度 " + std::to_string(depth);
+            std::cout << std::left << std::setw(16) << kinds[kind]
+                      << std::setw(20) << mode
+                      << std::right << std::setw(14) << (std::to_string(urgentPlaced) + "/" + std::to_string(urgentCount))
+                      << std::setw(10) << success
+                      << std::setw(12) << countChanged(baseline, schedules)
+                      << std::setw(10) << report.evictions
+                      << std::setw(12) << report.dropped
+                      << std::setw(10) << report.deepest
+                      << std::setw(12) << std::fixed << std::setprecision(2)
+                      << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+        }
+    }
+}
+
+// 实验室维护窗口: 以不可用时间段保存, 与用高优先级的占位申请模拟相比较
+static void benchmarkBlackout(const BenchConfig& base) {
+    std::cout << "\n[不可用时间段] 20% 的实验室各有 6 个维护时间段" << std::endl;
+    std::cout << std::left << std::setw(18) << "表示方式"
+              << std::right << std::setw(10) << "读取申请"
+              << std::setw(10) << "成功数"
+              << std::setw(12) << "调整班级"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    const char* const modes[] = {"无维护", "占位申请", "不可用时间段", "修改+粘性"};
+    for (int mode = 0; mode < 4; mode++) {
+        Database db(":memory:");
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, base);
+        std::vector<Laboratory> labs = db.getAllLaboratories();
+        std::mt19937 rng(base.seed + 6);
+        std::vector<int> slots(kSlotCount);
+        std::iota(slots.begin(), slots.end(), 0);
+
+        std::vector<Schedule> baseline;
+        int fakeCount = 0;
+        for (size_t i = 0; i < labs.size(); i++) {
+            if (rng() % 5 != 0) {
+                continue;
+            }
+            std::shuffle(slots.begin(), slots.end(), rng);
+            if (mode == 1) {
+                // 占位申请: 实验室重新录入并带上专用设备, 每个维护时间段一个只能安排在此的申请
+                std::string tag = "maintenance-" + std::to_string(i);
+                std::vector<std::string> features = labs[i].features;
+                features.push_back(tag);
+                db.deleteLaboratory(labs[i].id);
+                db.addLaboratory(labs[i].location, labs[i].capacity, features);
+                for (int k = 0; k < 6; k++) {
+                    LabRequest fake;
+                    fake.classId = "M" + std::to_string(fakeCount++);
+                    fake.studentCount = 1;
+                    fake.teacher = "维护";
+                    fake.priority = -1;
+                    fake.requiredFeatures = {tag};
+                    fake.preferredSlots = {slotFromIndex(slots[k])};
+                    for (int s = 0; s < kSlotCount; s++) {
+                        if (s != slots[k]) {
+                            fake.excludedSlots.push_back(slotFromIndex(s));
+                        }
+                    }
+                    db.addRequest(fake);
+                }
+            } else if (mode >= 2) {
+                SlotMask blackout = 0;
+                for (int k = 0; k < 6; k++) {
+                    blackout |= slotBit(slots[k]);
+                }
+                db.setLabBlackout(labs[i].id, blackout);
+            }
+        }
+        if (mode == 3) {
+            // 已公布课表后, 第一个实验室第 10 周整周停用
+            Scheduler published(&db);
+            published.setVerbose(false);
+            published.generateSchedule();
+            baseline = db.getAllSchedules();
+            Laboratory lab = db.getLaboratory(labs[0].id);
+            db.setLabBlackout(lab.id, lab.blackout | weekSlots(kFirstWeek + 1));
+        }
+
+        size_t requestCount = db.getAllRequests().size();
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setStickyRegenerate(mode == 3);
+        auto start = std::chrono::steady_clock::now();
+        int success = scheduler.generateSchedule();
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << std::left << std::setw(18) << modes[mode]
+                  << std::right << std::setw(10) << requestCount
+                  << std::setw(10) << success - fakeCount
+                  << std::setw(12) << (mode == 3 ? countChanged(baseline, db.getAllSchedules()) : 0)
+                  << std::setw(12) << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+    }
+}
+
+// 同一教师同一时间段在多个分片中都有课的 (教师, 时间段) 数
+static int countTeacherConflicts(ShardedDatabase& shards) {
+    std::vector<std::map<int, std::string>> teacherOf(shards.shardCount());
+    for (int s = 0; s < shards.shardCount(); s++) {
+        for (const auto& request : shards.shard(s).getAllRequests()) {
+            teacherOf[s].emplace(request.id, request.teacher);
+        }
+    }
+    std::map<std::pair<std::string, int>, std::set<int>> shardsOf;
+    for (const auto& row : shards.getAllSchedules()) {
+        shardsOf[{teacherOf[row.shard][row.schedule.requestId], slotIndex(row.schedule.timeSlot)}].insert(row.shard);
+    }
+    int conflicts = 0;
+    for (const auto& entry : shardsOf) {
+        conflicts += entry.second.size() > 1;
+    }
+    return conflicts;
+}
+
+// 多校区: 实例拆成 4 个校区, 教师编号在各校区之间共享
+static void benchmarkSharding(const BenchConfig& base) {
+    const int kCampuses = 4;
+    std::cout << "\n[多校区] " << kCampuses << " 个校区, 每个校区 " << base.requestCount / kCampuses << " 个申请、"
+              << base.labCount / kCampuses << " 个实验室" << std::endl;
+    std::cout << std::left << std::setw(22) << "方式"
+              << std::right << std::setw(8) << "轮数"
+              << std::setw(10) << "成功数"
+              << std::setw(12) << "教师冲突"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    for (int mode = 0; mode < 3; mode++) {
+        ShardedDatabase shards;
+        for (int s = 0; s < kCampuses; s++) {
+            BenchConfig config = base;
+            config.requestCount = base.requestCount / kCampuses;
+            config.labCount = base.labCount / kCampuses;
+            config.seed = base.seed + s;
+            if (!shards.attach("校区" + std::to_string(s), ":memory:")) {
+                return;
+            }
+            populate(shards.shard(s), config);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int success = 0;
+        int rounds = 1;
+        const char* name;
+        if (mode == 0) {
+            // 各校区独立求解, 不协调教师
+            name = "逐个校区(不协调)";
+            for (int s = 0; s < kCampuses; s++) {
+                Scheduler scheduler(&shards.shard(s));
+                scheduler.setVerbose(false);
+                success += scheduler.generateSchedule();
+            }
+        } else {
+            name = mode == 1 ? "ShardedScheduler 1线程" : "ShardedScheduler 4线程";
+            ShardedScheduler scheduler(&shards);
+            scheduler.setThreadCount(mode == 1 ? 1 : kCampuses);
+            success = scheduler.generateSchedule();
+            rounds = scheduler.lastReport().rounds;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << std::left << std::setw(22) << name
+                  << std::right << std::setw(8) << rounds
+                  << std::setw(10) << success
+                  << std::setw(12) << countTeacherConflicts(shards)
+                  << std::setw(12) << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+
+        if (mode == 2) {
+            // 全局查询: 每位教师在所有校区的课表
+            start = std::chrono::steady_clock::now();
+            size_t rows = 0;
+            int teachers = base.requestCount / kCampuses / 8 + 1;
+            for (int t = 0; t < teachers; t++) {
+                rows += shards.getSchedulesByTeacher("T" + std::to_string(t)).size();
+            }
+            end = std::chrono::steady_clock::now();
+            std::cout << "按教师查询全部校区: " << teachers << " 位教师, " << rows << " 节, "
+                      << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+        }
+    }
+}
+
+// 按教师统计期望时间段满足比例: 最小值、平均值与 Jain 公平指数 (Σx)² / (n·Σx²)
+static void benchmarkFairness(Database& db) {
+    std::cout << "\n[公平性] 各教师期望时间段满足比例(在期望时间段分配的申请 / 申请数)" << std::endl;
+    std::cout << std::left << std::setw(18) << "策略"
+              << std::right << std::setw(10) << "成功数"
+              << std::setw(10) << "期望数"
+              << std::setw(12) << "最低比例"
+              << std::setw(12) << "平均比例"
+              << std::setw(12) << "Jain指数"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+
+    std::vector<LabRequest> requests = db.getAllRequests();
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority,
+        OrderingStrategy::FewestFeasible,
+        OrderingStrategy::FairShare
+    };
+    for (OrderingStrategy strategy : strategies) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setOrderingStrategy(strategy, 200);
+
+        auto start = std::chrono::steady_clock::now();
+        int success = scheduler.generateSchedule();
+        auto end = std::chrono::steady_clock::now();
+
+        std::map<int, TimeSlot> slotOf;
+        for (const auto& schedule : db.getAllSchedules()) {
+            slotOf[schedule.requestId] = schedule.timeSlot;
+        }
+        std::map<std::string, std::pair<int, int>> teachers;  // 教师 -> (期望时间段分配数, 申请数)
+        int preferred = 0;
+        for (const auto& request : requests) {
+            auto& counts = teachers[request.teacher];
+            counts.second++;
+            auto it = slotOf.find(request.id);
+            if (it != slotOf.end() &&
+                std::find(request.preferredSlots.begin(), request.preferredSlots.end(), it->second) !=
+                    request.preferredSlots.end()) {
+                counts.first++;
+                preferred++;
+            }
+        }
+        double minRatio = 1.0, sum = 0, sumSquares = 0;
+        for (const auto& entry : teachers) {
+            double ratio = static_cast<double>(entry.second.first) / entry.second.second;
+            minRatio = std::min(minRatio, ratio);
+            sum += ratio;
+            sumSquares += ratio * ratio;
+        }
+        double jain = sumSquares > 0 ? sum * sum / (teachers.size() * sumSquares) : 1.0;
+
+        std::cout << std::left << std::setw(18) << orderingStrategyName(strategy)
+                  << std::right << std::setw(10) << success
+                  << std::setw(10) << preferred
+                  << std::setw(12) << std::fixed << std::setprecision(3) << minRatio
+                  << std::setw(12) << sum / teachers.size()
+                  << std::setw(12) << jain
+                  << std::setw(12) << std::setprecision(2)
+                  << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+    }
+}
+
+// 课表查询: 每次查询都访问数据库(原查询页的做法) 与 查询缓存 对比
+static void benchmarkQueryCache(Database& db) {
+    std::cout << "\n[查询缓存] 按实验室与按班级各查询一遍全部课表" << std::endl;
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    scheduler.generateSchedule();
+
+    std::vector<int> labIds;
+    for (const auto& lab : db.getAllLaboratories()) {
+        labIds.push_back(lab.id);
+    }
+    std::set<std::string> classIds;
+    for (const auto& request : db.getAllRequests()) {
+        classIds.insert(request.classId);
+    }
+    int lookups = static_cast<int>(labIds.size() + classIds.size());
+
+    std::cout << std::left << std::setw(22) << "方式"
+              << std::right << std::setw(10) << "查询数"
+              << std::setw(10) << "课程数"
+              << std::setw(12) << "耗时(ms)"
+              << std::setw(14) << "每次(us)" << std::endl;
+    auto report = [lookups](const char* label, size_t rows, double millis) {
+        std::cout << std::left << std::setw(22) << label
+                  << std::right << std::setw(10) << lookups
+                  << std::setw(10) << rows
+                  << std::setw(12) << std::fixed << std::setprecision(2) << millis
+                  << std::setw(14) << millis * 1000 / lookups << std::endl;
+    };
+
+    // 每行再按 id 读取申请与实验室, 与原查询页相同
+    auto start = std::chrono::steady_clock::now();
+    size_t rows = 0;
+    for (int labId : labIds) {
+        for (const auto& schedule : db.getSchedulesByLab(labId)) {
+            db.getRequest(schedule.requestId);
+            db.getLaboratory(schedule.labId);
+            rows++;
+        }
+    }
+    for (const auto& classId : classIds) {
+        for (const auto& schedule : db.getSchedulesByClass(classId)) {
+            db.getRequest(schedule.requestId);
+            db.getLaboratory(schedule.labId);
+            rows++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    report("数据库", rows, std::chrono::duration<double, std::milli>(end - start).count());
+
+    TimetableCache cache(&db);
+    start = std::chrono::steady_clock::now();
+    auto timetable = cache.snapshot();
+    end = std::chrono::steady_clock::now();
+    double buildMillis = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    rows = 0;
+    for (int labId : labIds) {
+        rows += cache.snapshot()->byLab(labId).size();
+    }
+    for (const auto& classId : classIds) {
+        rows += cache.snapshot()->byClass(classId).size();
+    }
+    end = std::chrono::steady_clock::now();
+    report("缓存", rows, std::chrono::duration<double, std::milli>(end - start).count());
+
+    // 多个读者同时查询同一快照
+    const int readers = 4;
+    std::vector<size_t> readerRows(readers, 0);
+    start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int reader = 0; reader < readers; reader++) {
+        threads.emplace_back([&, reader] {
+            for (int labId : labIds) {
+                readerRows[reader] += cache.snapshot()->byLab(labId).size();
+            }
+            for (const auto& classId : classIds) {
+                readerRows[reader] += cache.snapshot()->byClass(classId).size();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    end = std::chrono::steady_clock::now();
+    bool consistent = std::all_of(readerRows.begin(), readerRows.end(),
+                                  [rows](size_t count) { return count == rows; });
+    report("缓存(4个读者)", rows, std::chrono::duration<double, std::milli>(end - start).count());
+
+    // 重新生成课表后版本号变化, 下一次查询重建快照
+    scheduler.generateSchedule();
+    cache.snapshot();
+    std::cout << "建立快照 " << std::setprecision(2) << buildMillis << " ms, 课表版本 "
+              << timetable->version() << " -> " << cache.snapshot()->version()
+              << ", 重建次数 " << cache.rebuildCount()
+              << ", 并发读取结果" << (consistent ? "一致" : "不一致!") << std::endl;
+}
+
+// 压力测试: 写线程反复生成课表(清空后整批写入), 同时多个读线程查询课表
+// 每次读到的课表行数应为 0(刚清空)或完整的一批, 出现其他值说明读到了未提交的部分写入
+// 批量导出: 课表只读取一次, 各格式在不同线程数下渲染全部实验室与班级课表
+static void benchmarkTimetableExport(Database& db) {
+    std::cout << "\n[课表导出] 全部实验室与班级课表写入临时目录" << std::endl;
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    scheduler.generateSchedule();
+
+    auto start = std::chrono::steady_clock::now();
+    TimetableCache cache(&db);
+    auto snapshot = cache.snapshot();
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "读取课表 " << snapshot->size() << " 节(一次顺序读取): " << std::fixed << std::setprecision(2)
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "lab_schedule_export_bench";
+    std::cout << std::left << std::setw(12) << "格式"
+              << std::right << std::setw(8) << "线程"
+              << std::setw(10) << "文件数"
+              << std::setw(12) << "大小(KB)"
+              << std::setw(12) << "耗时(ms)" << std::endl;
+    for (TimetableFormat format : {TimetableFormat::Html, TimetableFormat::Markdown, TimetableFormat::ICalendar}) {
+        for (int threads : {1, 4}) {
+            std::filesystem::remove_all(dir);
+            TimetableExportOptions options;
+            options.format = format;
+            options.outputDir = dir.string();
+            options.threadCount = threads;
+            TimetableExportReport report;
+            bool ok = exportTimetables(*snapshot, labs, options, report);
+            std::cout << std::left << std::setw(12) << timetableFormatName(format)
+                      << std::right << std::setw(8) << threads
+                      << std::setw(10) << report.labFiles + report.classFiles
+                      << std::setw(12) << report.bytes / 1024
+                      << std::setw(12) << report.seconds * 1000
+                      << (ok ? "" : "  (有文件写入失败)") << std::endl;
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+static void benchmarkConnectionPool(const BenchConfig& config) {
+    std::cout << "\n[连接池] 写线程生成课表 5 次, 4 个读线程同时查询(数据库文件, WAL)" << std::endl;
+    const std::string path = "benchmark_pool.db";
+    auto removeFiles = [&path] {
+        for (const char* suffix : {"", "-wal", "-shm"}) {
+            std::remove((path + suffix).c_str());
+        }
+    };
+    removeFiles();
+    {
+        Database db(path, 1);
+        if (!db.initialize()) {
+            return;
+        }
+        populate(db, config);
+    }
+
+    std::cout << std::left << std::setw(16) << "模式"
+              << std::right << std::setw(12) << "读查询数"
+              << std::setw(14) << "读查询/秒"
+              << std::setw(12) << "写失败"
+              << std::setw(14) << "写耗时(ms)" << std::endl;
+
+    const int readerThreads = 4;
+    const int writes = 5;
+    for (int readerConnections : {0, readerThreads}) {
+        Database db(path, readerConnections);
+        if (!db.initialize()) {
+            break;
+        }
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        size_t batch = static_cast<size_t>(scheduler.generateSchedule());
+        std::vector<int> labIds;
+        for (const auto& lab : db.getAllLaboratories()) {
+            labIds.push_back(lab.id);
+        }
+
+        std::atomic<bool> writing{true};
+        std::atomic<long long> queries{0};
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int reader = 0; reader < readerThreads; reader++) {
+            threads.emplace_back([&, reader] {
+                size_t next = reader;
+                while (writing.load(std::memory_order_relaxed)) {
+                    db.getAllSchedules();
+                    db.getSchedulesByLab(labIds[next++ % labIds.size()]);
+                    queries += 2;
+                }
+            });
+        }
+        int failed = 0;
+        for (int i = 0; i < writes; i++) {
+            if (static_cast<size_t>(scheduler.generateSchedule()) != batch) {
+                failed++;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        writing = false;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        double millis = std::chrono::duration<double, std::milli>(end - start).count();
+        std::string label = readerConnections == 0 ? "单连接" : "连接池(" + std::to_string(readerConnections) + "读)";
+        std::cout << std::left << std::setw(16) << label
+                  << std::right << std::setw(12) << queries.load()
+                  << std::setw(14) << std::fixed << std::setprecision(0) << queries.load() * 1000.0 / millis
+                  << std::setw(12) << failed
+                  << std::setw(14) << std::setprecision(2) << millis << std::endl;
+    }
+    removeFiles();
+}
+
+// 用同一目标函数(见 objective.h)比较不同的分配引擎配置
+static void benchmarkObjective(const BenchConfig& base) {
+    BenchConfig config = base;
+    config.sectionsPerCourse = 4;
+    config.shareableShare = 0.3;
+    Database db(":memory:");
+    if (!db.initialize()) {
+        return;
+    }
+    populate(db, config);
+
+    std::cout << "\n[目标函数] 各分配引擎配置的目标函数分量(默认权重)" << std::endl;
+    std::cout << std::left << std::setw(30) << "引擎"
+              << std::right << std::setw(8) << "分配"
+              << std::setw(8) << "期望"
+              << std::setw(8) << "备选"
+              << std::setw(10) << "空置座位"
+              << std::setw(8) << "换楼"
+              << std::setw(10) << "日均衡"
+              << std::setw(12) << "总分" << std::endl;
+
+    struct Engine {
+        OrderingStrategy ordering;
+        RoomSharing sharing;
+    };
+    const Engine engines[] = {
+        {OrderingStrategy::Priority, RoomSharing::Off},
+        {OrderingStrategy::FewestFeasible, RoomSharing::Off},
+        {OrderingStrategy::LargestClass, RoomSharing::Off},
+        {OrderingStrategy::PriorityBands, RoomSharing::Off},
+        {OrderingStrategy::Priority, RoomSharing::BestFit},
+        {OrderingStrategy::FewestFeasible, RoomSharing::BestFit}
+    };
+    for (const Engine& engine : engines) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setOrderingStrategy(engine.ordering, 200);
+        scheduler.setRoomSharing(engine.sharing);
+        scheduler.generateSchedule();
+        ObjectiveScores scores = scheduler.getScheduleStats().objective;
+
+        std::string label = std::string(orderingStrategyName(engine.ordering)) + " / " +
+                            roomSharingName(engine.sharing);
+        std::cout << std::left << std::setw(30) << label
+                  << std::right << std::setw(8) << scores.placed
+                  << std::setw(8) << scores.preferred
+                  << std::setw(8) << scores.fallback
+                  << std::setw(10) << scores.wastedSeats
+                  << std::setw(8) << scores.teacherTravel
+                  << std::setw(10) << scores.daySpread
+                  << std::setw(12) << std::fixed << std::setprecision(1) << scores.total << std::endl;
+    }
+}
+
+// 一次 generateSchedule 的阶段耗时与计数器(见 instrumentation.h)
+static void benchmarkPhases(Database& db) {
+    std::cout << "\n[阶段剖析] 各阶段耗时(ms)与计数器" << std::endl;
+    const Phase phases[] = {
+        Phase::Clear, Phase::Load, Phase::Prepare, Phase::Partition, Phase::Solve,
+        Phase::Preferred, Phase::Fallback, Phase::Report, Phase::Persist
+    };
+    std::cout << std::left << std::setw(16) << "模式";
+    for (Phase phase : phases) {
+        std::cout << std::right << std::setw(11) << phaseName(phase);
+    }
+    std::cout << std::setw(11) << "total" << std::endl;
+
+    // 分阶段计时关闭时 preferred/fallback 为 0, 对比 solve 列可看出逐申请读时钟的开销
+    struct Mode {
+        const char* name;
+        bool parallel;
+        bool phaseTiming;
+    };
+    const Mode modes[] = {{"顺序", false, false}, {"顺序 分阶段", false, true}, {"并行 分阶段", true, true}};
+    for (const Mode& mode : modes) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setParallel(mode.parallel);
+        scheduler.setPhaseTiming(mode.phaseTiming);
+        scheduler.generateSchedule();
+        const RunProfile& profile = scheduler.lastRunProfile();
+
+        std::cout << std::left << std::setw(16) << mode.name
+                  << std::right << std::fixed << std::setprecision(2);
+        for (Phase phase : phases) {
+            std::cout << std::setw(11) << profile.phaseMillis(phase);
+        }
+        std::cout << std::setw(11) << profile.totalMillis() << std::endl;
+
+        std::cout << "  申请 " << profile.solver.requests
+                  << ", 候选实验室 " << profile.solver.labsScanned
+                  << ", 位测试 " << profile.solver.bitTests
+                  << ", 期望/备选 " << profile.solver.preferredPlacements
+                  << "/" << profile.solver.fallbackPlacements
+                  << "; 数据库语句 " << profile.database.statements
+                  << ", 读 " << profile.database.rowsRead
+                  << " 行, 写 " << profile.database.rowsWritten << " 行" << std::endl;
+    }
+}
+
+// 直接调用分配内核, 分别使用单次运行的内存区域与全局堆, 统计求解过程中的全局堆分配
+static void benchmarkAllocations(Database& db) {
+    std::cout << "\n[内存分配] 分配内核求解过程中的全局堆分配" << std::endl;
+    std::cout << std::left << std::setw(26) << "策略"
+              << std::right << std::setw(14) << "全局堆(次)"
+              << std::setw(14) << "内存区域(次)"
+              << std::setw(12) << "耗时(ms)"
+              << std::setw(14) << "区域用量(KB)" << std::endl;
+
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+    OccupancyGrid grid;
+    grid.reset(labs);
+    std::vector<SlotMask> allowedMasks;
+    for (const auto& request : requests) {
+        allowedMasks.push_back(kAllSlots & ~toSlotMask(request.excludedSlots));
+    }
+    std::vector<int> all(requests.size());
+    std::iota(all.begin(), all.end(), 0);
+
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority,
+        OrderingStrategy::FewestFeasible,
+        OrderingStrategy::PriorityBands
+    };
+    for (OrderingStrategy strategy : strategies) {
+        for (int mode = 0; mode < 2; mode++) {
+            bool useArena = mode == 0;
+            size_t arenaBytes = RunArena::estimateBytes(labs.size(), requests.size());
+            RunArena arena(arenaBytes);
+            CountingResource heap;
+            std::pmr::memory_resource* resource = useArena ? arena.resource() : &heap;
+
+            size_t before = globalAllocationCount();
+            auto start = std::chrono::steady_clock::now();
+            {
+                GreedySolver solver(labs, requests, allowedMasks, grid, resource);
+                solver.setOrderingStrategy(strategy, 200);
+                std::pmr::vector<Placement> placements(resource);
+                solver.solve(all, placements);
+            }
+            auto end = std::chrono::steady_clock::now();
+            size_t globalCount = globalAllocationCount() - before;
+
+            std::string label = std::string(orderingStrategyName(strategy)) +
+                                (useArena ? " (arena)" : " (heap)");
+            std::cout << std::left << std::setw(26) << label
+                      << std::right << std::setw(14) << globalCount
+                      << std::setw(14) << (useArena ? arena.overflowCount() : heap.allocationCount())
+                      << std::setw(12) << std::fixed << std::setprecision(2)
+                      << std::chrono::duration<double, std::milli>(end - start).count()
+                      << std::setw(14) << (useArena ? arenaBytes + arena.overflowBytes()
+                                                    : heap.bytesAllocated()) / 1024
+                      << std::endl;
+        }
+    }
+
+    // 完整的 generateSchedule 还包括数据库读写与日志输出, 其中的分配来自 SQLite 与字符串
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    size_t before = globalAllocationCount();
+    size_t beforeBytes = globalAllocatedBytes();
+    scheduler.generateSchedule();
+    std::cout << "完整 generateSchedule: 全局堆分配 " << globalAllocationCount() - before
+              << " 次, " << (globalAllocatedBytes() - beforeBytes) / 1024 << " KB" << std::endl;
+}
+
+// 名称驻留: 读取全部申请时复制名称字符串与只读名称编号的耗时与全局堆分配
+static void benchmarkInterning(Database& db, const BenchConfig& config) {
+    std::cout << "\n[名称驻留] 读取全部申请: 复制名称 vs 只读名称编号" << std::endl;
+
+    // 真实数据中的班级、教师与课程名称较长, 超出 std::string 的短字符串缓冲
+    Database longDb(":memory:");
+    if (!longDb.initialize()) {
+        return;
+    }
+    for (LabRequest request : db.getAllRequests()) {
+        request.classId = "计算机科学与技术" + request.classId + "班";
+        request.teacher = "信息工程学院教师" + request.teacher;
+        request.course = "数据结构与算法课程设计" + std::to_string(request.priority % (config.requestCount / 30 + 1));
+        longDb.addRequest(request);
+    }
+
+    std::cout << std::left << std::setw(24) << "数据"
+              << std::right << std::setw(14) << "复制(ms)"
+              << std::setw(14) << "编号(ms)"
+              << std::setw(16) << "复制(次/KB)"
+              << std::setw(16) << "编号(次/KB)"
+              << std::setw(14) << "驻留表(KB)" << std::endl;
+    auto run = [](const char* label, Database& source) {
+        source.getAllRequests(false);  // 预热: 登记全部名称, 之后的读取只查找
+        double millis[2];
+        size_t counts[2];
+        size_t bytes[2];
+        for (int mode = 0; mode < 2; mode++) {
+            bool copyNames = mode == 0;
+            millis[mode] = 1e9;
+            for (int repeat = 0; repeat < 10; repeat++) {
+                size_t before = globalAllocationCount();
+                size_t beforeBytes = globalAllocatedBytes();
+                auto start = std::chrono::steady_clock::now();
+                std::vector<LabRequest> requests = source.getAllRequests(copyNames);
+                auto end = std::chrono::steady_clock::now();
+                counts[mode] = globalAllocationCount() - before;
+                bytes[mode] = globalAllocatedBytes() - beforeBytes;
+                millis[mode] = std::min(millis[mode], std::chrono::duration<double, std::milli>(end - start).count());
+            }
+        }
+        std::cout << std::left << std::setw(24) << label
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(14) << millis[0] << std::setw(14) << millis[1]
+                  << std::setw(16) << (std::to_string(counts[0]) + "/" + std::to_string(bytes[0] / 1024))
+                  << std::setw(16) << (std::to_string(counts[1]) + "/" + std::to_string(bytes[1] / 1024))
+                  << std::setw(14) << source.names().bytes() / 1024 << std::endl;
+    };
+    run("短名称(基准数据)", db);
+    run("长名称", longDb);
+}
+
+// 同一问题: 完整的 generateSchedule(读取、求解、写入数据库) vs 只调用调度内核求解
+static void benchmarkCore(Database& db) {
+    std::cout << "\n[调度内核] generateSchedule vs CoreScheduler::solve(同一问题, 取 5 次中最快)" << std::endl;
+    std::cout << std::left << std::setw(12) << "模式"
+              << std::right << std::setw(20) << "generateSchedule(ms)"
+              << std::setw(14) << "读取(ms)"
+              << std::setw(14) << "内核(ms)"
+              << std::setw(14) << "内核占比"
+              << std::setw(8) << "一致" << std::endl;
+
+    for (int mode = 0; mode < 3; mode++) {
+        bool parallel = mode == 1;
+        bool sticky = mode == 2;
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setParallel(parallel);
+        scheduler.generateSchedule();  // 粘性模式从上一次的课表出发
+        scheduler.setStickyRegenerate(sticky);
+        double full = 1e9;
+        for (int repeat = 0; repeat < 5; repeat++) {
+            auto start = std::chrono::steady_clock::now();
+            scheduler.generateSchedule();
+            full = std::min(full, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        SchedulingProblem problem;
+        double load = 1e9;
+        for (int repeat = 0; repeat < 5; repeat++) {
+            auto start = std::chrono::steady_clock::now();
+            problem.labs = db.getAllLaboratories();
+            problem.requests = db.getAllRequests(false);
+            problem.previous = sticky ? db.getAllSchedules() : std::vector<Schedule>();
+            load = std::min(load, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        CoreScheduler core;
+        core.setParallel(parallel);
+        core.setStickyRegenerate(sticky);
+        SchedulingResult result;
+        double solve = 1e9;
+        for (int repeat = 0; repeat < 5; repeat++) {
+            auto start = std::chrono::steady_clock::now();
+            result = core.solve(problem);
+            solve = std::min(solve, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        // 数据库按时间段返回课表, 两边都按申请 id 排序后比较
+        std::vector<Schedule> solved;
+        for (const auto& placement : result.placements) {
+            solved.push_back({0, problem.requests[placement.requestIndex].id, problem.labs[placement.labIndex].id,
+                              slotFromIndex(placement.slot)});
+        }
+        std::vector<Schedule> stored = db.getAllSchedules();
+        auto byRequest = [](const Schedule& a, const Schedule& b) { return a.requestId < b.requestId; };
+        std::sort(solved.begin(), solved.end(), byRequest);
+        std::sort(stored.begin(), stored.end(), byRequest);
+        std::cout << std::left << std::setw(12) << (sticky ? "粘性" : parallel ? "分区并行" : "顺序")
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(20) << full << std::setw(14) << load << std::setw(14) << solve
+                  << std::setw(13) << std::setprecision(1) << solve * 100 / full << "%"
+                  << std::setw(8) << (sameSchedules(stored, solved) ? "是" : "否") << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    if (argc > 1) config.requestCount = std::atoi(argv[1]);
+    if (argc > 2) config.labCount = std::atoi(argv[2]);
+    if (argc > 3) config.seed = static_cast<unsigned>(std::atoi(argv[3]));
+    if (argc > 4) config.weekLocal = std::string(argv[4]) == "week";
+
+    std::cout << "=== 实验室安排系统 - 基准测试 ===" << std::endl;
+    std::cout << "申请数量: " << config.requestCount
+              << ", 实验室数量: " << config.labCount
+              << ", 随机种子: " << config.seed << std::endl;
+
+    Database db(":memory:");
+    if (!db.initialize()) {
+        std::cerr << "数据库初始化失败!" << std::endl;
+        return 1;
+    }
+    populate(db, config);
+
+    benchmarkOrdering(db);
+    benchmarkParallel(db);
+    benchmarkSpeculative(db, config);
+    benchmarkPatterns(db);
+    benchmarkFeatures(config);
+    benchmarkFeasibility(config);
+    benchmarkRoomSharing(config);
+    benchmarkFairness(db);
+    benchmarkSticky(config);
+    benchmarkPreemption(config);
+    benchmarkBlackout(config);
+    benchmarkSharding(config);
+    benchmarkAnytime(config);
+    benchmarkQueryCache(db);
+    benchmarkInterning(db, config);
+    benchmarkTimetableExport(db);
+    benchmarkConnectionPool(config);
+    benchmarkObjective(config);
+    benchmarkPhases(db);
+    benchmarkCore(db);
+    benchmarkAllocations(db);
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include "bulk_io.h"
+#include "csv.h"
+#include "occupancy.h"
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// 最多在标准错误输出中逐行报告的错误数
+static const long long kMaxReportedErrors = 20;
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+static bool parseInt(std::string_view text, int& value) {
+    text = trim(text);
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+static bool parseBool(std::string_view text) {
+    text = trim(text);
+    return text == "1" || text == "true" || text == "True" || text == "TRUE" || text == "yes" || text == "y";
+}
+
+// 表头列名 -> 列下标, 缺失的列为 -1
+struct ColumnMap {
+    std::vector<int> indices;
+
+    ColumnMap(const std::vector<std::string_view>& header,
+              std::initializer_list<std::string_view> names) {
+        for (std::string_view name : names) {
+            int index = -1;
+            for (size_t i = 0; i < header.size(); i++) {
+                if (trim(header[i]) == name) {
+                    index = static_cast<int>(i);
+                    break;
+                }
+            }
+            indices.push_back(index);
+        }
+    }
+
+    std::string_view get(const std::vector<std::string_view>& fields, int column) const {
+        int index = indices[column];
+        return index >= 0 && index < static_cast<int>(fields.size()) ? fields[index] : std::string_view();
+    }
+};
+
+static void reportError(ImportReport& report, long long line, const char* message) {
+    report.rejected++;
+    if (report.rejected <= kMaxReportedErrors) {
+        std::cerr << "第 " << line << " 行: " << message << ", 已跳过" << std::endl;
+    }
+}
+
+static void finishReport(ImportReport& report, std::chrono::steady_clock::time_point start) {
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (report.rejected > kMaxReportedErrors) {
+        std::cerr << "另有 " << report.rejected - kMaxReportedErrors << " 行校验失败未逐行列出" << std::endl;
+    }
+}
+
+bool validateSlotList(std::string_view text, int& count) {
+    count = 0;
+    text = trim(text);
+    while (!text.empty()) {
+        size_t stop = text.find(';');
+        std::string_view item = text.substr(0, stop);
+        text = stop == std::string_view::npos ? std::string_view() : text.substr(stop + 1);
+
+        int values[3];
+        for (int k = 0; k < 3; k++) {
+            size_t comma = k < 2 ? item.find(',') : item.size();
+            if (comma == std::string_view::npos || !parseInt(item.substr(0, comma), values[k])) {
+                return false;
+            }
+            item = k < 2 ? item.substr(comma + 1) : std::string_view();
+        }
+        if (slotIndex(TimeSlot{values[0], values[1], values[2]}) < 0) {
+            return false;  // 不在日历范围内
+        }
+        count++;
+    }
+    return true;
+}
+
+bool importLaboratoriesCsv(Database& db, const std::string& path, ImportReport& report) {
+    report = ImportReport();
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    if (file.size() == 0) {
+        std::cerr << "文件为空: " << path << std::endl;
+        return false;
+    }
+    return importLaboratoriesBuffer(db, file.data(), file.size(), delimiterForPath(path), report);
+}
+
+bool importLaboratoriesBuffer(Database& db, char* data, size_t size, char delimiter, ImportReport& report) {
+    report = ImportReport();
+    CsvReader reader(data, size, delimiter);
+    std::vector<std::string_view> fields;
+    if (!reader.nextRow(fields)) {
+        std::cerr << "输入中没有表头" << std::endl;
+        return false;
+    }
+
+    enum { Location, Capacity, Features, Blackout };
+    ColumnMap columns(fields, {"location", "capacity", "features", "blackout_slots"});
+    if (columns.indices[Location] < 0 || columns.indices[Capacity] < 0) {
+        std::cerr << "表头缺少必需的列 location / capacity" << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long long inserted = db.addLaboratoryRows([&](LaboratoryRow& row) {
+        while (reader.nextRow(fields)) {
+            report.rows++;
+            row.location = trim(columns.get(fields, Location));
+            row.features = trim(columns.get(fields, Features));
+            std::string_view blackout = trim(columns.get(fields, Blackout));
+            int blackoutCount = 0;
+            if (row.location.empty()) {
+                reportError(report, reader.lineNumber(), "实验室地址为空");
+            } else if (!parseInt(columns.get(fields, Capacity), row.capacity) || row.capacity <= 0) {
+                reportError(report, reader.lineNumber(), "容纳人数无效");
+            } else if (!validateSlotList(blackout, blackoutCount)) {
+                reportError(report, reader.lineNumber(), "不可用时间段格式错误或超出日历范围");
+            } else {
+                row.blackout = blackoutCount > 0
+                                   ? toSlotMask(Database::deserializeTimeSlots(std::string(blackout)))
+                                   : SlotMask(0);
+                return true;
+            }
+        }
+        return false;
+    });
+    finishReport(report, start);
+
+    if (inserted < 0) {
+        return false;
+    }
+    report.inserted = inserted;
+    return true;
+}
+
+bool importRequestsCsv(Database& db, const std::string& path, ImportReport& report) {
+    report = ImportReport();
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    if (file.size() == 0) {
+        std::cerr << "文件为空: " << path << std::endl;
+        return false;
+    }
+    return importRequestsBuffer(db, file.data(), file.size(), delimiterForPath(path), report);
+}
+
+bool importRequestsBuffer(Database& db, char* data, size_t size, char delimiter, ImportReport& report) {
+    report = ImportReport();
+    CsvReader reader(data, size, delimiter);
+    std::vector<std::string_view> fields;
+    if (!reader.nextRow(fields)) {
+        std::cerr << "输入中没有表头" << std::endl;
+        return false;
+    }
+
+    enum { ClassId, StudentCount, Teacher, Preferred, Excluded, Priority, Features, Course, Shareable };
+    ColumnMap columns(fields, {"class_id", "student_count", "teacher", "preferred_slots",
+                               "excluded_slots", "priority", "required_features", "course",
+                               "shareable"});
+    if (columns.indices[ClassId] < 0 || columns.indices[StudentCount] < 0 ||
+        columns.indices[Teacher] < 0 || columns.indices[Preferred] < 0) {
+        std::cerr << "表头缺少必需的列 class_id / student_count / teacher / preferred_slots" << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long long inserted = db.addRequestRows([&](RequestRow& row) {
+        while (reader.nextRow(fields)) {
+            report.rows++;
+            row.classId = trim(columns.get(fields, ClassId));
+            row.teacher = trim(columns.get(fields, Teacher));
+            row.preferredSlots = trim(columns.get(fields, Preferred));
+            row.excludedSlots = trim(columns.get(fields, Excluded));
+            row.requiredFeatures = trim(columns.get(fields, Features));
+            row.course = trim(columns.get(fields, Course));
+            row.shareable = parseBool(columns.get(fields, Shareable));
+
+            int preferredCount = 0;
+            int excludedCount = 0;
+            std::string_view priority = trim(columns.get(fields, Priority));
+            if (row.classId.empty() || row.teacher.empty()) {
+                reportError(report, reader.lineNumber(), "班级ID或教师为空");
+            } else if (!parseInt(columns.get(fields, StudentCount), row.studentCount) ||
+                       row.studentCount <= 0) {
+                reportError(report, reader.lineNumber(), "学生人数无效");
+            } else if (!validateSlotList(row.preferredSlots, preferredCount) || preferredCount == 0) {
+                reportError(report, reader.lineNumber(), "期望时间段无效或为空");
+            } else if (!validateSlotList(row.excludedSlots, excludedCount)) {
+                reportError(report, reader.lineNumber(), "不可用时间段无效");
+            } else if (priority.empty()) {
+                row.priority = static_cast<int>(report.rows);
+                return true;
+            } else if (!parseInt(priority, row.priority)) {
+                reportError(report, reader.lineNumber(), "优先级无效");
+            } else {
+                return true;
+            }
+        }
+        return false;
+    });
+    finishReport(report, start);
+
+    if (inserted < 0) {
+        return false;
+    }
+    report.inserted = inserted;
+    return true;
+}
+
+bool exportSchedulesCsv(Database& db, const std::string& path, long long& rows) {
+    rows = 0;
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "无法创建文件: " << path << std::endl;
+        return false;
+    }
+
+    bool ok;
+    {
+        CsvWriter writer(file, delimiterForPath(path));
+        writer.field("week");
+        writer.field("day");
+        writer.field("period");
+        writer.field("location");
+        writer.field("capacity");
+        writer.field("class_id");
+        writer.field("teacher");
+        writer.field("student_count");
+        writer.endRow();
+
+        ok = db.exportSchedules([&](const ScheduleExportRow& row) {
+            writer.field(row.timeSlot.week);
+            writer.field(row.timeSlot.day);
+            writer.field(row.timeSlot.period);
+            writer.field(row.location);
+            writer.field(row.capacity);
+            writer.field(row.classId);
+            writer.field(row.teacher);
+            writer.field(row.studentCount);
+            writer.endRow();
+            rows++;
+        });
+        ok = writer.flush() && ok;
+    }
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,59 @@
+#ifndef BULK_IO_H
+#define BULK_IO_H
+
+#include "database.h"
+#include <string>
+#include <string_view>
+
+// 批量导入的统计结果
+struct ImportReport {
+    long long rows = 0;      // 数据行数(不含表头)
+    long long inserted = 0;  // 成功插入的行数
+    long long rejected = 0;  // 校验失败被跳过的行数
+    double seconds = 0;      // 解析与写入的总耗时
+};
+
+/**
+ * @brief 从 CSV/TSV 文件批量导入实验室
+ *
+ * 首行为表头, 按列名取值: location, capacity 必需; features 可选(逗号分隔的设备名称),
+ * blackout_slots 可选(不可用时间段, 格式与申请的时间段字段相同)。
+ * 文件以内存映射方式读取, 字段不复制直接绑定到预编译语句(见 Database::addLaboratoryRows)。
+ * 校验失败的行被跳过并在标准错误输出中报告行号。
+ *
+ * @return 文件能打开且表头完整、数据库写入成功时返回 true
+ */
+bool importLaboratoriesCsv(Database& db, const std::string& path, ImportReport& report);
+
+/**
+ * @brief 从 CSV/TSV 文件批量导入实验申请
+ *
+ * 列: class_id, student_count, teacher, preferred_slots 必需;
+ * excluded_slots, priority(缺省为行号), required_features, course, shareable 可选。
+ * 时间段字段格式与数据库相同("week,day,period;..."), 每个时间段必须在日历范围内,
+ * 期望时间段不能为空(与界面录入的要求一致)。
+ */
+bool importRequestsCsv(Database& db, const std::string& path, ImportReport& report);
+
+/**
+ * @brief 与 importLaboratoriesCsv / importRequestsCsv 相同, 输入为内存中的 CSV/TSV 文本
+ *
+ * CsvReader 会在缓冲区中原地去除引号转义, 因此缓冲区必须可写。
+ * 文件版本先映射文件再调用这两个函数; 测试与模糊测试直接使用它们。
+ */
+bool importLaboratoriesBuffer(Database& db, char* data, size_t size, char delimiter, ImportReport& report);
+bool importRequestsBuffer(Database& db, char* data, size_t size, char delimiter, ImportReport& report);
+
+/**
+ * @brief 将课表流式导出为 CSV/TSV 文件(按文件扩展名选择分隔符)
+ * @param rows 输出导出的行数
+ */
+bool exportSchedulesCsv(Database& db, const std::string& path, long long& rows);
+
+/**
+ * @brief 校验时间段列表("week,day,period;...", 可为空)且每个时间段都在日历范围内
+ * @param count 输出时间段数量
+ */
+bool validateSlotList(std::string_view text, int& count);
+
+#endif // BULK_IO_H
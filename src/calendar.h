@@ -0,0 +1,191 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <array>
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <type_traits>
+
+// 时间槽定义 (周次, 星期, 时段: 0-上午, 1-下午)
+struct TimeSlot {
+    int week;      // 周次 (9 或 10)
+    int day;       // 星期 (0-4 对应周一到周五)
+    int period;    // 时段 (0-上午, 1-下午)
+    
+    constexpr bool operator==(const TimeSlot& other) const {
+        return week == other.week && day == other.day && period == other.period;
+    }
+    
+    constexpr bool operator<(const TimeSlot& other) const {
+        if (week != other.week) return week < other.week;
+        if (day != other.day) return day < other.day;
+        return period < other.period;
+    }
+};
+
+/**
+ * @brief 超过 64 个时间槽的日历使用的定长位图(若干个 64 位字)
+ *
+ * 提供与整数位图相同的位运算, 以便占用表、排序队列等代码不区分位图宽度。
+ */
+template <int Slots>
+struct WideSlotMask {
+    static constexpr int kWords = (Slots + 63) / 64;
+    std::array<uint64_t, kWords> words{};
+
+    constexpr WideSlotMask() = default;
+    constexpr WideSlotMask(uint64_t low) { words[0] = low; }  // 与整数位图一样可由 0 或单个字构造
+
+    constexpr WideSlotMask operator&(const WideSlotMask& other) const {
+        WideSlotMask result;
+        for (int i = 0; i < kWords; i++) result.words[i] = words[i] & other.words[i];
+        return result;
+    }
+    constexpr WideSlotMask operator|(const WideSlotMask& other) const {
+        WideSlotMask result;
+        for (int i = 0; i < kWords; i++) result.words[i] = words[i] | other.words[i];
+        return result;
+    }
+    constexpr WideSlotMask operator~() const {
+        WideSlotMask result;
+        for (int i = 0; i < kWords; i++) result.words[i] = ~words[i];
+        return result;
+    }
+    constexpr WideSlotMask& operator&=(const WideSlotMask& other) { return *this = *this & other; }
+    constexpr WideSlotMask& operator|=(const WideSlotMask& other) { return *this = *this | other; }
+
+    constexpr explicit operator bool() const {
+        for (uint64_t word : words) {
+            if (word) return true;
+        }
+        return false;
+    }
+
+    constexpr auto operator<=>(const WideSlotMask& other) const = default;
+};
+
+/**
+ * @brief 能容纳 Slots 个时间槽的最窄位图类型:
+ *        不超过 32 个为 uint32_t, 不超过 64 个为 uint64_t, 否则为 WideSlotMask
+ */
+template <int Slots>
+using SlotWord = std::conditional_t<(Slots <= 32), uint32_t,
+                 std::conditional_t<(Slots <= 64), uint64_t, WideSlotMask<Slots>>>;
+
+// 位图操作: 整数位图直接对应一条位运算指令, 定长位图逐字处理
+
+template <class Mask>
+constexpr Mask singleSlot(int index) {
+    if constexpr (std::is_integral_v<Mask>) {
+        return Mask(1) << index;
+    } else {
+        Mask mask;
+        mask.words[index / 64] = uint64_t(1) << (index % 64);
+        return mask;
+    }
+}
+
+template <class Mask>
+constexpr bool hasSlot(const Mask& mask, int index) {
+    if constexpr (std::is_integral_v<Mask>) {
+        return (mask >> index) & 1;
+    } else {
+        return (mask.words[index / 64] >> (index % 64)) & 1;
+    }
+}
+
+template <class Mask>
+constexpr int slotCount(const Mask& mask) {
+    if constexpr (std::is_integral_v<Mask>) {
+        return std::popcount(mask);
+    } else {
+        int count = 0;
+        for (uint64_t word : mask.words) count += std::popcount(word);
+        return count;
+    }
+}
+
+/**
+ * @brief 编号最小的时间槽(mask 不能为空)
+ */
+template <class Mask>
+constexpr int lowestSlot(const Mask& mask) {
+    if constexpr (std::is_integral_v<Mask>) {
+        return std::countr_zero(mask);
+    } else {
+        int i = 0;
+        while (!mask.words[i]) i++;
+        return i * 64 + std::countr_zero(mask.words[i]);
+    }
+}
+
+/**
+ * @brief 去掉编号最小的时间槽
+ */
+template <class Mask>
+constexpr void clearLowestSlot(Mask& mask) {
+    if constexpr (std::is_integral_v<Mask>) {
+        mask &= mask - 1;
+    } else {
+        int i = 0;
+        while (!mask.words[i]) i++;
+        mask.words[i] &= mask.words[i] - 1;
+    }
+}
+
+/**
+ * @brief 日历形状: 从第 FirstWeek 周起共 Weeks 周, 每周 Days 天, 每天 Periods 个时段
+ *
+ * 时间槽编号与位图类型都在编译期确定, 编码/解码均为 constexpr,
+ * 小日历的位图为单个机器字, 各处按位图遍历的循环不含跨字处理。
+ */
+template <int FirstWeek, int Weeks, int Days, int Periods>
+struct CalendarShape {
+    static constexpr int kFirstWeek = FirstWeek;
+    static constexpr int kWeekCount = Weeks;
+    static constexpr int kDaysPerWeek = Days;
+    static constexpr int kPeriodsPerDay = Periods;
+    static constexpr int kSlotCount = Weeks * Days * Periods;
+
+    using Mask = SlotWord<kSlotCount>;
+
+    /**
+     * @brief 时间槽编号: ((week - FirstWeek) × Days + day) × Periods + period
+     * @return 编号(0..kSlotCount-1), 不在日历范围内时返回 -1
+     */
+    static constexpr int index(const TimeSlot& slot) {
+        int week = slot.week - FirstWeek;
+        if (week < 0 || week >= Weeks ||
+            slot.day < 0 || slot.day >= Days ||
+            slot.period < 0 || slot.period >= Periods) {
+            return -1;
+        }
+        return (week * Days + slot.day) * Periods + slot.period;
+    }
+
+    static constexpr TimeSlot slot(int index) {
+        return {FirstWeek + index / (Periods * Days), (index / Periods) % Days, index % Periods};
+    }
+
+    static constexpr Mask allSlots() {
+        if constexpr (std::is_integral_v<Mask>) {
+            return kSlotCount == 64 ? ~Mask(0) : (Mask(1) << kSlotCount) - 1;
+        } else {
+            Mask mask;
+            for (int i = 0; i < kSlotCount; i++) mask |= singleSlot<Mask>(i);
+            return mask;
+        }
+    }
+};
+
+// 本系统使用的日历: 第9周和第10周, 每周5天(周一到周五), 每天2个时段(上午/下午)
+using Calendar = CalendarShape<9, 2, 5, 2>;
+
+static_assert(std::is_same_v<Calendar::Mask, uint32_t>, "20 个时间槽应使用单个 32 位字");
+static_assert(Calendar::index(Calendar::slot(Calendar::kSlotCount - 1)) == Calendar::kSlotCount - 1);
+static_assert(Calendar::index({10, 4, 1}) == 19 && Calendar::index({11, 0, 0}) == -1);
+static_assert(CalendarShape<1, 18, 6, 5>::kSlotCount == 540 &&
+              CalendarShape<1, 18, 6, 5>::Mask::kWords == 9);
+
+#endif // CALENDAR_H
@@ -0,0 +1,388 @@
+#include "core_scheduler.h"
+#include "arena.h"
+#include "partition.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
+void prepareProblem(SchedulingProblem& problem, StringInterner& names, FeatureRegistry& features) {
+    for (auto& lab : problem.labs) {
+        lab.featureMask = features.intern(lab.features);
+        lab.locationName = names.intern(lab.location);
+    }
+    for (auto& request : problem.requests) {
+        request.requiredMask = features.intern(request.requiredFeatures);
+        request.className = names.intern(request.classId);
+        request.teacherName = names.intern(request.teacher);
+        request.courseName = names.intern(request.course);
+    }
+    std::stable_sort(problem.requests.begin(), problem.requests.end(),
+                     [](const LabRequest& a, const LabRequest& b) { return a.priority < b.priority; });
+}
+
+void CoreScheduler::setOrderingStrategy(OrderingStrategy strategy, int bandWidth) {
+    ordering = strategy;
+    this->bandWidth = bandWidth;
+}
+
+void CoreScheduler::setParallel(bool enabled, int threadCount, ParallelMode mode) {
+    parallel = enabled;
+    this->threadCount = threadCount;
+    parallelMode = mode;
+}
+
+std::pmr::vector<Placement> CoreScheduler::solvePartitioned(const SchedulingProblem& problem,
+                                                            const OccupancyGrid& occupancy,
+                                                            const SlotPatternTable& patterns,
+                                                            const RequestGroups& requestGroups,
+                                                            std::span<const CourseKey> courseKeys,
+                                                            RunProfile& profile, SchedulingResult& result,
+                                                            std::pmr::memory_resource* resource) {
+    const std::vector<Laboratory>& labs = problem.labs;
+    const std::vector<LabRequest>& requests = problem.requests;
+    std::span<const SlotMask> allowedMasks = patterns.allowedMasks();
+    std::pmr::vector<Placement> placements(resource);
+    std::pmr::vector<std::pmr::vector<int>> components(resource);
+    {
+        ScopedPhase phase(profile, Phase::Partition);
+        components = partitionRequests(requests, allowedMasks, occupancy, resource);
+    }
+
+    if (components.size() <= 1) {
+        GreedySolver solver(labs, requests, allowedMasks, occupancy, resource);
+        solver.setOrderingStrategy(ordering, bandWidth);
+        solver.setRoomSharing(sharing, courseKeys);
+        solver.setRequestGroups(patterns, requestGroups);
+        solver.setPhaseTiming(timing);
+        for (const auto& component : components) {
+            solver.solve(component, placements);
+        }
+        profile.solver.add(solver.counters());
+        return placements;
+    }
+
+    // 大分量先提交以均衡负载; 小分量合并成批, 减少任务调度开销
+    std::pmr::vector<int> bySize(components.size(), resource);
+    std::iota(bySize.begin(), bySize.end(), 0);
+    std::sort(bySize.begin(), bySize.end(), [&components](int a, int b) {
+        if (components[a].size() != components[b].size()) {
+            return components[a].size() > components[b].size();
+        }
+        return a < b;
+    });
+
+    const size_t kMinBatchRequests = 256;
+    std::pmr::vector<std::pmr::vector<int>> batches(resource);
+    size_t batchRequests = 0;
+    for (int c : bySize) {
+        if (batches.empty() || batchRequests >= kMinBatchRequests) {
+            batches.emplace_back();
+            batchRequests = 0;
+        }
+        batches.back().push_back(c);
+        batchRequests += components[c].size();
+    }
+
+    // 每个工作线程持有自己的内存区域、分配内核、结果列表与跟踪事件,
+    // 求解完一个分量后撤销其占用以复用内核
+    struct WorkerState {
+        RunArena arena;
+        GreedySolver solver;
+        std::pmr::vector<Placement> placements;
+        std::pmr::vector<TraceEvent> events;
+
+        WorkerState(size_t arenaBytes, const std::vector<Laboratory>& labs,
+                    const std::vector<LabRequest>& requests,
+                    std::span<const SlotMask> allowedMasks, const OccupancyGrid& grid)
+            : arena(arenaBytes),
+              solver(labs, requests, allowedMasks, grid, arena.resource()),
+              placements(arena.resource()),
+              events(arena.resource()) {}
+    };
+
+    ThreadPool pool(threadCount);
+    std::vector<std::unique_ptr<WorkerState>> workers(pool.size());
+    size_t arenaBytes = RunArena::estimateBytes(labs.size(), requests.size());
+    result.components = static_cast<int>(components.size());
+    result.largestComponent = static_cast<int>(components[bySize[0]].size());
+    result.threads = pool.size();
+
+    for (const auto& batch : batches) {
+        pool.submit([&](int worker) {
+            if (!workers[worker]) {
+                workers[worker] = std::make_unique<WorkerState>(arenaBytes, labs, requests,
+                                                                allowedMasks, occupancy);
+                workers[worker]->solver.setOrderingStrategy(ordering, bandWidth);
+                workers[worker]->solver.setRoomSharing(sharing, courseKeys);
+                workers[worker]->solver.setRequestGroups(patterns, requestGroups);
+                workers[worker]->solver.setPhaseTiming(timing);
+            }
+            WorkerState& state = *workers[worker];
+            int64_t start = profile.elapsed();
+            for (int c : batch) {
+                size_t from = state.placements.size();
+                state.solver.solve(components[c], state.placements);
+                state.solver.release(state.placements, from);
+            }
+            state.events.push_back({"batch", worker + 1, start, profile.elapsed() - start});
+        });
+    }
+    pool.wait();
+
+    placements.reserve(requests.size());
+    for (const auto& state : workers) {
+        if (state) {
+            placements.insert(placements.end(), state->placements.begin(), state->placements.end());
+            profile.solver.add(state->solver.counters());
+            for (const auto& event : state->events) {
+                profile.addEvent(event);
+            }
+        }
+    }
+    return placements;
+}
+
+std::pmr::vector<Placement> CoreScheduler::solveSpeculative(const SchedulingProblem& problem,
+                                                            const OccupancyGrid& occupancy,
+                                                            const SlotPatternTable& patterns,
+                                                            const RequestGroups& requestGroups,
+                                                            std::span<const CourseKey> courseKeys,
+                                                            RunProfile& profile, SchedulingResult& result,
+                                                            std::pmr::memory_resource* resource) {
+    std::pmr::vector<Placement> placements(resource);
+    std::pmr::vector<int> all(problem.requests.size(), resource);
+    std::iota(all.begin(), all.end(), 0);
+
+    ThreadPool pool(threadCount);
+    GreedySolver solver(problem.labs, problem.requests, patterns.allowedMasks(), occupancy, resource);
+    solver.setOrderingStrategy(ordering, bandWidth);
+    solver.setRoomSharing(sharing, courseKeys);
+    solver.setRequestGroups(patterns, requestGroups);
+    solver.setPhaseTiming(timing);
+    solver.solveSpeculative(all, placements, pool);
+    profile.solver.add(solver.counters());
+    result.threads = pool.size();
+    return placements;
+}
+
+SchedulingResult CoreScheduler::solve(const SchedulingProblem& problem, RunProfile* runProfile) {
+    // 不记录剖析数据时计入一个临时对象
+    RunProfile scratch;
+    if (!runProfile) {
+        scratch.start();
+    }
+    RunProfile& profile = runProfile ? *runProfile : scratch;
+    const std::vector<Laboratory>& labs = problem.labs;
+    const std::vector<LabRequest>& requests = problem.requests;
+
+    SchedulingResult result;
+    result.regenerate.sticky = sticky;
+    result.regenerate.previous = sticky ? static_cast<int>(problem.previous.size()) : 0;
+    result.kept.assign(requests.size(), 0);
+    if (labs.empty() || requests.empty()) {
+        // 没有可分配的申请: 上一次的安排全部失效
+        if (sticky) {
+            for (const auto& schedule : problem.previous) {
+                result.removedIds.push_back(schedule.id);
+            }
+        }
+        return result;
+    }
+
+    // 本次运行的临时数据都放在同一个内存区域中, 函数返回时一次性释放
+    RunArena arena(RunArena::estimateBytes(labs.size(), requests.size()));
+    std::pmr::memory_resource* resource = arena.resource();
+
+    // 申请已按 priority 排序, 再由排序策略决定处理顺序
+    std::optional<ScopedPhase> prepare(std::in_place, profile, Phase::Prepare);
+    OccupancyGrid occupancy(resource);
+    occupancy.reset(labs);
+    occupancy.setSeatMode(sharing != RoomSharing::Off);
+    // 相同期望/排除时间段的申请共用一个模式, 候选单元相同的申请归为一组
+    SlotPatternTable patterns(resource);
+    patterns.build(requests);
+    std::span<const SlotMask> allowedMasks = patterns.allowedMasks();
+    RequestGroups requestGroups(resource);
+    requestGroups.build(requests, patterns, occupancy);
+    result.patterns = patterns.size();
+    result.requestGroups = requestGroups.size();
+
+    // 教室共享模式下为课程编号, 同一课程的班级可以共用实验室
+    std::pmr::vector<CourseKey> courseKeys(resource);
+    if (sharing != RoomSharing::Off) {
+        buildCourseKeys(requests, courseKeys);
+    }
+
+    // 可行性预检: 教室共享模式下一个单元可容纳多个班级, 按单元计算的供需不适用
+    if (sharing == RoomSharing::Off) {
+        result.feasibility = analyzeFeasibility(occupancy, requests, allowedMasks);
+    }
+    prepare.reset();
+
+    // 粘性模式: 按处理顺序保留上一次仍然有效的安排, 其余申请在剩余单元中重新求解
+    // 旧安排所属的申请或实验室已不存在、或同一申请有多行时, 多余的行直接删除
+    std::pmr::vector<int> remaining(resource);
+    std::pmr::vector<Placement> kept(resource);
+    std::vector<char>& isKept = result.kept;
+    std::pmr::vector<int> previousId(requests.size(), -1, resource);  // 申请下标 -> 旧安排的 id
+    std::pmr::vector<int> previousLab(requests.size(), -1, resource);
+    std::pmr::vector<int> previousSlot(requests.size(), -1, resource);
+    std::vector<int>& removedIds = result.removedIds;
+    OccupancyGrid seeded(occupancy, resource);
+    if (sticky) {
+        ScopedPhase phase(profile, Phase::WarmStart);
+        std::unordered_map<int, int> requestIndex;
+        std::unordered_map<int, int> labIndex;
+        for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+            requestIndex.emplace(requests[i].id, i);
+        }
+        for (int i = 0; i < static_cast<int>(labs.size()); i++) {
+            labIndex.emplace(labs[i].id, i);
+        }
+        for (const auto& schedule : problem.previous) {
+            auto request = requestIndex.find(schedule.requestId);
+            if (request == requestIndex.end() || previousId[request->second] >= 0) {
+                removedIds.push_back(schedule.id);
+                continue;
+            }
+            auto lab = labIndex.find(schedule.labId);
+            previousId[request->second] = schedule.id;
+            previousLab[request->second] = lab != labIndex.end() ? lab->second : -1;
+            previousSlot[request->second] = slotIndex(schedule.timeSlot);
+        }
+
+        for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+            const LabRequest& request = requests[i];
+            int lab = previousLab[i];
+            int slot = previousSlot[i];
+            bool valid = lab >= 0 && slot >= 0 && hasSlot(allowedMasks[i], slot) &&
+                         labs[lab].capacity >= request.studentCount &&
+                         seeded.hasFeatures(lab, request.requiredMask);
+            bool shared = false;
+            if (valid && sharing != RoomSharing::Off) {
+                shared = !seeded.isFree(lab, slot);
+                valid = !shared || seeded.canJoin(lab, slot, request.studentCount, courseKeys[i], request.shareable);
+            } else if (valid) {
+                valid = seeded.isFree(lab, slot);
+            }
+            if (!valid) {
+                if (previousId[i] >= 0) {
+                    removedIds.push_back(previousId[i]);
+                }
+                remaining.push_back(i);
+                continue;
+            }
+            if (sharing != RoomSharing::Off) {
+                seeded.occupySeats(lab, slot, request.studentCount, courseKeys[i], request.shareable);
+            } else {
+                seeded.occupy(lab, slot);
+            }
+            bool preferred = !hasSlot(patterns.fallback(patterns.patternOf(i)), slot);
+            kept.push_back({i, lab, slot, preferred, shared});
+            isKept[i] = 1;
+        }
+    } else {
+        remaining.resize(requests.size());
+        std::iota(remaining.begin(), remaining.end(), 0);
+    }
+
+    // 对每个申请进行分配
+    std::pmr::vector<Placement> placements(resource);
+    {
+        ScopedPhase phase(profile, Phase::Solve);
+        if (parallel && !sticky && !anytime.enabled() && ordering != OrderingStrategy::FairShare) {
+            placements = parallelMode == ParallelMode::Speculative
+                             ? solveSpeculative(problem, occupancy, patterns, requestGroups, courseKeys,
+                                                profile, result, resource)
+                             : solvePartitioned(problem, occupancy, patterns, requestGroups, courseKeys,
+                                                profile, result, resource);
+        } else {
+            std::pmr::vector<int> groups(resource);
+            if (ordering == OrderingStrategy::FairShare) {
+                buildFairnessGroups(requests, fairness, groups);
+            }
+            // 粘性模式从保留安排之后的占用出发
+            const OccupancyGrid& initial = sticky ? seeded : occupancy;
+            if (anytime.enabled()) {
+                AnytimeSolver solver(labs, requests, allowedMasks, initial, resource);
+                solver.setOrderingStrategy(ordering, bandWidth);
+                solver.setRoomSharing(sharing, courseKeys);
+                solver.setFairnessGroups(groups);
+                solver.setRequestGroups(patterns, requestGroups);
+                solver.setPhaseTiming(timing);
+                solver.setObjectiveWeights(weights);
+                solver.setFixedPlacements(kept);
+                result.anytime = solver.solve(remaining, placements, anytime);
+                profile.solver.add(solver.counters());
+            } else {
+                GreedySolver solver(labs, requests, allowedMasks, initial, resource);
+                solver.setOrderingStrategy(ordering, bandWidth);
+                solver.setRoomSharing(sharing, courseKeys);
+                solver.setFairnessGroups(groups);
+                solver.setRequestGroups(patterns, requestGroups);
+                solver.setPhaseTiming(timing);
+                solver.solve(remaining, placements);
+                profile.solver.add(solver.counters());
+            }
+        }
+        placements.insert(placements.end(), kept.begin(), kept.end());
+    }
+
+    // 抢占: 未分配的申请取代优先级类别更低的安排(教室共享模式下一个单元可有多个班级, 不进行)
+    if (preemption.enabled() && sharing == RoomSharing::Off) {
+        ScopedPhase phase(profile, Phase::Preempt);
+        std::pmr::vector<char> placed(requests.size(), 0, resource);
+        for (const auto& placement : placements) {
+            placed[placement.requestIndex] = 1;
+        }
+        std::pmr::vector<int> failed(resource);
+        for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+            if (!placed[i]) {
+                failed.push_back(i);
+            }
+        }
+        PreemptionSolver solver(labs, requests, patterns, occupancy, resource);
+        result.preemption = solver.solve(failed, placements, preemption);
+        result.evictions.assign(solver.evictions().begin(), solver.evictions().end());
+
+        // 粘性模式下被取代的保留安排不再保留: 删除旧安排, 新位置(若有)重新保存
+        for (const auto& eviction : result.evictions) {
+            if (isKept[eviction.victim]) {
+                isKept[eviction.victim] = 0;
+                removedIds.push_back(previousId[eviction.victim]);
+            }
+        }
+    }
+
+    // 按申请顺序合并结果, 保证顺序求解与并行求解的输出完全一致
+    ScopedPhase report(profile, Phase::Report);
+    std::sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+        return a.requestIndex < b.requestIndex;
+    });
+    ScheduleEvaluator evaluator(labs, requests, weights);
+    RegenerateReport& regenerate = result.regenerate;
+    size_t next = 0;
+    for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+        if (next < placements.size() && placements[next].requestIndex == i) {
+            const Placement& placement = placements[next++];
+            evaluator.place(i, placement.labIndex, placement.slot);
+            if (previousId[i] < 0) {
+                regenerate.added++;
+            } else if (previousLab[i] == placement.labIndex && previousSlot[i] == placement.slot) {
+                regenerate.kept++;
+            } else {
+                regenerate.moved++;
+                result.changed.push_back(i);
+            }
+        } else if (previousId[i] >= 0) {
+            regenerate.dropped++;
+            result.changed.push_back(i);
+        }
+    }
+    result.objective = evaluator.scores();
+    result.placements.assign(placements.begin(), placements.end());
+    return result;
+}
@@ -0,0 +1,186 @@
+#ifndef CORE_SCHEDULER_H
+#define CORE_SCHEDULER_H
+
+#include "anytime.h"
+#include "feasibility.h"
+#include "instrumentation.h"
+#include "lab_features.h"
+#include "lab_types.h"
+#include "objective.h"
+#include "occupancy.h"
+#include "preemption.h"
+#include "request_order.h"
+#include "slot_pattern.h"
+#include "solver.h"
+#include "string_interner.h"
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 并行求解方式
+ */
+enum class ParallelMode {
+    Partitioned,  // 划分互不影响的申请分量, 各分量独立求解(见 partition.h)
+    Speculative   // 按窗口并行推测分配位置, 再按处理顺序确认(见 GreedySolver::solveSpeculative)
+};
+
+/**
+ * @brief 一次重新生成相对上一次课表的变化
+ *
+ * 申请按其上一次的安排归类: 位置不变计入 kept, 换了实验室或时间段计入 moved,
+ * 原有安排而本次未能分配计入 dropped, 原来没有安排而本次分配成功计入 added。
+ */
+struct RegenerateReport {
+    bool sticky = false;   // 本次是否使用粘性重新生成
+    int previous = 0;      // 生成前的课程安排数
+    int kept = 0;
+    int moved = 0;
+    int dropped = 0;
+    int added = 0;
+    std::vector<std::string> changedClasses;  // 被调整或取消安排的班级(按处理顺序, 由 Scheduler 按名称填写)
+};
+
+/**
+ * @brief 一次求解的输入, 与存储方式无关
+ *
+ * 实验室与申请以其在列表中的下标标识。求解只使用名称编号与设备特性位图, 不读取名称字符串:
+ * 从数据库读取的问题已经登记好(见 Database::names), 直接构造的问题先调用 prepareProblem。
+ */
+struct SchedulingProblem {
+    std::vector<Laboratory> labs;
+    std::vector<LabRequest> requests;  // 按 priority 升序
+    std::vector<Schedule> previous;    // 上一次的课程安排, 以 requestId/labId 引用上面的 id(只在粘性模式下使用)
+};
+
+/**
+ * @brief 为直接构造的问题登记名称编号与设备特性位图, 并把申请按 priority 稳定排序
+ *
+ * 同一个问题的实验室与申请须使用同一个 names 与 features; 求解结束后两者不再被引用。
+ */
+void prepareProblem(SchedulingProblem& problem, StringInterner& names, FeatureRegistry& features);
+
+/**
+ * @brief 一次求解的输出(下标对应 SchedulingProblem 的 labs/requests)
+ */
+struct SchedulingResult {
+    std::vector<Placement> placements;  // 分配成功的申请, 按申请下标升序
+    std::vector<char> kept;             // 申请下标 -> 是否原样保留了上一次的安排(粘性模式), 保留的安排无需重新保存
+    std::vector<int> removedIds;        // 上一次的安排中须删除的 id(粘性模式): 失效、重复或被抢占的安排
+    std::vector<int> changed;           // 被调整或取消安排的申请下标(按处理顺序)
+    std::vector<Eviction> evictions;    // 抢占中的各次取代(按发生顺序)
+    int patterns = 0;                   // 时间段模式数
+    int requestGroups = 0;              // 候选单元相同的申请分组数
+    int components = 0;                 // 分区并行时的独立分量数(未分区时为 0)
+    int largestComponent = 0;           // 其中最大分量的申请数
+    int threads = 0;                    // 并行求解的工作线程数(顺序求解时为 0)
+    FeasibilityReport feasibility;
+    ObjectiveScores objective;
+    RegenerateReport regenerate;        // changedClasses 为空, 需要名称时按 changed 取得
+    AnytimeResult anytime;              // 未启用随时可停求解时为默认值
+    PreemptionReport preemption;        // 未启用抢占时为默认值
+
+    int placed() const { return static_cast<int>(placements.size()); }
+};
+
+/**
+ * @brief 调度内核: 输入实验室与申请, 输出分配结果
+ *
+ * 包含全部求解逻辑(处理顺序策略、并行求解、可行性预检、粘性重新生成、随时可停求解与抢占),
+ * 求解期间不读写任何存储、不输出日志, 也不依赖 SQLite 与 Qt(labsched_core 库)。
+ * Scheduler 是基于数据库的适配器: 读取问题、调用 solve、写回结果并输出日志;
+ * 其他后端直接构造 SchedulingProblem 即可使用, 结果与 Scheduler 写入数据库的课表相同。
+ * 一个对象同一时间只能在一个线程中 solve, 不同对象互不影响。
+ */
+class CoreScheduler {
+public:
+    /**
+     * @brief 设置申请处理顺序策略
+     * @param bandWidth PriorityBands 策略下每个优先级分段的宽度
+     */
+    void setOrderingStrategy(OrderingStrategy strategy, int bandWidth = 10);
+
+    /**
+     * @brief FairShare 策略下的分组方式(默认按教师); FairShare 策略总是顺序求解
+     */
+    void setFairnessGroup(FairnessGroup group) { fairness = group; }
+
+    /**
+     * @brief 是否启用并行求解(见 Scheduler::setParallel)
+     * @param threadCount 工作线程数, <= 0 时使用硬件并发数
+     */
+    void setParallel(bool enabled, int threadCount = 0, ParallelMode mode = ParallelMode::Partitioned);
+
+    void setRoomSharing(RoomSharing mode) { sharing = mode; }
+
+    /**
+     * @brief 是否从 SchedulingProblem::previous 出发粘性重新生成(见 Scheduler::setStickyRegenerate)
+     */
+    void setStickyRegenerate(bool enabled) { sticky = enabled; }
+
+    void setAnytime(const AnytimeOptions& options) { anytime = options; }
+    void setPreemption(const PreemptionOptions& options) { preemption = options; }
+    void setObjectiveWeights(const ObjectiveWeights& weights) { this->weights = weights; }
+
+    /**
+     * @brief 是否分别统计期望/备选时间段阶段的耗时(见 GreedySolver::setPhaseTiming), 默认关闭
+     */
+    void setPhaseTiming(bool enabled) { timing = enabled; }
+
+    OrderingStrategy orderingStrategy() const { return ordering; }
+    FairnessGroup fairnessGroup() const { return fairness; }
+    RoomSharing roomSharing() const { return sharing; }
+    bool stickyRegenerate() const { return sticky; }
+    bool phaseTiming() const { return timing; }
+    const AnytimeOptions& anytimeOptions() const { return anytime; }
+    const PreemptionOptions& preemptionOptions() const { return preemption; }
+    const ObjectiveWeights& objectiveWeights() const { return weights; }
+
+    /**
+     * @brief 求解一个问题
+     * @param profile 记录各阶段耗时、内核计数器与跟踪事件(须已 start), 为空时不记录
+     */
+    SchedulingResult solve(const SchedulingProblem& problem, RunProfile* profile = nullptr);
+
+private:
+    OrderingStrategy ordering = OrderingStrategy::Priority;
+    int bandWidth = 10;
+    bool parallel = false;
+    int threadCount = 0;
+    ParallelMode parallelMode = ParallelMode::Partitioned;
+    RoomSharing sharing = RoomSharing::Off;
+    FairnessGroup fairness = FairnessGroup::Teacher;
+    bool sticky = false;
+    bool timing = false;
+    AnytimeOptions anytime;
+    PreemptionOptions preemption;
+    ObjectiveWeights weights;
+
+    /**
+     * @brief 划分独立分量并在线程池中并行求解
+     * @param resource 本次运行的内存区域(仅由调用线程使用, 工作线程各有自己的内存区域)
+     * @return 所有分量的分配结果(未排序)
+     */
+    std::pmr::vector<Placement> solvePartitioned(const SchedulingProblem& problem,
+                                                 const OccupancyGrid& occupancy,
+                                                 const SlotPatternTable& patterns,
+                                                 const RequestGroups& requestGroups,
+                                                 std::span<const CourseKey> courseKeys,
+                                                 RunProfile& profile, SchedulingResult& result,
+                                                 std::pmr::memory_resource* resource);
+
+    /**
+     * @brief 推测并行求解(见 GreedySolver::solveSpeculative)
+     * @return 分配结果(按处理顺序)
+     */
+    std::pmr::vector<Placement> solveSpeculative(const SchedulingProblem& problem,
+                                                 const OccupancyGrid& occupancy,
+                                                 const SlotPatternTable& patterns,
+                                                 const RequestGroups& requestGroups,
+                                                 std::span<const CourseKey> courseKeys,
+                                                 RunProfile& profile, SchedulingResult& result,
+                                                 std::pmr::memory_resource* resource);
+};
+
+#endif // CORE_SCHEDULER_H
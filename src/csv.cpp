@@ -0,0 +1,216 @@
+#include "csv.h"
+#include <charconv>
+#include <fstream>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CSV_HAVE_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+#ifdef CSV_HAVE_MMAP
+    if (mapped) {
+        munmap(buffer, length);
+    }
+#endif
+}
+
+bool MappedFile::open(const std::string& path) {
+#ifdef CSV_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "无法打开文件: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        std::cerr << "无法读取文件信息: " << path << std::endl;
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "无法映射文件: " << path << std::endl;
+        length = 0;
+        return false;
+    }
+    madvise(address, length, MADV_SEQUENTIAL);
+    buffer = static_cast<char*>(address);
+    mapped = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "无法打开文件: " << path << std::endl;
+        return false;
+    }
+    fallback.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(fallback.data(), static_cast<std::streamsize>(fallback.size()));
+    buffer = fallback.data();
+    length = fallback.size();
+    return true;
+#endif
+}
+
+CsvReader::CsvReader(char* data, size_t size, char delimiter)
+    : cursor(data), end(data + size), delimiter(delimiter) {
+    // 跳过 UTF-8 BOM
+    if (size >= 3 && static_cast<unsigned char>(data[0]) == 0xEF &&
+        static_cast<unsigned char>(data[1]) == 0xBB && static_cast<unsigned char>(data[2]) == 0xBF) {
+        cursor += 3;
+    }
+}
+
+std::string_view CsvReader::quotedField() {
+    char* start = ++cursor;
+    char* out = start;
+    while (cursor < end) {
+        char c = *cursor;
+        if (c == '"') {
+            if (cursor + 1 < end && cursor[1] == '"') {
+                *out++ = '"';
+                cursor += 2;
+                continue;
+            }
+            cursor++;
+            break;
+        }
+        if (c == '\n') {
+            line++;
+        }
+        // 只有出现过转义引号后才需要移动数据, 避免无谓地触发写时复制
+        if (out != cursor) {
+            *out = c;
+        }
+        out++;
+        cursor++;
+    }
+    // 容忍结束引号之后、分隔符之前的多余字符
+    while (cursor < end && *cursor != delimiter && *cursor != '\n') {
+        cursor++;
+    }
+    return std::string_view(start, static_cast<size_t>(out - start));
+}
+
+bool CsvReader::nextRow(std::vector<std::string_view>& fields) {
+    fields.clear();
+    while (cursor < end && (*cursor == '\n' || *cursor == '\r')) {
+        if (*cursor == '\n') {
+            line++;
+        }
+        cursor++;
+    }
+    if (cursor >= end) {
+        return false;
+    }
+    rowLine = line;
+
+    while (true) {
+        if (cursor < end && *cursor == '"') {
+            fields.push_back(quotedField());
+        } else {
+            char* start = cursor;
+            while (cursor < end && *cursor != delimiter && *cursor != '\n') {
+                cursor++;
+            }
+            char* stop = cursor;
+            if (stop > start && stop[-1] == '\r') {
+                stop--;
+            }
+            fields.emplace_back(start, static_cast<size_t>(stop - start));
+        }
+
+        if (cursor < end && *cursor == delimiter) {
+            cursor++;
+            continue;
+        }
+        if (cursor < end) {
+            cursor++;  // 行尾的 '\n'
+            line++;
+        }
+        return true;
+    }
+}
+
+CsvWriter::CsvWriter(std::FILE* file, char delimiter) : file(file), delimiter(delimiter) {
+    buffer.reserve(1 << 20);
+}
+
+CsvWriter::~CsvWriter() {
+    flush();
+}
+
+void CsvWriter::separator() {
+    if (!firstField) {
+        buffer.push_back(delimiter);
+    }
+    firstField = false;
+}
+
+void CsvWriter::field(std::string_view text) {
+    separator();
+    const char specials[] = {delimiter, '"', '\n', '\r'};
+    bool quote = text.find_first_of(std::string_view(specials, sizeof(specials))) != std::string_view::npos;
+    if (!quote) {
+        buffer.append(text);
+        return;
+    }
+    buffer.push_back('"');
+    for (char c : text) {
+        if (c == '"') {
+            buffer.push_back('"');
+        }
+        buffer.push_back(c);
+    }
+    buffer.push_back('"');
+}
+
+void CsvWriter::field(long long value) {
+    separator();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+void CsvWriter::endRow() {
+    buffer.push_back('\n');
+    firstField = true;
+    if (buffer.size() >= (1 << 20) - 4096) {
+        flush();
+    }
+}
+
+bool CsvWriter::flush() {
+    if (!buffer.empty()) {
+        if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            failed = true;
+        }
+        buffer.clear();
+    }
+    if (std::fflush(file) != 0) {
+        failed = true;
+    }
+    return !failed;
+}
+
+char delimiterForPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos) {
+        std::string extension = path.substr(dot + 1);
+        if (extension == "tsv" || extension == "TSV" || extension == "tab") {
+            return '\t';
+        }
+    }
+    return ',';
+}
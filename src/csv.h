@@ -0,0 +1,101 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 只读打开并映射整个文件
+ *
+ * POSIX 下使用 mmap(MAP_PRIVATE, 写时复制), 其他平台退化为一次性读入内存。
+ * 缓冲区可写, CsvReader 在原地去除引号转义, 不会修改磁盘上的文件。
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+
+    char* data() { return buffer; }
+    size_t size() const { return length; }
+
+private:
+    char* buffer = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> fallback;
+};
+
+/**
+ * @brief 流式 CSV/TSV 解析器
+ *
+ * 字段以 std::string_view 形式直接指向输入缓冲区, 不复制。
+ * 支持双引号包围的字段(可包含分隔符、换行, "" 表示一个引号),
+ * 含转义引号的字段在缓冲区中原地压缩。兼容 \r\n 换行与 UTF-8 BOM, 跳过空行。
+ */
+class CsvReader {
+public:
+    CsvReader(char* data, size_t size, char delimiter);
+
+    /**
+     * @brief 读取下一行
+     * @param fields 输出各字段(先清空, 复用其容量)
+     * @return 输入结束时返回 false
+     */
+    bool nextRow(std::vector<std::string_view>& fields);
+
+    /**
+     * @brief 最近一行在文件中的起始行号(从 1 开始)
+     */
+    long long lineNumber() const { return rowLine; }
+
+private:
+    char* cursor;
+    char* end;
+    char delimiter;
+    long long line = 1;
+    long long rowLine = 0;
+
+    std::string_view quotedField();
+};
+
+/**
+ * @brief 带缓冲的 CSV/TSV 写入器, 需要时自动为字段加引号
+ */
+class CsvWriter {
+public:
+    CsvWriter(std::FILE* file, char delimiter);
+    ~CsvWriter();
+
+    void field(std::string_view text);
+    void field(long long value);
+    void endRow();
+
+    /**
+     * @brief 写出缓冲区中剩余的数据
+     * @return 所有写入是否成功
+     */
+    bool flush();
+
+private:
+    std::FILE* file;
+    char delimiter;
+    bool firstField = true;
+    bool failed = false;
+    std::string buffer;
+
+    void separator();
+};
+
+/**
+ * @brief 按文件扩展名选择分隔符: .tsv 为制表符, 其余为逗号
+ */
+char delimiterForPath(const std::string& path);
+
+#endif // CSV_H
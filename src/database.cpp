@@ -1,28 +1,81 @@
 #include "database.h"
+#include <atomic>
+#include <functional>
 #include <sstream>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
 
-Database::Database(const std::string& dbPath) : db(nullptr), dbPath(dbPath) {}
+// 以 string_view 查找 std::string 键, 查找时不构造临时字符串
+struct TextHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+// 文本列的内容, 只在下一次 sqlite3_step 之前有效
+static std::string_view columnText(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? std::string_view(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, column))
+                : std::string_view();
+}
+
+Database::Database(const std::string& dbPath, int readerConnections)
+    : db(nullptr), dbPath(dbPath), requestedReaders(readerConnections) {}
+
+// 每条语句开始执行时调用一次(sqlite3_trace 在 SQLite 3.8 中即可使用, 读出行数见 stepRow)
+// 查询缓存可能在其他线程读取数据库, 计数器以原子操作累加
+static void traceCallback(void* context, const char*) {
+    auto* counters = static_cast<DatabaseCounters*>(context);
+    std::atomic_ref<uint64_t>(counters->statements).fetch_add(1, std::memory_order_relaxed);
+}
+
+int Database::stepRow(sqlite3_stmt* stmt) const {
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        std::atomic_ref<uint64_t>(stats.rowsRead).fetch_add(1, std::memory_order_relaxed);
+    }
+    return rc;
+}
 
 Database::~Database() {
+    for (sqlite3* reader : readers) {
+        sqlite3_close(reader);
+    }
     if (db) {
         sqlite3_close(db);
     }
 }
 
 bool Database::initialize() {
+    bool pooled = requestedReaders > 0;
+    if (pooled && (dbPath.empty() || dbPath == ":memory:")) {
+        std::cerr << "提示: 内存数据库不支持连接池, 使用单连接模式" << std::endl;
+        pooled = false;
+    }
+    
     int rc = sqlite3_open(dbPath.c_str(), &db);
     if (rc != SQLITE_OK) {
         std::cerr << "无法打开数据库: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
+    sqlite3_trace(db, traceCallback, &stats);
+    
+    // WAL 模式下读连接读取已提交的快照, 不被写事务阻塞; synchronous=NORMAL 在 WAL 下仍保证数据库一致
+    if (pooled) {
+        sqlite3_busy_timeout(db, 5000);
+        if (!executeSQL("PRAGMA journal_mode=WAL;") || !executeSQL("PRAGMA synchronous=NORMAL;")) {
+            return false;
+        }
+    }
     
     // 创建实验室表
     std::string createLabTable = R"(
         CREATE TABLE IF NOT EXISTS laboratories (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             location TEXT NOT NULL,
-            capacity INTEGER NOT NULL
+            capacity INTEGER NOT NULL,
+            features TEXT NOT NULL DEFAULT '',
+            blackout BLOB
         );
     )";
     
@@ -35,7 +88,10 @@ bool Database::initialize() {
             teacher TEXT NOT NULL,
             preferred_slots TEXT NOT NULL,
             excluded_slots TEXT NOT NULL,
-            priority INTEGER NOT NULL
+            priority INTEGER NOT NULL,
+            required_features TEXT NOT NULL DEFAULT '',
+            course TEXT NOT NULL DEFAULT '',
+            shareable INTEGER NOT NULL DEFAULT 0
         );
     )";
     
@@ -53,9 +109,92 @@ bool Database::initialize() {
         );
     )";
     
-    return executeSQL(createLabTable) && 
-           executeSQL(createRequestTable) && 
-           executeSQL(createScheduleTable);
+    bool created = executeSQL(createLabTable) && 
+                   executeSQL(createRequestTable) && 
+                   executeSQL(createScheduleTable) &&
+                   // 兼容旧版本数据库: 补充后来新增的列
+                   addColumnIfMissing("laboratories", "features", "TEXT NOT NULL DEFAULT ''") &&
+                   addColumnIfMissing("laboratories", "blackout", "BLOB") &&
+                   addColumnIfMissing("requests", "required_features", "TEXT NOT NULL DEFAULT ''") &&
+                   addColumnIfMissing("requests", "course", "TEXT NOT NULL DEFAULT ''") &&
+                   addColumnIfMissing("requests", "shareable", "INTEGER NOT NULL DEFAULT 0");
+    
+    // 读连接在表结构建好之后打开
+    return created && (!pooled || openReaders());
+}
+
+bool Database::openReaders() {
+    for (int i = 0; i < requestedReaders; i++) {
+        sqlite3* reader = nullptr;
+        // 每个读连接同一时刻只被一个线程使用, 不需要 SQLite 内部的连接锁
+        int rc = sqlite3_open_v2(dbPath.c_str(), &reader, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+        if (rc != SQLITE_OK) {
+            std::cerr << "无法打开只读连接: " << sqlite3_errmsg(reader) << std::endl;
+            sqlite3_close(reader);
+            return false;
+        }
+        sqlite3_busy_timeout(reader, 5000);
+        sqlite3_trace(reader, traceCallback, &stats);
+        readers.push_back(reader);
+    }
+    idleReaders = readers;
+    return true;
+}
+
+Database::ReaderLease Database::acquireReader() {
+    if (readers.empty()) {
+        return ReaderLease(nullptr, db);
+    }
+    std::unique_lock<std::mutex> lock(readerMutex);
+    readerReleased.wait(lock, [this] { return !idleReaders.empty(); });
+    sqlite3* reader = idleReaders.back();
+    idleReaders.pop_back();
+    return ReaderLease(this, reader);
+}
+
+void Database::releaseReader(sqlite3* connection) {
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        idleReaders.push_back(connection);
+    }
+    readerReleased.notify_one();
+}
+
+FeatureMask Database::internFeatures(const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(featureMutex);
+    return features.intern(names);
+}
+
+bool Database::addColumnIfMissing(const std::string& table, const std::string& column,
+                                  const std::string& definition) {
+    std::string sql = "PRAGMA table_info(" + table + ");";
+    sqlite3_stmt* stmt;
+    
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    bool exists = false;
+    while (stepRow(stmt) == SQLITE_ROW) {
+        if (column == reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))) {
+            exists = true;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+    
+    if (exists) {
+        return true;
+    }
+    return executeSQL("ALTER TABLE " + table + " ADD COLUMN " + column + " " + definition + ";");
+}
+
+DatabaseCounters Database::counters() const {
+    DatabaseCounters result;
+    result.statements = std::atomic_ref<uint64_t>(stats.statements).load(std::memory_order_relaxed);
+    result.rowsRead = std::atomic_ref<uint64_t>(stats.rowsRead).load(std::memory_order_relaxed);
+    result.rowsWritten = db ? static_cast<uint64_t>(sqlite3_total_changes(db)) : 0;
+    return result;
 }
 
 bool Database::executeSQL(const std::string& sql) {
@@ -69,6 +208,27 @@ bool Database::executeSQL(const std::string& sql) {
     return true;
 }
 
+std::string Database::encodeSlotMask(Calendar::Mask mask) {
+    std::string bytes((Calendar::kSlotCount + 7) / 8, '\0');
+    for (int slot = 0; slot < Calendar::kSlotCount; slot++) {
+        if (hasSlot(mask, slot)) {
+            bytes[slot / 8] = static_cast<char>(bytes[slot / 8] | (1 << (slot % 8)));
+        }
+    }
+    return bytes;
+}
+
+Calendar::Mask Database::decodeSlotMask(const void* data, int bytes) {
+    Calendar::Mask mask = 0;
+    const unsigned char* bits = static_cast<const unsigned char*>(data);
+    for (int slot = 0; slot < Calendar::kSlotCount && slot / 8 < bytes; slot++) {
+        if ((bits[slot / 8] >> (slot % 8)) & 1) {
+            mask |= singleSlot<Calendar::Mask>(slot);
+        }
+    }
+    return mask;
+}
+
 std::string Database::serializeTimeSlots(const std::vector<TimeSlot>& slots) {
     std::ostringstream oss;
     for (size_t i = 0; i < slots.size(); i++) {
@@ -86,25 +246,56 @@ std::vector<TimeSlot> Database::deserializeTimeSlots(const std::string& data) {
     std::string slot;
     while (std::getline(iss, slot, ';')) {
         std::istringstream slotStream(slot);
-        TimeSlot ts;
+        TimeSlot ts{};
         char comma;
-        slotStream >> ts.week >> comma >> ts.day >> comma >> ts.period;
-        slots.push_back(ts);
+        if (slotStream >> ts.week >> comma >> ts.day >> comma >> ts.period) {
+            slots.push_back(ts);
+        }
     }
     return slots;
 }
 
+std::string Database::serializeFeatures(const std::vector<std::string>& names) {
+    std::string result;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (i > 0) result += ",";
+        result += names[i];
+    }
+    return result;
+}
+
+std::vector<std::string> Database::deserializeFeatures(const std::string& data) {
+    std::vector<std::string> names;
+    if (data.empty()) return names;
+    
+    std::istringstream iss(data);
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        if (!name.empty()) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
 // 实验室管理
-bool Database::addLaboratory(const std::string& location, int capacity) {
-    std::string sql = "INSERT INTO laboratories (location, capacity) VALUES (?, ?);";
+bool Database::addLaboratory(const std::string& location, int capacity,
+                             const std::vector<std::string>& features, Calendar::Mask blackout) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    std::string sql = "INSERT INTO laboratories (location, capacity, features, blackout) VALUES (?, ?, ?, ?);";
     sqlite3_stmt* stmt;
     
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return false;
     }
     
+    std::string featuresStr = serializeFeatures(features);
+    
     sqlite3_bind_text(stmt, 1, location.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 2, capacity);
+    sqlite3_bind_text(stmt, 3, featuresStr.c_str(), -1, SQLITE_TRANSIENT);
+    std::string blackoutBytes = encodeSlotMask(blackout);
+    sqlite3_bind_blob(stmt, 4, blackoutBytes.data(), static_cast<int>(blackoutBytes.size()), SQLITE_TRANSIENT);
     
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -112,7 +303,27 @@ bool Database::addLaboratory(const std::string& location, int capacity) {
     return rc == SQLITE_DONE;
 }
 
+bool Database::setLabBlackout(int labId, Calendar::Mask blackout) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    std::string sql = "UPDATE laboratories SET blackout = ? WHERE id = ?;";
+    sqlite3_stmt* stmt;
+    
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    std::string blackoutBytes = encodeSlotMask(blackout);
+    sqlite3_bind_blob(stmt, 1, blackoutBytes.data(), static_cast<int>(blackoutBytes.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, labId);
+    
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    return rc == SQLITE_DONE && sqlite3_changes(db) > 0;
+}
+
 bool Database::deleteLaboratory(int id) {
+    std::lock_guard<std::mutex> lock(writerMutex);
     std::string sql = "DELETE FROM laboratories WHERE id = ?;";
     sqlite3_stmt* stmt;
     
@@ -124,24 +335,31 @@ bool Database::deleteLaboratory(int id) {
     
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
+    bumpScheduleVersion();
     
     return rc == SQLITE_DONE;
 }
 
 std::vector<Laboratory> Database::getAllLaboratories() {
+    ReaderLease reader = acquireReader();
     std::vector<Laboratory> labs;
-    std::string sql = "SELECT id, location, capacity FROM laboratories;";
+    std::string sql = "SELECT id, location, capacity, features, blackout FROM laboratories;";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return labs;
     }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (stepRow(stmt) == SQLITE_ROW) {
         Laboratory lab;
         lab.id = sqlite3_column_int(stmt, 0);
         lab.location = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         lab.capacity = sqlite3_column_int(stmt, 2);
+        lab.features = deserializeFeatures(
+            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
+        lab.featureMask = internFeatures(lab.features);
+        lab.blackout = decodeSlotMask(sqlite3_column_blob(stmt, 4), sqlite3_column_bytes(stmt, 4));
+        lab.locationName = interner.intern(lab.location);
         labs.push_back(lab);
     }
     
@@ -150,20 +368,26 @@ std::vector<Laboratory> Database::getAllLaboratories() {
 }
 
 Laboratory Database::getLaboratory(int id) {
-    Laboratory lab = {0, "", 0};
-    std::string sql = "SELECT id, location, capacity FROM laboratories WHERE id = ?;";
+    ReaderLease reader = acquireReader();
+    Laboratory lab = {0, "", 0, {}, 0, 0, kNoName};
+    std::string sql = "SELECT id, location, capacity, features, blackout FROM laboratories WHERE id = ?;";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return lab;
     }
     
     sqlite3_bind_int(stmt, 1, id);
     
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    if (stepRow(stmt) == SQLITE_ROW) {
         lab.id = sqlite3_column_int(stmt, 0);
         lab.location = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         lab.capacity = sqlite3_column_int(stmt, 2);
+        lab.features = deserializeFeatures(
+            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
+        lab.featureMask = internFeatures(lab.features);
+        lab.blackout = decodeSlotMask(sqlite3_column_blob(stmt, 4), sqlite3_column_bytes(stmt, 4));
+        lab.locationName = interner.intern(lab.location);
     }
     
     sqlite3_finalize(stmt);
@@ -172,7 +396,8 @@ Laboratory Database::getLaboratory(int id) {
 
 // 申请管理
 bool Database::addRequest(const LabRequest& request) {
-    std::string sql = "INSERT INTO requests (class_id, student_count, teacher, preferred_slots, excluded_slots, priority) VALUES (?, ?, ?, ?, ?, ?);";
+    std::lock_guard<std::mutex> lock(writerMutex);
+    std::string sql = "INSERT INTO requests (class_id, student_count, teacher, preferred_slots, excluded_slots, priority, required_features, course, shareable) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
     sqlite3_stmt* stmt;
     
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
@@ -181,6 +406,7 @@ bool Database::addRequest(const LabRequest& request) {
     
     std::string preferredStr = serializeTimeSlots(request.preferredSlots);
     std::string excludedStr = serializeTimeSlots(request.excludedSlots);
+    std::string featuresStr = serializeFeatures(request.requiredFeatures);
     
     sqlite3_bind_text(stmt, 1, request.classId.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 2, request.studentCount);
@@ -188,6 +414,9 @@ bool Database::addRequest(const LabRequest& request) {
     sqlite3_bind_text(stmt, 4, preferredStr.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 5, excludedStr.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 6, request.priority);
+    sqlite3_bind_text(stmt, 7, featuresStr.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 8, request.course.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 9, request.shareable ? 1 : 0);
     
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -196,6 +425,7 @@ bool Database::addRequest(const LabRequest& request) {
 }
 
 bool Database::deleteRequest(int id) {
+    std::lock_guard<std::mutex> lock(writerMutex);
     std::string sql = "DELETE FROM requests WHERE id = ?;";
     sqlite3_stmt* stmt;
     
@@ -207,31 +437,67 @@ bool Database::deleteRequest(int id) {
     
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
+    bumpScheduleVersion();
     
     return rc == SQLITE_DONE;
 }
 
-std::vector<LabRequest> Database::getAllRequests() {
+std::vector<LabRequest> Database::getAllRequests(bool copyNames) {
+    ReaderLease reader = acquireReader();
     std::vector<LabRequest> requests;
-    std::string sql = "SELECT id, class_id, student_count, teacher, preferred_slots, excluded_slots, priority FROM requests ORDER BY priority;";
+    std::string sql = "SELECT id, class_id, student_count, teacher, preferred_slots, excluded_slots, priority, required_features, course, shareable FROM requests ORDER BY priority;";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return requests;
     }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    // 大量申请的时间段列表文本完全相同, 每种文本只解析一次
+    std::unordered_map<std::string, std::vector<TimeSlot>, TextHash, std::equal_to<>> parsedSlots;
+    auto slotsAt = [&](int column) -> const std::vector<TimeSlot>& {
+        std::string_view text(reinterpret_cast<const char*>(sqlite3_column_text(stmt, column)),
+                              sqlite3_column_bytes(stmt, column));
+        auto it = parsedSlots.find(text);
+        if (it == parsedSlots.end()) {
+            std::string key(text);
+            it = parsedSlots.emplace(key, deserializeTimeSlots(key)).first;
+        }
+        return it->second;
+    };
+    // 所需设备特性同理, 每种文本只解析并映射为位图一次
+    std::unordered_map<std::string, std::pair<std::vector<std::string>, FeatureMask>, TextHash, std::equal_to<>>
+        parsedFeatures;
+    
+    while (stepRow(stmt) == SQLITE_ROW) {
         LabRequest req;
         req.id = sqlite3_column_int(stmt, 0);
-        req.classId = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        std::string_view classId = columnText(stmt, 1);
         req.studentCount = sqlite3_column_int(stmt, 2);
-        req.teacher = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        req.preferredSlots = deserializeTimeSlots(
-            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4)));
-        req.excludedSlots = deserializeTimeSlots(
-            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
+        std::string_view teacher = columnText(stmt, 3);
+        req.preferredSlots = slotsAt(4);
+        req.excludedSlots = slotsAt(5);
         req.priority = sqlite3_column_int(stmt, 6);
-        requests.push_back(req);
+        std::string_view featureText = columnText(stmt, 7);
+        auto parsed = parsedFeatures.find(featureText);
+        if (parsed == parsedFeatures.end()) {
+            std::string key(featureText);
+            std::vector<std::string> featureNames = deserializeFeatures(key);
+            FeatureMask mask = internFeatures(featureNames);
+            parsed = parsedFeatures.emplace(key, std::make_pair(std::move(featureNames), mask)).first;
+        }
+        req.requiredFeatures = parsed->second.first;
+        req.requiredMask = parsed->second.second;
+        std::string_view course = columnText(stmt, 8);
+        req.shareable = sqlite3_column_int(stmt, 9) != 0;
+        req.className = interner.intern(classId);
+        req.teacherName = interner.intern(teacher);
+        req.courseName = interner.intern(course);
+        if (copyNames) {
+            req.classId = classId;
+            req.teacher = teacher;
+            req.course = course;
+        }
+        requests.push_back(std::move(req));
     }
     
     sqlite3_finalize(stmt);
@@ -239,17 +505,18 @@ std::vector<LabRequest> Database::getAllRequests() {
 }
 
 LabRequest Database::getRequest(int id) {
-    LabRequest req = {0, "", 0, "", {}, {}, 0};
-    std::string sql = "SELECT id, class_id, student_count, teacher, preferred_slots, excluded_slots, priority FROM requests WHERE id = ?;";
+    ReaderLease reader = acquireReader();
+    LabRequest req = {0, "", 0, "", {}, {}, 0, {}, 0, "", false, kNoName, kNoName, kNoName};
+    std::string sql = "SELECT id, class_id, student_count, teacher, preferred_slots, excluded_slots, priority, required_features, course, shareable FROM requests WHERE id = ?;";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return req;
     }
     
     sqlite3_bind_int(stmt, 1, id);
     
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    if (stepRow(stmt) == SQLITE_ROW) {
         req.id = sqlite3_column_int(stmt, 0);
         req.classId = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         req.studentCount = sqlite3_column_int(stmt, 2);
@@ -259,18 +526,124 @@ LabRequest Database::getRequest(int id) {
         req.excludedSlots = deserializeTimeSlots(
             reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
         req.priority = sqlite3_column_int(stmt, 6);
+        req.requiredFeatures = deserializeFeatures(
+            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7)));
+        req.requiredMask = internFeatures(req.requiredFeatures);
+        req.course = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
+        req.shareable = sqlite3_column_int(stmt, 9) != 0;
+        req.className = interner.intern(req.classId);
+        req.teacherName = interner.intern(req.teacher);
+        req.courseName = interner.intern(req.course);
     }
     
     sqlite3_finalize(stmt);
     return req;
 }
 
+// 批量导入
+long long Database::insertRows(const std::string& sql,
+                               const std::function<bool(sqlite3_stmt*)>& bindNext,
+                               int batchSize) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "预编译批量插入语句失败: " << sqlite3_errmsg(db) << std::endl;
+        return -1;
+    }
+    if (batchSize < 1) {
+        batchSize = 1;
+    }
+    
+    long long inserted = 0;
+    int inBatch = 0;
+    bool ok = true;
+    while (ok && bindNext(stmt)) {
+        if (inBatch == 0 && !executeSQL("BEGIN TRANSACTION;")) {
+            ok = false;
+            break;
+        }
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            std::cerr << "批量插入失败: " << sqlite3_errmsg(db) << std::endl;
+            ok = false;
+            break;
+        }
+        sqlite3_reset(stmt);
+        inserted++;
+        if (++inBatch >= batchSize) {
+            ok = executeSQL("COMMIT;");
+            inBatch = 0;
+        }
+    }
+    sqlite3_finalize(stmt);
+    
+    if (!ok) {
+        if (inBatch > 0) {
+            executeSQL("ROLLBACK;");
+        }
+        return -1;
+    }
+    if (inBatch > 0 && !executeSQL("COMMIT;")) {
+        return -1;
+    }
+    return inserted;
+}
+
+long long Database::addLaboratoryRows(const std::function<bool(LaboratoryRow&)>& next, int batchSize) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    LaboratoryRow row{};
+    std::string blackoutBytes;
+    // 字段引用调用方的缓冲区, 在 sqlite3_step 之前保持有效, 因此使用 SQLITE_STATIC 避免复制
+    return insertRows(
+        "INSERT INTO laboratories (location, capacity, features, blackout) VALUES (?, ?, ?, ?);",
+        [&](sqlite3_stmt* stmt) {
+            if (!next(row)) {
+                return false;
+            }
+            sqlite3_bind_text(stmt, 1, row.location.data(), static_cast<int>(row.location.size()), SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, row.capacity);
+            sqlite3_bind_text(stmt, 3, row.features.data(), static_cast<int>(row.features.size()), SQLITE_STATIC);
+            blackoutBytes = encodeSlotMask(row.blackout);
+            sqlite3_bind_blob(stmt, 4, blackoutBytes.data(), static_cast<int>(blackoutBytes.size()), SQLITE_STATIC);
+            return true;
+        },
+        batchSize);
+}
+
+long long Database::addRequestRows(const std::function<bool(RequestRow&)>& next, int batchSize) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    RequestRow row{};
+    return insertRows(
+        "INSERT INTO requests (class_id, student_count, teacher, preferred_slots, excluded_slots, priority, required_features, course, shareable) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+        [&](sqlite3_stmt* stmt) {
+            if (!next(row)) {
+                return false;
+            }
+            auto bindView = [stmt](int index, std::string_view text) {
+                sqlite3_bind_text(stmt, index, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+            };
+            bindView(1, row.classId);
+            sqlite3_bind_int(stmt, 2, row.studentCount);
+            bindView(3, row.teacher);
+            bindView(4, row.preferredSlots);
+            bindView(5, row.excludedSlots);
+            sqlite3_bind_int(stmt, 6, row.priority);
+            bindView(7, row.requiredFeatures);
+            bindView(8, row.course);
+            sqlite3_bind_int(stmt, 9, row.shareable ? 1 : 0);
+            return true;
+        },
+        batchSize);
+}
+
 // 课程安排管理
 bool Database::clearSchedules() {
-    return executeSQL("DELETE FROM schedules;");
+    std::lock_guard<std::mutex> lock(writerMutex);
+    bool ok = executeSQL("DELETE FROM schedules;");
+    bumpScheduleVersion();
+    return ok;
 }
 
 bool Database::addSchedule(const Schedule& schedule) {
+    std::lock_guard<std::mutex> lock(writerMutex);
     std::string sql = "INSERT INTO schedules (request_id, lab_id, week, day, period) VALUES (?, ?, ?, ?, ?);";
     sqlite3_stmt* stmt;
     
@@ -286,20 +659,87 @@ bool Database::addSchedule(const Schedule& schedule) {
     
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
+    bumpScheduleVersion();
     
     return rc == SQLITE_DONE;
 }
 
+bool Database::addSchedules(const std::vector<Schedule>& schedules) {
+    return updateSchedules({}, schedules);
+}
+
+bool Database::updateSchedules(const std::vector<int>& removedIds, const std::vector<Schedule>& schedules) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (!executeSQL("BEGIN TRANSACTION;")) {
+        return false;
+    }
+    
+    sqlite3_stmt* stmt;
+    bool ok = true;
+    if (!removedIds.empty()) {
+        if (sqlite3_prepare_v2(db, "DELETE FROM schedules WHERE id = ?;", -1, &stmt, nullptr) != SQLITE_OK) {
+            executeSQL("ROLLBACK;");
+            return false;
+        }
+        for (int id : removedIds) {
+            sqlite3_bind_int(stmt, 1, id);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                ok = false;
+                break;
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        if (!ok) {
+            executeSQL("ROLLBACK;");
+            return false;
+        }
+    }
+    
+    std::string sql = "INSERT INTO schedules (request_id, lab_id, week, day, period) VALUES (?, ?, ?, ?, ?);";
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        executeSQL("ROLLBACK;");
+        return false;
+    }
+    
+    // 复用同一条预编译语句, 每行只需重新绑定参数
+    for (const auto& schedule : schedules) {
+        sqlite3_bind_int(stmt, 1, schedule.requestId);
+        sqlite3_bind_int(stmt, 2, schedule.labId);
+        sqlite3_bind_int(stmt, 3, schedule.timeSlot.week);
+        sqlite3_bind_int(stmt, 4, schedule.timeSlot.day);
+        sqlite3_bind_int(stmt, 5, schedule.timeSlot.period);
+        
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            ok = false;
+            break;
+        }
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_finalize(stmt);
+    
+    if (!ok) {
+        executeSQL("ROLLBACK;");
+        return false;
+    }
+    // 提交之后再递增版本号, 避免查询缓存以新版本号保存只写入了一部分的课表
+    ok = executeSQL("COMMIT;");
+    bumpScheduleVersion();
+    return ok;
+}
+
 std::vector<Schedule> Database::getAllSchedules() {
+    ReaderLease reader = acquireReader();
     std::vector<Schedule> schedules;
     std::string sql = "SELECT id, request_id, lab_id, week, day, period FROM schedules;";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return schedules;
     }
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (stepRow(stmt) == SQLITE_ROW) {
         Schedule sch;
         sch.id = sqlite3_column_int(stmt, 0);
         sch.requestId = sqlite3_column_int(stmt, 1);
@@ -315,17 +755,18 @@ std::vector<Schedule> Database::getAllSchedules() {
 }
 
 std::vector<Schedule> Database::getSchedulesByLab(int labId) {
+    ReaderLease reader = acquireReader();
     std::vector<Schedule> schedules;
     std::string sql = "SELECT id, request_id, lab_id, week, day, period FROM schedules WHERE lab_id = ?;";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return schedules;
     }
     
     sqlite3_bind_int(stmt, 1, labId);
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (stepRow(stmt) == SQLITE_ROW) {
         Schedule sch;
         sch.id = sqlite3_column_int(stmt, 0);
         sch.requestId = sqlite3_column_int(stmt, 1);
@@ -341,6 +782,7 @@ std::vector<Schedule> Database::getSchedulesByLab(int labId) {
 }
 
 std::vector<Schedule> Database::getSchedulesByClass(const std::string& classId) {
+    ReaderLease reader = acquireReader();
     std::vector<Schedule> schedules;
     std::string sql = R"(
         SELECT s.id, s.request_id, s.lab_id, s.week, s.day, s.period 
@@ -350,13 +792,46 @@ std::vector<Schedule> Database::getSchedulesByClass(const std::string& classId)
     )";
     sqlite3_stmt* stmt;
     
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         return schedules;
     }
     
     sqlite3_bind_text(stmt, 1, classId.c_str(), -1, SQLITE_TRANSIENT);
     
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (stepRow(stmt) == SQLITE_ROW) {
+        Schedule sch;
+        sch.id = sqlite3_column_int(stmt, 0);
+        sch.requestId = sqlite3_column_int(stmt, 1);
+        sch.labId = sqlite3_column_int(stmt, 2);
+        sch.timeSlot.week = sqlite3_column_int(stmt, 3);
+        sch.timeSlot.day = sqlite3_column_int(stmt, 4);
+        sch.timeSlot.period = sqlite3_column_int(stmt, 5);
+        schedules.push_back(sch);
+    }
+    
+    sqlite3_finalize(stmt);
+    return schedules;
+}
+
+std::vector<Schedule> Database::getSchedulesByTeacher(const std::string& teacher) {
+    ReaderLease reader = acquireReader();
+    std::vector<Schedule> schedules;
+    std::string sql = R"(
+        SELECT s.id, s.request_id, s.lab_id, s.week, s.day, s.period 
+        FROM schedules s 
+        JOIN requests r ON s.request_id = r.id 
+        WHERE r.teacher = ?
+        ORDER BY s.week, s.day, s.period, s.id;
+    )";
+    sqlite3_stmt* stmt;
+    
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return schedules;
+    }
+    
+    sqlite3_bind_text(stmt, 1, teacher.c_str(), -1, SQLITE_TRANSIENT);
+    
+    while (stepRow(stmt) == SQLITE_ROW) {
         Schedule sch;
         sch.id = sqlite3_column_int(stmt, 0);
         sch.requestId = sqlite3_column_int(stmt, 1);
@@ -371,8 +846,50 @@ std::vector<Schedule> Database::getSchedulesByClass(const std::string& classId)
     return schedules;
 }
 
+bool Database::exportSchedules(const std::function<void(const ScheduleExportRow&)>& row) {
+    ReaderLease reader = acquireReader();
+    std::string sql =
+        "SELECT r.class_id, r.teacher, r.student_count, l.location, l.capacity, s.week, s.day, s.period "
+        "FROM schedules s "
+        "JOIN requests r ON r.id = s.request_id "
+        "JOIN laboratories l ON l.id = s.lab_id "
+        "ORDER BY s.week, s.day, s.period, l.location, r.class_id;";
+    sqlite3_stmt* stmt;
+    
+    if (sqlite3_prepare_v2(reader.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "导出课表失败: " << sqlite3_errmsg(reader.get()) << std::endl;
+        return false;
+    }
+    
+    // 文本列直接以 string_view 引用 SQLite 的列缓冲区, 不复制
+    auto textColumn = [stmt](int column) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return std::string_view(text ? text : "", text ? sqlite3_column_bytes(stmt, column) : 0);
+    };
+    
+    int rc;
+    while ((rc = stepRow(stmt)) == SQLITE_ROW) {
+        ScheduleExportRow exportRow;
+        exportRow.classId = textColumn(0);
+        exportRow.teacher = textColumn(1);
+        exportRow.studentCount = sqlite3_column_int(stmt, 2);
+        exportRow.location = textColumn(3);
+        exportRow.capacity = sqlite3_column_int(stmt, 4);
+        exportRow.timeSlot.week = sqlite3_column_int(stmt, 5);
+        exportRow.timeSlot.day = sqlite3_column_int(stmt, 6);
+        exportRow.timeSlot.period = sqlite3_column_int(stmt, 7);
+        row(exportRow);
+    }
+    
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
 bool Database::clearAllData() {
-    return executeSQL("DELETE FROM schedules;") &&
-           executeSQL("DELETE FROM requests;") &&
-           executeSQL("DELETE FROM laboratories;");
+    std::lock_guard<std::mutex> lock(writerMutex);
+    bool ok = executeSQL("DELETE FROM schedules;") &&
+              executeSQL("DELETE FROM requests;") &&
+              executeSQL("DELETE FROM laboratories;");
+    bumpScheduleVersion();
+    return ok;
 }
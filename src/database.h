@@ -1,90 +1,244 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include "calendar.h"
+#include "instrumentation.h"
+#include "lab_features.h"
+#include "lab_types.h"
+#include "string_interner.h"
 #include <sqlite3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
-// 实验室信息
-struct Laboratory {
-    int id;
-    std::string location;
+// 批量导入的一行实验室数据: 字段直接引用输入缓冲区, 不复制
+// features 已是数据库中的存储格式(逗号分隔)
+struct LaboratoryRow {
+    std::string_view location;
     int capacity;
+    std::string_view features;
+    Calendar::Mask blackout;
 };
 
-// 时间槽定义 (周次, 星期, 时段: 0-上午, 1-下午)
-struct TimeSlot {
-    int week;      // 周次 (9 或 10)
-    int day;       // 星期 (0-4 对应周一到周五)
-    int period;    // 时段 (0-上午, 1-下午)
-    
-    bool operator==(const TimeSlot& other) const {
-        return week == other.week && day == other.day && period == other.period;
-    }
-    
-    bool operator<(const TimeSlot& other) const {
-        if (week != other.week) return week < other.week;
-        if (day != other.day) return day < other.day;
-        return period < other.period;
-    }
-};
-
-// 实验申请
-struct LabRequest {
-    int id;
-    std::string classId;
+// 批量导入的一行申请数据: 字段直接引用输入缓冲区, 不复制
+// 时间段与设备特性已是数据库中的存储格式(见 serializeTimeSlots / serializeFeatures)
+struct RequestRow {
+    std::string_view classId;
     int studentCount;
-    std::string teacher;
-    std::vector<TimeSlot> preferredSlots;  // 期望时间段 (√)
-    std::vector<TimeSlot> excludedSlots;   // 不期望时间段 (×)
-    int priority;  // 优先级 (基于申请时间)
+    std::string_view teacher;
+    std::string_view preferredSlots;
+    std::string_view excludedSlots;
+    int priority;
+    std::string_view requiredFeatures;
+    std::string_view course;
+    bool shareable;
 };
 
-// 课程安排结果
-struct Schedule {
-    int id;
-    int requestId;
-    int labId;
+// 导出课表的一行数据: 字段引用 SQLite 内部缓冲区, 仅在回调期间有效
+struct ScheduleExportRow {
+    std::string_view classId;
+    std::string_view teacher;
+    int studentCount;
+    std::string_view location;
+    int capacity;
     TimeSlot timeSlot;
 };
 
+/**
+ * @brief SQLite 数据库访问
+ *
+ * 默认只打开一个连接, 所有操作都使用它。
+ * 构造时 readerConnections > 0 则使用连接池模式:
+ *   - 以 WAL 模式打开数据库文件, 读写互不阻塞, 读者只看到已提交的数据
+ *   - 一个写连接: 所有修改操作经过它, 并由写锁串行化(批量写入的整个事务持有写锁)
+ *   - readerConnections 个只读连接: get* 与 exportSchedules 在执行期间从池中借出一个,
+ *     调用线程独占该连接, 用完归还; 池中没有空闲连接时等待
+ * 内存数据库(":memory:")无法在多个连接之间共享, 此时退回单连接模式。
+ */
 class Database {
 public:
-    Database(const std::string& dbPath);
+    Database(const std::string& dbPath, int readerConnections = 0);
     ~Database();
     
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+    
     bool initialize();
     bool isOpen() const { return db != nullptr; }
     
+    // 连接池中的只读连接数, 单连接模式为 0
+    int readerCount() const { return static_cast<int>(readers.size()); }
+    
+    // 最近一次成功插入的行的 id(写连接上的值, 多个线程同时写入时应在同一线程插入后立即读取)
+    long long lastInsertId() const { return sqlite3_last_insert_rowid(db); }
+    
     // 实验室管理
-    bool addLaboratory(const std::string& location, int capacity);
+    bool addLaboratory(const std::string& location, int capacity,
+                       const std::vector<std::string>& features = {},
+                       Calendar::Mask blackout = 0);
     bool deleteLaboratory(int id);
+    
+    /**
+     * @brief 修改实验室的不可用时间槽(只改写这一行, 不影响已生成的课表)
+     *
+     * 已有课程落在新的不可用时间槽中时, 用粘性重新生成(Scheduler::setStickyRegenerate)
+     * 只调整受影响的班级。
+     * @return 实验室不存在时返回 false
+     */
+    bool setLabBlackout(int labId, Calendar::Mask blackout);
+    
+    /**
+     * @brief 以可用时间窗口设置: available 之外的时间槽都不可用
+     */
+    bool setLabAvailability(int labId, Calendar::Mask available) {
+        return setLabBlackout(labId, Calendar::allSlots() & ~available);
+    }
     std::vector<Laboratory> getAllLaboratories();
     Laboratory getLaboratory(int id);
     
     // 申请管理
     bool addRequest(const LabRequest& request);
     bool deleteRequest(int id);
-    std::vector<LabRequest> getAllRequests();
+    
+    /**
+     * @param copyNames 为 false 时不复制班级、教师与课程名称(这些字段为空), 只填写名称编号,
+     *        需要显示时用 names().view 取回; 调度器以此方式加载申请
+     */
+    std::vector<LabRequest> getAllRequests(bool copyNames = true);
     LabRequest getRequest(int id);
     
+    /**
+     * @brief 批量导入实验室/申请
+     * @param next 填充下一行数据, 返回 false 表示输入结束
+     * @param batchSize 每个事务包含的行数
+     * @return 成功插入的行数, 出错时返回 -1(已提交的批次保留, 当前批次回滚)
+     *
+     * 整个导入只预编译一条 INSERT 语句并反复绑定参数, 每 batchSize 行提交一次事务。
+     */
+    long long addLaboratoryRows(const std::function<bool(LaboratoryRow&)>& next, int batchSize = 50000);
+    long long addRequestRows(const std::function<bool(RequestRow&)>& next, int batchSize = 50000);
+    
     // 课程安排管理
     bool clearSchedules();
     bool addSchedule(const Schedule& schedule);
+    bool addSchedules(const std::vector<Schedule>& schedules);  // 在单个事务中批量写入
+    
+    /**
+     * @brief 在单个事务中删除指定 id 的课程安排并写入新的课程安排
+     *
+     * 粘性重新生成(见 Scheduler::setStickyRegenerate)只改写发生变化的安排。
+     */
+    bool updateSchedules(const std::vector<int>& removedIds, const std::vector<Schedule>& schedules);
     std::vector<Schedule> getAllSchedules();
     std::vector<Schedule> getSchedulesByLab(int labId);
     std::vector<Schedule> getSchedulesByClass(const std::string& classId);
+    std::vector<Schedule> getSchedulesByTeacher(const std::string& teacher);  // 按时间段排序
+    
+    /**
+     * @brief 流式导出课表(按时间段、实验室排序), 每行调用一次 row, 不在内存中保存整个结果
+     */
+    bool exportSchedules(const std::function<void(const ScheduleExportRow&)>& row);
     
     // 清空所有数据
     bool clearAllData();
     
+    // 设备特性名称表(加载实验室和申请时填充)
+    const FeatureRegistry& featureRegistry() const { return features; }
+    
+    /**
+     * @brief 名称驻留表: 加载时登记实验室地址与申请的班级、教师、课程名称
+     *
+     * 同一数据库加载的数据中, 名称相同当且仅当编号相同; 不同数据库(如多校区分片)的编号互不相关。
+     * 可在任意线程使用; 向场景等内存中新建的申请登记名称时也使用本表, 以便与加载的申请比较。
+     */
+    StringInterner& names() const { return interner; }
+    
+    /**
+     * @brief 自打开连接以来的访问计数(语句数、读出行数、写入行数)
+     *
+     * 语句数由 sqlite3_trace 回调累加(包括连接池中的读连接), 读出行数在各查询的逐行读取中累加,
+     * 写入行数取自 sqlite3_total_changes。
+     * 调用方取两次快照之差得到某一段操作的计数。
+     */
+    DatabaseCounters counters() const;
+    
+    /**
+     * @brief 课表版本号: 每次可能改变课表查询结果的写操作(清空/写入课程安排、删除实验室或申请)后递增
+     *
+     * 查询缓存(见 timetable_cache.h)比较版本号判断快照是否过期, 可在任意线程读取。
+     */
+    uint64_t scheduleVersion() const { return scheduleRevision.load(std::memory_order_acquire); }
+    
+    /**
+     * @brief 时间段列表的存储格式 "week,day,period;..."
+     *
+     * 反序列化跳过无法解析的项, 不检查时间段是否在日历范围内(导入时由 validateSlotList 校验)。
+     */
+    static std::string serializeTimeSlots(const std::vector<TimeSlot>& slots);
+    static std::vector<TimeSlot> deserializeTimeSlots(const std::string& data);
+    
+    /**
+     * @brief 时间槽位图的存储格式: 按时间槽编号的小端字节序位串, 共 ⌈kSlotCount/8⌉ 字节
+     *
+     * 解码时忽略超出日历范围的位, 字节数不足时缺少的时间槽视为未设置。
+     */
+    static std::string encodeSlotMask(Calendar::Mask mask);
+    static Calendar::Mask decodeSlotMask(const void* data, int bytes);
+    
 private:
-    sqlite3* db;
+    // 查询期间独占的连接: 连接池模式下从池中借出, 析构时归还; 单连接模式下即为唯一的连接
+    class ReaderLease {
+    public:
+        ReaderLease(Database* owner, sqlite3* connection) : owner(owner), connection(connection) {}
+        ~ReaderLease() {
+            if (owner) owner->releaseReader(connection);
+        }
+        ReaderLease(const ReaderLease&) = delete;
+        ReaderLease& operator=(const ReaderLease&) = delete;
+        
+        sqlite3* get() const { return connection; }
+        
+    private:
+        Database* owner;
+        sqlite3* connection;
+    };
+    
+    sqlite3* db;  // 写连接(单连接模式下也用于查询)
     std::string dbPath;
+    int requestedReaders;
+    std::vector<sqlite3*> readers;      // 连接池中的全部只读连接
+    std::vector<sqlite3*> idleReaders;  // 当前空闲的只读连接
+    std::mutex readerMutex;
+    std::condition_variable readerReleased;
+    std::mutex writerMutex;             // 串行化所有修改操作
+    FeatureRegistry features;
+    std::mutex featureMutex;            // 多个读连接同时加载时保护设备特性名称表
+    mutable StringInterner interner;    // 内部加锁, 多个读连接可同时登记
+    mutable DatabaseCounters stats;  // 由 SQLite 回调与 stepRow 累加, 只通过 atomic_ref 访问
+    std::atomic<uint64_t> scheduleRevision{0};
+    
+    void bumpScheduleVersion() { scheduleRevision.fetch_add(1, std::memory_order_release); }
+    
+    ReaderLease acquireReader();
+    void releaseReader(sqlite3* connection);
+    bool openReaders();
+    FeatureMask internFeatures(const std::vector<std::string>& names);
+    
+    // sqlite3_step, 返回一行时计入读出行数
+    int stepRow(sqlite3_stmt* stmt) const;
     
     bool executeSQL(const std::string& sql);
-    std::string serializeTimeSlots(const std::vector<TimeSlot>& slots);
-    std::vector<TimeSlot> deserializeTimeSlots(const std::string& data);
+    long long insertRows(const std::string& sql, const std::function<bool(sqlite3_stmt*)>& bindNext,
+                         int batchSize);
+    bool addColumnIfMissing(const std::string& table, const std::string& column,
+                            const std::string& definition);
+    std::string serializeFeatures(const std::vector<std::string>& names);
+    std::vector<std::string> deserializeFeatures(const std::string& data);
 };
 
 #endif // DATABASE_H
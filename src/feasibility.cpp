@@ -0,0 +1,224 @@
+#include "feasibility.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <map>
+
+SlotSupply::SlotSupply(std::pmr::memory_resource* resource)
+    : bandCapacities(resource), labBand(resource), cumulative(resource), open(resource) {
+}
+
+void SlotSupply::reset(const OccupancyGrid& grid) {
+    const auto& byCapacity = grid.labsByCapacity();
+    bandCapacities.clear();
+    labBand.assign(grid.labCount(), 0);
+    for (int labIndex : byCapacity) {
+        int capacity = grid.capacity(labIndex);
+        if (bandCapacities.empty() || bandCapacities.back() != capacity) {
+            bandCapacities.push_back(capacity);
+        }
+        labBand[labIndex] = bandCount() - 1;
+    }
+
+    // 先按档统计空闲单元, 再沿档累加
+    cumulative.assign(bandCapacities.size() * kSlotCount, 0);
+    for (int labIndex = 0; labIndex < grid.labCount(); labIndex++) {
+        SlotMask free = grid.freeMask(labIndex);
+        int* row = &cumulative[labBand[labIndex] * kSlotCount];
+        while (free) {
+            row[lowestSlot(free)]++;
+            clearLowestSlot(free);
+        }
+    }
+    open.assign(bandCapacities.size(), SlotMask(0));
+    for (int band = 0; band < bandCount(); band++) {
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            if (band > 0) {
+                cumulative[band * kSlotCount + slot] += cumulative[(band - 1) * kSlotCount + slot];
+            }
+            if (cumulative[band * kSlotCount + slot] > 0) {
+                open[band] |= slotBit(slot);
+            }
+        }
+    }
+}
+
+int SlotSupply::bandOf(int studentCount) const {
+    // bandCapacities 为降序, 找到第一个容量 < studentCount 的档
+    auto it = std::upper_bound(bandCapacities.begin(), bandCapacities.end(),
+                               studentCount, std::greater<int>());
+    return static_cast<int>(it - bandCapacities.begin()) - 1;
+}
+
+void SlotSupply::occupy(int labIndex, int slot) {
+    for (int band = labBand[labIndex]; band < bandCount(); band++) {
+        if (--cumulative[band * kSlotCount + slot] == 0) {
+            open[band] &= ~slotBit(slot);
+        }
+    }
+}
+
+void SlotSupply::release(int labIndex, int slot) {
+    for (int band = labBand[labIndex]; band < bandCount(); band++) {
+        if (cumulative[band * kSlotCount + slot]++ == 0) {
+            open[band] |= slotBit(slot);
+        }
+    }
+}
+
+/**
+ * @brief 最大流(Dinic 算法), 用于在松弛问题上求最大匹配
+ */
+class MaxFlow {
+public:
+    explicit MaxFlow(int nodeCount) : adjacency(nodeCount), level(nodeCount), cursor(nodeCount) {}
+
+    void addEdge(int from, int to, int capacity) {
+        adjacency[from].push_back(static_cast<int>(edges.size()));
+        edges.push_back({to, capacity});
+        adjacency[to].push_back(static_cast<int>(edges.size()));
+        edges.push_back({from, 0});
+    }
+
+    long long run(int source, int sink) {
+        long long total = 0;
+        while (buildLevels(source, sink)) {
+            std::fill(cursor.begin(), cursor.end(), 0);
+            while (int pushed = augment(source, sink, INT_MAX)) {
+                total += pushed;
+            }
+        }
+        return total;
+    }
+
+private:
+    struct Edge {
+        int to;
+        int capacity;  // 剩余容量, 反向边与正向边相邻(下标异或 1)
+    };
+
+    std::vector<Edge> edges;
+    std::vector<std::vector<int>> adjacency;
+    std::vector<int> level;
+    std::vector<size_t> cursor;
+
+    bool buildLevels(int source, int sink) {
+        std::fill(level.begin(), level.end(), -1);
+        std::vector<int> queue{source};
+        level[source] = 0;
+        for (size_t head = 0; head < queue.size(); head++) {
+            int node = queue[head];
+            for (int edge : adjacency[node]) {
+                if (edges[edge].capacity > 0 && level[edges[edge].to] < 0) {
+                    level[edges[edge].to] = level[node] + 1;
+                    queue.push_back(edges[edge].to);
+                }
+            }
+        }
+        return level[sink] >= 0;
+    }
+
+    int augment(int node, int sink, int limit) {
+        if (node == sink) {
+            return limit;
+        }
+        for (size_t& i = cursor[node]; i < adjacency[node].size(); i++) {
+            Edge& edge = edges[adjacency[node][i]];
+            if (edge.capacity <= 0 || level[edge.to] != level[node] + 1) {
+                continue;
+            }
+            int pushed = augment(edge.to, sink, std::min(limit, edge.capacity));
+            if (pushed > 0) {
+                edge.capacity -= pushed;
+                edges[adjacency[node][i] ^ 1].capacity += pushed;
+                return pushed;
+            }
+        }
+        return 0;
+    }
+};
+
+FeasibilityReport analyzeFeasibility(const OccupancyGrid& grid, const std::vector<LabRequest>& requests,
+                                     std::span<const SlotMask> allowedMasks) {
+    FeasibilityReport report;
+    report.analyzed = true;
+    report.requests = static_cast<int>(requests.size());
+
+    SlotSupply supply;
+    supply.reset(grid);
+    const int bands = supply.bandCount();
+    report.slotDemand.assign(bands * kSlotCount, 0);
+    report.slotSupply.assign(bands * kSlotCount, 0);
+    for (int band = 0; band < bands; band++) {
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            report.slotSupply[band * kSlotCount + slot] = supply.freeCells(band, slot);
+        }
+    }
+
+    // 可能被分配的申请按 (档, 允许且有空闲单元的时间槽) 分组, 同组申请在松弛问题中可以互换
+    std::map<std::pair<int, SlotMask>, int> groups;
+    std::vector<int> bandRequests(bands, 0);
+    std::vector<SlotMask> bandSlots(bands, SlotMask(0));
+    for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+        const LabRequest& request = requests[i];
+        int band = supply.bandOf(request.studentCount);
+        SlotMask usable = allowedMasks[i] & supply.openSlots(band);
+        if (!usable || grid.feasibleCells(usable, request.studentCount, request.requiredMask) == 0) {
+            report.unplaceable.push_back(i);
+            continue;
+        }
+        groups[{band, usable}]++;
+        bandRequests[band]++;
+        bandSlots[band] |= usable;
+        for (SlotMask slots = usable; slots; clearLowestSlot(slots)) {
+            report.slotDemand[band * kSlotCount + lowestSlot(slots)]++;
+        }
+    }
+
+    // 每档的 Hall 条件: 只能使用第 0..b 档实验室的申请集合, 其邻域不超过这些实验室在相应时间槽的空闲单元
+    int requestsSoFar = 0;
+    SlotMask slotsSoFar = 0;
+    for (int band = 0; band < bands; band++) {
+        requestsSoFar += bandRequests[band];
+        slotsSoFar |= bandSlots[band];
+        TierDemand tier;
+        tier.minCapacity = supply.bandCapacity(band);
+        tier.labs = grid.capacityTier(tier.minCapacity);
+        tier.requests = requestsSoFar;
+        for (SlotMask slots = slotsSoFar; slots; clearLowestSlot(slots)) {
+            tier.cells += supply.freeCells(band, lowestSlot(slots));
+        }
+        tier.shortfall = static_cast<int>(std::max<long long>(0, tier.requests - tier.cells));
+        report.hallShortfall = std::max(report.hallShortfall, tier.shortfall);
+        report.tiers.push_back(tier);
+    }
+
+    // 网络: 源点 -> 申请组(容量为组内申请数) -> (档, 时间槽) -> 汇点(容量为本档在该时间槽的空闲单元数);
+    // (b, s) -> (b-1, s) 的边使第 b 档的申请也能使用容量更大的档
+    const int cellBase = 1;
+    const int groupBase = cellBase + bands * kSlotCount;
+    const int sink = groupBase + static_cast<int>(groups.size());
+    MaxFlow flow(sink + 1);
+    for (int band = 0; band < bands; band++) {
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            int node = cellBase + band * kSlotCount + slot;
+            int free = supply.freeCells(band, slot) - (band > 0 ? supply.freeCells(band - 1, slot) : 0);
+            if (free > 0) {
+                flow.addEdge(node, sink, free);
+            }
+            if (band > 0) {
+                flow.addEdge(node, node - kSlotCount, INT_MAX);
+            }
+        }
+    }
+    int groupNode = groupBase;
+    for (const auto& [key, count] : groups) {
+        flow.addEdge(0, groupNode, count);
+        for (SlotMask slots = key.second; slots; clearLowestSlot(slots)) {
+            flow.addEdge(groupNode, cellBase + key.first * kSlotCount + lowestSlot(slots), INT_MAX);
+        }
+        groupNode++;
+    }
+    report.maxPlacements = static_cast<int>(flow.run(0, sink));
+    return report;
+}
@@ -0,0 +1,90 @@
+#ifndef FEASIBILITY_H
+#define FEASIBILITY_H
+
+#include "lab_types.h"
+#include "occupancy.h"
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief 按容量档次统计的各时间槽空闲单元数
+ *
+ * 实验室按容量分档(每种不同的容量为一档, 第 0 档容量最大)。
+ * 能容纳 n 人的实验室恰好是第 0..b 档(b 为 bandOf(n)),
+ * 因此 "容量 >= n 且在时间槽 s 空闲的实验室数" 就是第 b 档在 s 上的累计空闲单元数。
+ *
+ * openSlots(b) 是累计空闲单元数大于 0 的时间槽位图: 分配内核用它在 O(1) 内判断申请已无处可放,
+ * 并在扫描实验室之前跳过没有任何足够大的空闲实验室的时间段。
+ * 每次占用/释放单元更新 O(档数) 个计数。
+ */
+class SlotSupply {
+public:
+    explicit SlotSupply(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief 按占用表的实验室容量分档, 并统计当前的空闲单元
+     */
+    void reset(const OccupancyGrid& grid);
+
+    int bandCount() const { return static_cast<int>(bandCapacities.size()); }
+
+    // 第 band 档的容量(该档所有实验室容量相同)
+    int bandCapacity(int band) const { return bandCapacities[band]; }
+
+    /**
+     * @brief 能容纳 studentCount 人的最后一档, 没有足够大的实验室时返回 -1
+     */
+    int bandOf(int studentCount) const;
+
+    SlotMask openSlots(int band) const { return band < 0 ? SlotMask(0) : open[band]; }
+
+    // 第 0..band 档实验室在 slot 上的空闲单元数
+    int freeCells(int band, int slot) const { return cumulative[band * kSlotCount + slot]; }
+
+    void occupy(int labIndex, int slot);
+    void release(int labIndex, int slot);
+
+private:
+    std::pmr::vector<int> bandCapacities;  // 各档容量(降序)
+    std::pmr::vector<int> labBand;         // labIndex -> 档
+    std::pmr::vector<int> cumulative;      // band × kSlotCount + slot -> 第 0..band 档的空闲单元数
+    std::pmr::vector<SlotMask> open;       // band -> 累计空闲单元数大于 0 的时间槽
+};
+
+// 一个容量档次的供需情况
+struct TierDemand {
+    int minCapacity = 0;    // 本档实验室的容量
+    int labs = 0;           // 第 0..本档 的实验室数
+    int requests = 0;       // 只能使用第 0..本档 实验室的申请数(累计)
+    long long cells = 0;    // 这些申请允许的时间槽内, 第 0..本档 实验室的空闲单元数
+    int shortfall = 0;      // max(0, requests - cells): 这些申请中至少有这么多无法分配
+};
+
+/**
+ * @brief 求解前的可行性预检结果
+ *
+ * maxPlacements 是任何分配方法都无法超过的成功数上界:
+ * 在忽略设备特性(同档实验室视为相同)的松弛问题上求最大匹配(最大流), 由 Hall 定理它恰为
+ * 申请数减去最大 Hall 缺口; 没有设备要求时即为精确的最大可分配数。
+ */
+struct FeasibilityReport {
+    bool analyzed = false;             // 教室共享模式下一个单元可容纳多个班级, 不做预检
+    int requests = 0;
+    std::vector<int> unplaceable;      // 没有任何可行单元(容量、设备、允许时间段、空闲)的申请下标
+    int maxPlacements = 0;             // 可分配数上界
+    int hallShortfall = 0;             // 各档 shortfall 的最大值(无法分配数的下界之一)
+    std::vector<TierDemand> tiers;     // 按档(容量降序)
+    // 档 × 时间槽: 本档申请中允许该时间槽的数量, 与第 0..本档 实验室在该时间槽的空闲单元数
+    std::vector<int> slotDemand;
+    std::vector<int> slotSupply;
+};
+
+/**
+ * @brief 在给定的初始占用上分析供需, 不修改占用表
+ * @param allowedMasks 每个申请允许的时间槽位图(见 buildAllowedMasks)
+ */
+FeasibilityReport analyzeFeasibility(const OccupancyGrid& grid, const std::vector<LabRequest>& requests,
+                                     std::span<const SlotMask> allowedMasks);
+
+#endif // FEASIBILITY_H
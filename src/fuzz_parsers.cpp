@@ -0,0 +1,130 @@
+#include "bulk_io.h"
+#include "csv.h"
+#include "database.h"
+#include "occupancy.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// 解析器模糊测试入口(libFuzzer): 输入的第一个字节选择目标, 其余字节为目标的输入文本
+//   0: Database::deserializeTimeSlots 与 validateSlotList, 时间槽位图的存储格式
+//   1: CsvReader(逗号与制表符分隔)
+//   2: 实验室 CSV 导入
+//   3: 申请 CSV 导入, 并读回检查时间段
+// 不变量被破坏时调用 abort(), 由 libFuzzer 记录触发的输入。
+// 未使用 -fsanitize=fuzzer 编译时(定义 FUZZ_STANDALONE)提供 main, 依次重放命令行给出的输入文件。
+
+static void check(bool condition) {
+    if (!condition) {
+        std::abort();
+    }
+}
+
+static void fuzzSlotText(const std::string& text) {
+    std::vector<TimeSlot> slots = Database::deserializeTimeSlots(text);
+    int count = 0;
+    if (validateSlotList(text, count)) {
+        check(static_cast<int>(slots.size()) == count);
+        for (const auto& slot : slots) {
+            check(slotIndex(slot) >= 0);
+        }
+    }
+    // 读出的时间段重新序列化后必须能原样读回
+    check(Database::deserializeTimeSlots(Database::serializeTimeSlots(slots)) == slots);
+    // 位图存储格式: 任意字节解码后只含日历范围内的时间槽, 重新编码后能原样读回
+    SlotMask mask = Database::decodeSlotMask(text.data(), static_cast<int>(text.size()));
+    check((mask & ~kAllSlots) == 0);
+    std::string bytes = Database::encodeSlotMask(mask);
+    check(Database::decodeSlotMask(bytes.data(), static_cast<int>(bytes.size())) == mask);
+}
+
+static void fuzzCsv(std::string text) {
+    for (char delimiter : {',', '\t'}) {
+        std::string buffer = text;  // CsvReader 原地改写缓冲区
+        const char* begin = buffer.data();
+        const char* end = begin + buffer.size();
+        CsvReader reader(buffer.data(), buffer.size(), delimiter);
+        std::vector<std::string_view> fields;
+        long long lastLine = 0;
+        while (reader.nextRow(fields)) {
+            check(!fields.empty());
+            check(reader.lineNumber() > lastLine);
+            lastLine = reader.lineNumber();
+            for (std::string_view field : fields) {
+                check(field.empty() || (field.data() >= begin && field.data() + field.size() <= end));
+            }
+        }
+    }
+}
+
+static Database& fuzzDatabase() {
+    static Database db(":memory:");
+    static bool ready = db.initialize();
+    check(ready);
+    return db;
+}
+
+static void fuzzImport(std::string text, bool requests) {
+    Database& db = fuzzDatabase();
+    db.clearAllData();
+    ImportReport report;
+    bool ok = requests ? importRequestsBuffer(db, text.data(), text.size(), ',', report)
+                       : importLaboratoriesBuffer(db, text.data(), text.size(), ',', report);
+    if (!ok) {
+        return;
+    }
+    check(report.inserted + report.rejected == report.rows);
+    if (requests) {
+        // 导入时已校验: 期望时间段非空, 所有时间段都在日历范围内
+        std::vector<LabRequest> loaded = db.getAllRequests();
+        check(static_cast<long long>(loaded.size()) == report.inserted);
+        for (const auto& request : loaded) {
+            check(!request.preferredSlots.empty());
+            for (const auto& slot : request.preferredSlots) {
+                check(slotIndex(slot) >= 0);
+            }
+            for (const auto& slot : request.excludedSlots) {
+                check(slotIndex(slot) >= 0);
+            }
+        }
+    } else {
+        std::vector<Laboratory> loaded = db.getAllLaboratories();
+        check(static_cast<long long>(loaded.size()) == report.inserted);
+        for (const auto& lab : loaded) {
+            check(lab.capacity > 0 && !lab.location.empty() && (lab.blackout & ~kAllSlots) == 0);
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    std::string text(reinterpret_cast<const char*>(data) + 1, size - 1);
+    switch (data[0] % 4) {
+    case 0: fuzzSlotText(text); break;
+    case 1: fuzzCsv(text); break;
+    case 2: fuzzImport(text, false); break;
+    case 3: fuzzImport(text, true); break;
+    }
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "无法打开文件: %s\n", argv[i]);
+            return 1;
+        }
+        std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,93 @@
+#include "instrumentation.h"
+#include <cstdio>
+#include <iostream>
+#include <set>
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::Clear:     return "clear";
+    case Phase::Load:      return "load";
+    case Phase::Prepare:   return "prepare";
+    case Phase::WarmStart: return "warm-start";
+    case Phase::Partition: return "partition";
+    case Phase::Solve:     return "solve";
+    case Phase::Preferred: return "preferred";
+    case Phase::Fallback:  return "fallback";
+    case Phase::Preempt:   return "preempt";
+    case Phase::Report:    return "report";
+    case Phase::Persist:   return "persist";
+    case Phase::Count:     break;
+    }
+    return "unknown";
+}
+
+void SolverCounters::add(const SolverCounters& other) {
+    requests += other.requests;
+    labsScanned += other.labsScanned;
+    bitTests += other.bitTests;
+    preferredPlacements += other.preferredPlacements;
+    fallbackPlacements += other.fallbackPlacements;
+    hopelessSkipped += other.hopelessSkipped;
+    speculativeConflicts += other.speculativeConflicts;
+    preferredNanos += other.preferredNanos;
+    fallbackNanos += other.fallbackNanos;
+    confirmNanos += other.confirmNanos;
+}
+
+void RunProfile::start() {
+    *this = RunProfile();
+    origin = monotonicNanos();
+}
+
+bool RunProfile::writeChromeTrace(const std::string& path) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "无法创建跟踪文件: " << path << std::endl;
+        return false;
+    }
+
+    // 时间单位为微秒
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file,
+                 "{\"name\":\"generateSchedule\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":0,\"dur\":%.3f,"
+                 "\"args\":{\"requests\":%llu,\"labsScanned\":%llu,\"bitTests\":%llu,"
+                 "\"preferredPlacements\":%llu,\"fallbackPlacements\":%llu,\"hopelessSkipped\":%llu,"
+                 "\"speculativeConflicts\":%llu,"
+                 "\"preferredMs\":%.3f,\"fallbackMs\":%.3f,\"confirmMs\":%.3f,"
+                 "\"dbStatements\":%llu,\"dbRowsRead\":%llu,\"dbRowsWritten\":%llu}}",
+                 totalNanos / 1e3,
+                 static_cast<unsigned long long>(solver.requests),
+                 static_cast<unsigned long long>(solver.labsScanned),
+                 static_cast<unsigned long long>(solver.bitTests),
+                 static_cast<unsigned long long>(solver.preferredPlacements),
+                 static_cast<unsigned long long>(solver.fallbackPlacements),
+                 static_cast<unsigned long long>(solver.hopelessSkipped),
+                 static_cast<unsigned long long>(solver.speculativeConflicts),
+                 solver.preferredNanos / 1e6, solver.fallbackNanos / 1e6, solver.confirmNanos / 1e6,
+                 static_cast<unsigned long long>(database.statements),
+                 static_cast<unsigned long long>(database.rowsRead),
+                 static_cast<unsigned long long>(database.rowsWritten));
+
+    std::set<int> threads;
+    for (const auto& event : traceEvents) {
+        std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                     event.name, event.thread, event.startNanos / 1e3, event.durationNanos / 1e3);
+        threads.insert(event.thread);
+    }
+    for (int thread : threads) {
+        char name[32];
+        if (thread == 0) {
+            std::snprintf(name, sizeof(name), "scheduler");
+        } else {
+            std::snprintf(name, sizeof(name), "worker-%d", thread);
+        }
+        std::fprintf(file,
+                     ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\"}}",
+                     thread, name);
+    }
+    std::fprintf(file, "\n]}\n");
+
+    bool ok = std::ferror(file) == 0;
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,136 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 一次调度运行中的各阶段
+ */
+enum class Phase {
+    Clear,      // 清空旧的课程安排
+    Load,       // 从数据库读取实验室与申请
+    Prepare,    // 建立占用索引与允许时间槽位图
+    WarmStart,  // 粘性模式: 保留上一次课表中仍然有效的安排
+    Partition,  // 划分独立分量(并行模式)
+    Solve,      // 分配内核求解(墙钟时间)
+    Preferred,  // 其中: 期望时间段阶段(各线程累计, 需开启 Scheduler::setPhaseTiming)
+    Fallback,   // 其中: 备选时间段阶段(各线程累计, 需开启 Scheduler::setPhaseTiming)
+    Preempt,    // 抢占: 未分配的申请取代优先级类别更低的安排
+    Report,     // 合并结果并输出日志
+    Persist,    // 写入数据库
+    Count
+};
+
+const char* phaseName(Phase phase);
+
+// 单调时钟上的纳秒计数
+inline int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 分配内核的计数器
+ *
+ * 每个 GreedySolver 持有一份, 只在自己的线程中累加, 运行结束后由调度器合并。
+ */
+struct SolverCounters {
+    uint64_t requests = 0;             // 处理的申请数
+    uint64_t labsScanned = 0;          // 检查过的候选实验室数
+    uint64_t bitTests = 0;             // 占用位测试次数
+    uint64_t preferredPlacements = 0;  // 在期望时间段完成的分配
+    uint64_t fallbackPlacements = 0;   // 在备选时间段完成的分配
+    uint64_t hopelessSkipped = 0;      // 已没有足够大的空闲实验室(或同组已有申请失败)、未扫描即判定失败的申请数
+    uint64_t speculativeConflicts = 0; // 推测并行时推测位置已被更早的申请占用、需继续扫描的申请数
+    int64_t preferredNanos = 0;        // 期望时间段阶段耗时(仅开启 GreedySolver::setPhaseTiming 时)
+    int64_t fallbackNanos = 0;         // 备选时间段阶段耗时(仅开启 GreedySolver::setPhaseTiming 时)
+    int64_t confirmNanos = 0;          // 推测并行时调用线程按顺序确认(含冲突后继续扫描)的耗时
+
+    void add(const SolverCounters& other);
+};
+
+/**
+ * @brief 数据库访问计数器(由 SQLite 的跟踪回调累加)
+ */
+struct DatabaseCounters {
+    uint64_t statements = 0;   // 执行的语句数(预编译语句每次从头执行计一次)
+    uint64_t rowsRead = 0;     // 查询返回的行数
+    uint64_t rowsWritten = 0;  // 插入/更新/删除影响的行数
+};
+
+// Chrome trace-event 格式的一个完整事件("ph":"X")
+struct TraceEvent {
+    const char* name;
+    int thread;          // 0 为调用线程, 工作线程为 1..N
+    int64_t startNanos;  // 相对运行开始的时间
+    int64_t durationNanos;
+};
+
+/**
+ * @brief 一次调度运行的性能剖析数据: 阶段耗时、计数器与跟踪事件
+ *
+ * 始终编译、始终开启: 阶段计时只在阶段边界读取单调时钟,
+ * 内核计数器为普通整数累加, 开销可以忽略。
+ */
+class RunProfile {
+public:
+    /**
+     * @brief 清空数据并以当前时刻作为运行起点
+     */
+    void start();
+
+    // 相对运行起点的纳秒数
+    int64_t elapsed() const { return monotonicNanos() - origin; }
+    int64_t originNanos() const { return origin; }
+
+    void addPhase(Phase phase, int64_t nanos) { phaseNanos[static_cast<int>(phase)] += nanos; }
+    double phaseMillis(Phase phase) const { return phaseNanos[static_cast<int>(phase)] / 1e6; }
+
+    void addEvent(const TraceEvent& event) { traceEvents.push_back(event); }
+    const std::vector<TraceEvent>& events() const { return traceEvents; }
+
+    double totalMillis() const { return totalNanos / 1e6; }
+    void finish() { totalNanos = elapsed(); }
+
+    SolverCounters solver;
+    DatabaseCounters database;
+
+    /**
+     * @brief 以 Chrome trace-event JSON 格式写出(可在 chrome://tracing 或 Perfetto 中打开)
+     */
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    int64_t origin = 0;
+    int64_t totalNanos = 0;
+    int64_t phaseNanos[static_cast<int>(Phase::Count)] = {};
+    std::vector<TraceEvent> traceEvents;
+};
+
+/**
+ * @brief 作用域阶段计时器: 析构时累计阶段耗时并记录一个跟踪事件
+ */
+class ScopedPhase {
+public:
+    ScopedPhase(RunProfile& profile, Phase phase)
+        : profile(profile), phase(phase), start(profile.elapsed()) {}
+
+    ~ScopedPhase() {
+        int64_t duration = profile.elapsed() - start;
+        profile.addPhase(phase, duration);
+        profile.addEvent({phaseName(phase), 0, start, duration});
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    RunProfile& profile;
+    Phase phase;
+    int64_t start;
+};
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,38 @@
+#include "lab_features.h"
+#include <iostream>
+
+int FeatureRegistry::intern(const std::string& name) {
+    auto it = bits.find(name);
+    if (it != bits.end()) {
+        return it->second;
+    }
+    if (static_cast<int>(bitNames.size()) >= kMaxFeatures) {
+        std::cerr << "设备特性种类超过上限(" << kMaxFeatures << "): " << name << std::endl;
+        return -1;
+    }
+    int bit = static_cast<int>(bitNames.size());
+    bits.emplace(name, bit);
+    bitNames.push_back(name);
+    return bit;
+}
+
+FeatureMask FeatureRegistry::intern(const std::vector<std::string>& names) {
+    FeatureMask mask = 0;
+    for (const auto& name : names) {
+        int bit = intern(name);
+        if (bit >= 0) {
+            mask |= FeatureMask(1) << bit;
+        }
+    }
+    return mask;
+}
+
+std::vector<std::string> FeatureRegistry::namesOf(FeatureMask mask) const {
+    std::vector<std::string> result;
+    for (int bit = 0; bit < static_cast<int>(bitNames.size()); bit++) {
+        if (mask & (FeatureMask(1) << bit)) {
+            result.push_back(bitNames[bit]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,46 @@
+#ifndef LAB_FEATURES_H
+#define LAB_FEATURES_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 设备特性位图: 第 i 位表示编号为 i 的设备特性(如通风橱、GPU工作站、示波器)
+using FeatureMask = uint64_t;
+
+constexpr int kMaxFeatures = 64;
+
+/**
+ * @brief 设备特性名称表
+ *
+ * 数据库中以名称保存设备特性, 加载时将名称映射(intern)为位编号,
+ * 之后实验室与申请之间的匹配只需一次位运算:
+ * (lab.featureMask & request.requiredMask) == request.requiredMask
+ */
+class FeatureRegistry {
+public:
+    /**
+     * @brief 获取名称对应的位编号, 首次出现时分配新编号
+     * @return 位编号, 超过 kMaxFeatures 种时返回 -1
+     */
+    int intern(const std::string& name);
+
+    /**
+     * @brief 将名称列表转换为位图(无法分配编号的名称被忽略)
+     */
+    FeatureMask intern(const std::vector<std::string>& names);
+
+    /**
+     * @brief 将位图还原为名称列表(按位编号升序)
+     */
+    std::vector<std::string> namesOf(FeatureMask mask) const;
+
+    const std::vector<std::string>& names() const { return bitNames; }
+
+private:
+    std::unordered_map<std::string, int> bits;
+    std::vector<std::string> bitNames;
+};
+
+#endif // LAB_FEATURES_H
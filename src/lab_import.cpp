@@ -0,0 +1,72 @@
+#include "bulk_io.h"
+#include "database.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// 批量导入/导出工具(不需要Qt)
+// 用法: lab_import <数据库文件> labs <实验室.csv|.tsv>
+//       lab_import <数据库文件> requests <申请.csv|.tsv>
+//       lab_import <数据库文件> export <课表.csv|.tsv>
+
+static void printUsage() {
+    std::cerr << "用法: lab_import <数据库文件> labs|requests|export <文件.csv|.tsv>" << std::endl;
+    std::cerr << "  labs      导入实验室, 列: location, capacity[, features]" << std::endl;
+    std::cerr << "  requests  导入申请, 列: class_id, student_count, teacher, preferred_slots" << std::endl;
+    std::cerr << "            [, excluded_slots, priority, required_features, course, shareable]" << std::endl;
+    std::cerr << "  export    导出课表" << std::endl;
+    std::cerr << "时间段格式与数据库相同, 例如 \"9,0,0;9,1,0\"(周次,星期0-4,时段0-1)" << std::endl;
+}
+
+static void printReport(const char* what, const ImportReport& report) {
+    double rate = report.seconds > 0 ? report.inserted / report.seconds : 0;
+    std::cout << what << ": 读取 " << report.rows << " 行, 导入 " << report.inserted
+              << " 行, 跳过 " << report.rejected << " 行, 耗时 "
+              << std::fixed << std::setprecision(3) << report.seconds << " 秒 ("
+              << std::setprecision(0) << rate << " 行/秒)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        printUsage();
+        return 1;
+    }
+    std::string dbPath = argv[1];
+    std::string command = argv[2];
+    std::string filePath = argv[3];
+
+    Database db(dbPath);
+    if (!db.initialize()) {
+        std::cerr << "数据库初始化失败!" << std::endl;
+        return 1;
+    }
+
+    if (command == "labs" || command == "requests") {
+        ImportReport report;
+        bool ok = command == "labs" ? importLaboratoriesCsv(db, filePath, report)
+                                    : importRequestsCsv(db, filePath, report);
+        if (!ok) {
+            std::cerr << "导入失败!" << std::endl;
+            return 1;
+        }
+        printReport(command == "labs" ? "实验室" : "申请", report);
+        return report.rejected > 0 ? 2 : 0;
+    }
+
+    if (command == "export") {
+        long long rows = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (!exportSchedulesCsv(db, filePath, rows)) {
+            std::cerr << "导出失败!" << std::endl;
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "课表: 导出 " << rows << " 行, 耗时 " << std::fixed << std::setprecision(3)
+                  << seconds << " 秒" << std::endl;
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,50 @@
+#ifndef LAB_TYPES_H
+#define LAB_TYPES_H
+
+#include "calendar.h"
+#include "lab_features.h"
+#include "string_interner.h"
+#include <string>
+#include <vector>
+
+// 调度问题的数据类型: 只是普通的值, 不依赖任何存储方式(数据库读写见 database.h)
+
+// 实验室信息
+struct Laboratory {
+    int id;
+    std::string location;
+    int capacity;
+    std::vector<std::string> features;  // 设备特性名称(如 fume_hood, gpu)
+    FeatureMask featureMask = 0;        // 加载时由 features 映射得到
+    Calendar::Mask blackout = 0;        // 不可用的时间槽(维护、考试、其他院系的固定占用), 位 i 为编号 i 的时间槽
+    NameId locationName = kNoName;      // 加载时由 location 登记得到(见 Database::names)
+};
+
+// 实验申请
+struct LabRequest {
+    int id;
+    std::string classId;
+    int studentCount;
+    std::string teacher;
+    std::vector<TimeSlot> preferredSlots;  // 期望时间段 (√)
+    std::vector<TimeSlot> excludedSlots;   // 不期望时间段 (×)
+    int priority;  // 优先级 (基于申请时间)
+    std::vector<std::string> requiredFeatures;  // 所需设备特性名称
+    FeatureMask requiredMask = 0;               // 加载时由 requiredFeatures 映射得到
+    std::string course;      // 课程名称, 教室共享模式下同一课程的班级可共用实验室
+    bool shareable = false;  // 是否允许与其他课程的班级共用实验室
+    // 加载时由 classId/teacher/course 登记得到的名称编号(见 Database::names), 求解时只比较编号
+    NameId className = kNoName;
+    NameId teacherName = kNoName;
+    NameId courseName = kNoName;
+};
+
+// 课程安排结果
+struct Schedule {
+    int id;
+    int requestId;
+    int labId;
+    TimeSlot timeSlot;
+};
+
+#endif // LAB_TYPES_H
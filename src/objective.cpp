@@ -0,0 +1,154 @@
+#include "objective.h"
+#include <cctype>
+
+// 教学楼名称: 位置去掉末尾的数字(房间号)
+static std::string buildingOf(const std::string& location) {
+    size_t end = location.size();
+    while (end > 0 && std::isdigit(static_cast<unsigned char>(location[end - 1]))) {
+        end--;
+    }
+    return end > 0 ? location.substr(0, end) : location;
+}
+
+ScheduleEvaluator::ScheduleEvaluator(const std::vector<Laboratory>& labs,
+                                     const std::vector<LabRequest>& requests,
+                                     const ObjectiveWeights& weights)
+    : requests(requests), objectiveWeights(weights) {
+    std::unordered_map<std::string, int> buildingIds;
+    labCapacity.reserve(labs.size());
+    labBuilding.reserve(labs.size());
+    for (const auto& lab : labs) {
+        labCapacity.push_back(lab.capacity);
+        auto inserted = buildingIds.emplace(buildingOf(lab.location), static_cast<int>(buildingIds.size()));
+        labBuilding.push_back(inserted.first->second);
+    }
+
+    std::unordered_map<NameId, int> teacherIds;
+    requestTeacher.reserve(requests.size());
+    preferredMask.reserve(requests.size());
+    for (const auto& request : requests) {
+        auto inserted = teacherIds.emplace(request.teacherName, static_cast<int>(teacherIds.size()));
+        requestTeacher.push_back(inserted.first->second);
+        preferredMask.push_back(toSlotMask(request.preferredSlots));
+    }
+
+    cellStudents.assign(labs.size() * kSlotCount, 0);
+    dayLoad.assign(kSlotCount / kPeriodsPerDay, 0);
+    teacherSlotLoad.assign(teacherIds.size() * kSlotCount, 0);
+}
+
+void ScheduleEvaluator::clear() {
+    current = ObjectiveScores();
+    std::fill(cellStudents.begin(), cellStudents.end(), 0);
+    std::fill(dayLoad.begin(), dayLoad.end(), 0);
+    std::fill(teacherSlotLoad.begin(), teacherSlotLoad.end(), 0);
+    teacherBuildingLoad.clear();
+}
+
+int ScheduleEvaluator::buildingLoad(int teacher, int slot, int building) const {
+    auto it = teacherBuildingLoad.find(buildingKey(teacher, slot, building));
+    return it != teacherBuildingLoad.end() ? it->second : 0;
+}
+
+int ScheduleEvaluator::travelPairs(int teacher, int slot, int building) const {
+    int pairs = 0;
+    int period = slot % kPeriodsPerDay;
+    if (period > 0) {
+        pairs += teacherSlotLoad[teacher * kSlotCount + slot - 1] - buildingLoad(teacher, slot - 1, building);
+    }
+    if (period + 1 < kPeriodsPerDay) {
+        pairs += teacherSlotLoad[teacher * kSlotCount + slot + 1] - buildingLoad(teacher, slot + 1, building);
+    }
+    return pairs;
+}
+
+double ScheduleEvaluator::weighted(const ObjectiveScores& scores) const {
+    const ObjectiveWeights& w = objectiveWeights;
+    return w.placed * scores.placed + w.preferred * scores.preferred - w.fallback * scores.fallback -
+           w.wastedSeat * scores.wastedSeats - w.travel * scores.teacherTravel -
+           w.daySpread * scores.daySpread;
+}
+
+ObjectiveScores ScheduleEvaluator::change(int requestIndex, int labIndex, int slot, int sign) const {
+    const int students = requests[requestIndex].studentCount;
+    const int teacher = requestTeacher[requestIndex];
+    ObjectiveScores delta;
+
+    delta.placed = sign;
+    if (hasSlot(preferredMask[requestIndex], slot)) {
+        delta.preferred = sign;
+    } else {
+        delta.fallback = sign;
+    }
+
+    // 空置座位: 单元首次使用时增加 容量 - 人数, 加入已用单元时减少该班人数
+    int inCell = cellStudents[labIndex * kSlotCount + slot];
+    bool cellEmptyAfterwards = sign < 0 && inCell == students;
+    if ((sign > 0 && inCell == 0) || cellEmptyAfterwards) {
+        delta.wastedSeats = sign * (labCapacity[labIndex] - students);
+    } else {
+        delta.wastedSeats = -sign * students;
+    }
+
+    // (l ± 1)² - l²
+    int load = dayLoad[slot / kPeriodsPerDay];
+    delta.daySpread = sign > 0 ? 2LL * load + 1 : -2LL * load + 1;
+
+    delta.teacherTravel = sign * travelPairs(teacher, slot, labBuilding[labIndex]);
+
+    delta.total = weighted(delta);
+    return delta;
+}
+
+void ScheduleEvaluator::apply(int requestIndex, int labIndex, int slot, int sign) {
+    ObjectiveScores delta = change(requestIndex, labIndex, slot, sign);
+    current.placed += delta.placed;
+    current.preferred += delta.preferred;
+    current.fallback += delta.fallback;
+    current.wastedSeats += delta.wastedSeats;
+    current.teacherTravel += delta.teacherTravel;
+    current.daySpread += delta.daySpread;
+
+    const int teacher = requestTeacher[requestIndex];
+    cellStudents[labIndex * kSlotCount + slot] += sign * requests[requestIndex].studentCount;
+    dayLoad[slot / kPeriodsPerDay] += sign;
+    teacherSlotLoad[teacher * kSlotCount + slot] += sign;
+    int& count = teacherBuildingLoad[buildingKey(teacher, slot, labBuilding[labIndex])];
+    count += sign;
+    if (count == 0) {
+        teacherBuildingLoad.erase(buildingKey(teacher, slot, labBuilding[labIndex]));
+    }
+}
+
+void ScheduleEvaluator::place(int requestIndex, int labIndex, int slot) {
+    apply(requestIndex, labIndex, slot, 1);
+}
+
+void ScheduleEvaluator::remove(int requestIndex, int labIndex, int slot) {
+    apply(requestIndex, labIndex, slot, -1);
+}
+
+double ScheduleEvaluator::placeDelta(int requestIndex, int labIndex, int slot) const {
+    return change(requestIndex, labIndex, slot, 1).total;
+}
+
+double ScheduleEvaluator::moveDelta(int requestIndex, int fromLab, int fromSlot, int toLab, int toSlot) {
+    // 先撤销再计算放入的变化, 可正确处理同一单元、同一天或同一教师的相互影响, 最后恢复原状态
+    double removed = change(requestIndex, fromLab, fromSlot, -1).total;
+    apply(requestIndex, fromLab, fromSlot, -1);
+    double placed = change(requestIndex, toLab, toSlot, 1).total;
+    apply(requestIndex, fromLab, fromSlot, 1);
+    return removed + placed;
+}
+
+void ScheduleEvaluator::placeAll(std::span<const Placement> placements) {
+    for (const auto& placement : placements) {
+        place(placement.requestIndex, placement.labIndex, placement.slot);
+    }
+}
+
+ObjectiveScores ScheduleEvaluator::scores() const {
+    ObjectiveScores result = current;
+    result.total = weighted(result);
+    return result;
+}
@@ -0,0 +1,128 @@
+#ifndef OBJECTIVE_H
+#define OBJECTIVE_H
+
+#include "lab_types.h"
+#include "occupancy.h"
+#include "solver.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 目标函数各分量的权重(总分越高越好)
+ */
+struct ObjectiveWeights {
+    double placed = 100.0;      // 每个成功分配的申请
+    double preferred = 10.0;    // 每个在期望时间段完成的分配
+    double fallback = 5.0;      // 每个备选时间段分配的扣分
+    double wastedSeat = 0.1;    // 每个空置座位的扣分
+    double travel = 3.0;        // 教师同一天相邻时段换教学楼一次的扣分
+    double daySpread = 0.01;    // 每天课程数平方和的扣分(越均衡越小)
+};
+
+/**
+ * @brief 目标函数各分量的取值与加权总分
+ */
+struct ObjectiveScores {
+    int placed = 0;               // 成功分配的申请数
+    int preferred = 0;            // 在期望时间段完成的分配数
+    int fallback = 0;             // 在备选时间段完成的分配数
+    long long wastedSeats = 0;    // 已使用单元的空置座位总数(容量 - 单元内学生数)
+    long long teacherTravel = 0;  // 教师同一天相邻时段在不同教学楼上课的次数
+    long long daySpread = 0;      // Σ 每天课程数², 课程在各天之间越均衡越小
+    double total = 0;             // 加权总分
+};
+
+/**
+ * @brief 增量目标函数评估器
+ *
+ * 每次 place/remove 以 O(1)(教师换楼计数为均摊 O(1) 的哈希查找)更新所有分量,
+ * placeDelta/moveDelta 在不修改状态的情况下给出总分变化,
+ * 可供贪心、局部搜索、匹配等任意分配引擎在内层循环中调用。
+ *
+ * 教学楼取实验室位置去掉末尾数字后的部分(如 "实验楼A301" 属于 "实验楼A")。
+ * 教师按姓名的名称编号(LabRequest::teacherName)区分。同一单元可以有多个班级(教室共享模式), 空置座位按单元计算。
+ */
+class ScheduleEvaluator {
+public:
+    ScheduleEvaluator(const std::vector<Laboratory>& labs, const std::vector<LabRequest>& requests,
+                      const ObjectiveWeights& weights = ObjectiveWeights());
+
+    /**
+     * @brief 将申请 requestIndex 放入 (labIndex, slot)
+     */
+    void place(int requestIndex, int labIndex, int slot);
+
+    /**
+     * @brief 撤销一次 place
+     */
+    void remove(int requestIndex, int labIndex, int slot);
+
+    void move(int requestIndex, int fromLab, int fromSlot, int toLab, int toSlot) {
+        remove(requestIndex, fromLab, fromSlot);
+        place(requestIndex, toLab, toSlot);
+    }
+
+    /**
+     * @brief 放入 (labIndex, slot) 后总分的变化(不修改状态)
+     */
+    double placeDelta(int requestIndex, int labIndex, int slot) const;
+
+    /**
+     * @brief 从 (fromLab, fromSlot) 移到 (toLab, toSlot) 后总分的变化(返回时状态不变)
+     */
+    double moveDelta(int requestIndex, int fromLab, int fromSlot, int toLab, int toSlot);
+
+    /**
+     * @brief 依次放入一组分配结果
+     */
+    void placeAll(std::span<const Placement> placements);
+
+    void clear();
+
+    ObjectiveScores scores() const;
+    double total() const { return scores().total; }
+
+    const ObjectiveWeights& weights() const { return objectiveWeights; }
+
+private:
+    const std::vector<LabRequest>& requests;
+    ObjectiveWeights objectiveWeights;
+
+    // 由输入预先计算, 之后只读
+    std::vector<int> labCapacity;       // labIndex -> 容量
+    std::vector<int> labBuilding;       // labIndex -> 教学楼编号
+    std::vector<int> requestTeacher;    // requestIndex -> 教师编号
+    std::vector<SlotMask> preferredMask;
+
+    // 增量状态
+    ObjectiveScores current;
+    std::vector<int> cellStudents;      // labIndex × kSlotCount + slot -> 单元内学生数
+    std::vector<int> dayLoad;           // 周次与星期 -> 课程数
+    std::vector<int> teacherSlotLoad;   // 教师 × kSlotCount + slot -> 课程数
+    std::unordered_map<uint64_t, int> teacherBuildingLoad;  // (教师, slot, 教学楼) -> 课程数
+
+    static uint64_t buildingKey(int teacher, int slot, int building) {
+        return (uint64_t(uint32_t(teacher)) << 32) | (uint64_t(uint32_t(slot)) << 20) | uint32_t(building);
+    }
+
+    int buildingLoad(int teacher, int slot, int building) const;
+
+    /**
+     * @brief 教师在 slot 所在天的相邻时段中, 与 building 不同教学楼的课程数
+     */
+    int travelPairs(int teacher, int slot, int building) const;
+
+    /**
+     * @brief 放入(sign = 1)或撤销(sign = -1)时各分量的变化量(total 为加权总分的变化)
+     */
+    ObjectiveScores change(int requestIndex, int labIndex, int slot, int sign) const;
+
+    void apply(int requestIndex, int labIndex, int slot, int sign);
+
+    double weighted(const ObjectiveScores& scores) const;
+};
+
+#endif // OBJECTIVE_H
@@ -0,0 +1,122 @@
+#include "occupancy.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+SlotMask toSlotMask(const std::vector<TimeSlot>& slots) {
+    SlotMask mask = 0;
+    for (const auto& slot : slots) {
+        int index = slotIndex(slot);
+        if (index >= 0) {
+            mask |= slotBit(index);
+        }
+    }
+    return mask;
+}
+
+OccupancyGrid::OccupancyGrid(std::pmr::memory_resource* resource)
+    : occupied(resource), byCapacity(resource), sortedCapacities(resource),
+      rankOf(resource), features(resource), cells(resource) {}
+
+OccupancyGrid::OccupancyGrid(const OccupancyGrid& other, std::pmr::memory_resource* resource)
+    : occupied(other.occupied, resource), byCapacity(other.byCapacity, resource),
+      sortedCapacities(other.sortedCapacities, resource), rankOf(other.rankOf, resource),
+      features(other.features, resource), cells(other.cells, resource) {}
+
+void OccupancyGrid::reset(const std::vector<Laboratory>& labs) {
+    int count = static_cast<int>(labs.size());
+    occupied.resize(count);
+    features.resize(count);
+    for (int i = 0; i < count; i++) {
+        occupied[i] = labs[i].blackout & kAllSlots;
+        features[i] = labs[i].featureMask;
+    }
+
+    byCapacity.resize(count);
+    for (int i = 0; i < count; i++) {
+        byCapacity[i] = i;
+    }
+    // 同容量的实验室保持原有顺序
+    std::sort(byCapacity.begin(), byCapacity.end(), [&labs](int a, int b) {
+        if (labs[a].capacity != labs[b].capacity) {
+            return labs[a].capacity > labs[b].capacity;
+        }
+        return a < b;
+    });
+
+    sortedCapacities.resize(count);
+    rankOf.resize(count);
+    for (int rank = 0; rank < count; rank++) {
+        sortedCapacities[rank] = labs[byCapacity[rank]].capacity;
+        rankOf[byCapacity[rank]] = rank;
+    }
+
+    if (!cells.empty()) {
+        cells.assign(std::max(count * kSlotCount, 1), 0);
+    }
+}
+
+void OccupancyGrid::setSeatMode(bool enabled) {
+    if (enabled) {
+        // 没有实验室时也保留一个元素, 使 seatMode() 仍能反映启用状态
+        cells.assign(std::max<size_t>(occupied.size() * kSlotCount, 1), 0);
+    } else {
+        cells.clear();
+    }
+}
+
+void OccupancyGrid::occupySeats(int labIndex, int slot, int studentCount,
+                                CourseKey course, bool shareable) {
+    uint32_t& state = cells[labIndex * kSlotCount + slot];
+    if (isFree(labIndex, slot)) {
+        occupy(labIndex, slot);
+        uint32_t seats = static_cast<uint32_t>(std::clamp(capacity(labIndex), 0, 0xFFFF));
+        state = seats | (static_cast<uint32_t>(course & kMaxCourseKeys) << kCourseShift) |
+                (shareable ? kShareableBit : 0);
+    } else {
+        // 共同课程不一致时清零, 可共享标记取所有入座班级的与
+        uint32_t current = (state >> kCourseShift) & kMaxCourseKeys;
+        uint32_t common = current == course ? current : 0;
+        state = (state & kShareableBit & (shareable ? kShareableBit : 0)) |
+                (common << kCourseShift) | (state & kSeatMask);
+    }
+    int remaining = static_cast<int>(state & kSeatMask) - studentCount;
+    state = (state & ~kSeatMask) | static_cast<uint32_t>(std::max(remaining, 0));
+}
+
+void OccupancyGrid::release(int labIndex, int slot, int studentCount) {
+    if (cells.empty()) {
+        occupied[labIndex] &= ~slotBit(slot);
+        return;
+    }
+    assert(!isFree(labIndex, slot));
+    uint32_t& state = cells[labIndex * kSlotCount + slot];
+    int seats = static_cast<int>(state & kSeatMask) + studentCount;
+    int full = std::clamp(capacity(labIndex), 0, 0xFFFF);
+    // 归还后超过容量说明该班级并未在此入座, 或同一班级被撤销了两次
+    assert(seats <= full);
+    if (seats >= full) {
+        occupied[labIndex] &= ~slotBit(slot);
+        state = 0;
+    } else {
+        state = (state & ~kSeatMask) | static_cast<uint32_t>(seats);
+    }
+}
+
+int OccupancyGrid::capacityTier(int studentCount) const {
+    // sortedCapacities 为降序, 找到第一个容量 < studentCount 的位置
+    auto it = std::upper_bound(sortedCapacities.begin(), sortedCapacities.end(),
+                               studentCount, std::greater<int>());
+    return static_cast<int>(it - sortedCapacities.begin());
+}
+
+int OccupancyGrid::feasibleCellsInTier(SlotMask allowed, int tier, FeatureMask required) const {
+    int cells = 0;
+    for (int rank = 0; rank < tier; rank++) {
+        int labIndex = byCapacity[rank];
+        if (hasFeatures(labIndex, required)) {
+            cells += slotCount(allowed & ~occupied[labIndex]);
+        }
+    }
+    return cells;
+}
@@ -0,0 +1,203 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include "calendar.h"
+#include "lab_types.h"
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// 日历形状(见 calendar.h): 第9周和第10周, 每周5天(周一到周五), 每天2个时段(上午/下午)
+constexpr int kFirstWeek = Calendar::kFirstWeek;
+constexpr int kWeekCount = Calendar::kWeekCount;
+constexpr int kDaysPerWeek = Calendar::kDaysPerWeek;
+constexpr int kPeriodsPerDay = Calendar::kPeriodsPerDay;
+constexpr int kSlotCount = Calendar::kSlotCount;
+
+// 时间槽位图: 第 i 位表示编号为 i 的时间槽, 宽度由日历大小在编译期确定
+using SlotMask = Calendar::Mask;
+
+constexpr SlotMask kAllSlots = Calendar::allSlots();
+
+/**
+ * @brief 时间槽编号: ((week - 9) × 5 + day) × 2 + period
+ * @return 编号(0..kSlotCount-1), 不在日历范围内时返回 -1
+ */
+constexpr int slotIndex(const TimeSlot& slot) {
+    return Calendar::index(slot);
+}
+
+constexpr TimeSlot slotFromIndex(int index) {
+    return Calendar::slot(index);
+}
+
+constexpr SlotMask slotBit(int index) {
+    return singleSlot<SlotMask>(index);
+}
+
+/**
+ * @brief 某一周的全部时间槽(周次不在日历范围内时为空)
+ */
+constexpr SlotMask weekSlots(int week) {
+    SlotMask mask = 0;
+    for (int index = 0; index < kSlotCount; index++) {
+        if (slotFromIndex(index).week == week) {
+            mask |= slotBit(index);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief 将时间槽列表转换为位图, 日历范围外的时间槽被忽略
+ */
+SlotMask toSlotMask(const std::vector<TimeSlot>& slots);
+
+// 教室共享模式下的课程编号: 0 表示不参与按课程共用(只能凭可共享标记与其他班级共用)
+using CourseKey = uint16_t;
+constexpr int kMaxCourseKeys = 0x7FFF;
+
+/**
+ * @brief 实验室占用索引与容量索引
+ *
+ * 占用索引: 每个实验室一个时间槽位图, 检查/标记占用均为 O(1) 位运算。
+ * 容量索引: 实验室按容量降序排列, 容量 >= n 的实验室恰好是该序列的一个前缀,
+ * 因此"能容纳 n 人的实验室"可用前缀长度(tier)表示。
+ *
+ * 同时保存各实验室的设备特性位图, 便于按设备要求筛选候选实验室。
+ * 可选的座位级占用(见 setSeatMode)支持多个小班共用一个实验室时间段。
+ *
+ * 实验室以其在 labs 列表中的下标(labIndex)标识。
+ * 所有数组都从构造时给定的内存资源分配, 便于放入单次运行的内存区域(见 arena.h)。
+ */
+class OccupancyGrid {
+public:
+    explicit OccupancyGrid(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief 复制另一个占用表, 新表的数组从 resource 分配
+     */
+    OccupancyGrid(const OccupancyGrid& other, std::pmr::memory_resource* resource);
+
+    OccupancyGrid(const OccupancyGrid& other) = default;
+    OccupancyGrid& operator=(const OccupancyGrid& other) = default;
+
+    /**
+     * @brief 按实验室列表重建索引, 各实验室的不可用时间槽(Laboratory::blackout)预先标记为已占用
+     *
+     * 不可用时间槽与已分配的单元一样表现为占用位, 候选扫描、剪枝与可行性预检都不需要额外检查。
+     */
+    void reset(const std::vector<Laboratory>& labs);
+
+    int labCount() const { return static_cast<int>(occupied.size()); }
+
+    bool isFree(int labIndex, int slot) const {
+        return !hasSlot(occupied[labIndex], slot);
+    }
+
+    void occupy(int labIndex, int slot) {
+        occupied[labIndex] |= slotBit(slot);
+    }
+
+    /**
+     * @brief 撤销一个班级的占用
+     * @param studentCount 该班级的人数(须与占用时相同, 仅座位级占用时使用)
+     *
+     * 座位级占用时只归还该班级的座位, 座位全部归还后单元才变为空闲;
+     * 仍有其他班级入座时, 共同课程与可共享标记保持不变(只会比实际更严格)。
+     */
+    void release(int labIndex, int slot, int studentCount);
+
+    SlotMask freeMask(int labIndex) const {
+        return kAllSlots & ~occupied[labIndex];
+    }
+
+    /**
+     * @brief 容量 >= studentCount 的实验室数量(即容量索引中的前缀长度)
+     */
+    int capacityTier(int studentCount) const;
+
+    /**
+     * @brief 实验室在容量降序序列中的位置, 位置 < tier 即表示能容纳该 tier 的班级
+     */
+    int capacityRank(int labIndex) const { return rankOf[labIndex]; }
+
+    const std::pmr::vector<int>& labsByCapacity() const { return byCapacity; }
+
+    FeatureMask labFeatures(int labIndex) const { return features[labIndex]; }
+
+    /**
+     * @brief 实验室是否具备全部所需设备特性
+     */
+    bool hasFeatures(int labIndex, FeatureMask required) const {
+        return (features[labIndex] & required) == required;
+    }
+
+    /**
+     * @brief 统计可行单元数: 容量足够且具备所需设备的实验室 × allowed 中仍空闲的时间槽
+     */
+    int feasibleCells(SlotMask allowed, int studentCount, FeatureMask required = 0) const {
+        return feasibleCellsInTier(allowed, capacityTier(studentCount), required);
+    }
+
+    /**
+     * @brief 同上, 直接给出容量层级(容量索引前缀长度)
+     */
+    int feasibleCellsInTier(SlotMask allowed, int tier, FeatureMask required = 0) const;
+
+    /**
+     * @brief 启用/关闭座位级占用(教室共享模式), 会清空已有的座位状态
+     *
+     * 启用后每个 (实验室, 时间槽) 单元额外保存一个 32 位状态:
+     * 低 16 位为剩余座位数, 其上 15 位为已入座班级的共同课程(0 表示没有共同课程),
+     * 最高位表示已入座班级是否都允许与其他课程共用。
+     * 单元是否有人使用仍由占用位图表示。
+     */
+    void setSeatMode(bool enabled);
+    bool seatMode() const { return !cells.empty(); }
+
+    int capacity(int labIndex) const { return sortedCapacities[rankOf[labIndex]]; }
+
+    /**
+     * @brief 剩余座位数(空闲单元为实验室容量)
+     */
+    int freeSeats(int labIndex, int slot) const {
+        if (isFree(labIndex, slot)) {
+            return capacity(labIndex);
+        }
+        return static_cast<int>(cells[labIndex * kSlotCount + slot] & kSeatMask);
+    }
+
+    /**
+     * @brief 班级能否加入一个已有人使用的单元:
+     *        剩余座位足够, 且与已入座班级属于同一课程, 或双方都允许共用
+     */
+    bool canJoin(int labIndex, int slot, int studentCount, CourseKey course, bool shareable) const {
+        if (isFree(labIndex, slot)) {
+            return false;
+        }
+        uint32_t state = cells[labIndex * kSlotCount + slot];
+        bool compatible = (course != 0 && ((state >> kCourseShift) & kMaxCourseKeys) == course) ||
+                          (shareable && (state & kShareableBit));
+        return compatible && static_cast<int>(state & kSeatMask) >= studentCount;
+    }
+
+    /**
+     * @brief 在单元中为班级占用 studentCount 个座位(空闲单元同时标记为已占用)
+     */
+    void occupySeats(int labIndex, int slot, int studentCount, CourseKey course, bool shareable);
+
+private:
+    static constexpr uint32_t kSeatMask = 0xFFFF;
+    static constexpr int kCourseShift = 16;
+    static constexpr uint32_t kShareableBit = 0x80000000u;
+
+    std::pmr::vector<SlotMask> occupied;       // labIndex -> 已占用时间槽位图
+    std::pmr::vector<int> byCapacity;          // 按容量降序排列的 labIndex
+    std::pmr::vector<int> sortedCapacities;    // 与 byCapacity 对应的容量(降序)
+    std::pmr::vector<int> rankOf;              // labIndex -> 在 byCapacity 中的位置
+    std::pmr::vector<FeatureMask> features;    // labIndex -> 设备特性位图
+    std::pmr::vector<uint32_t> cells;          // labIndex × kSlotCount + slot -> 座位状态(仅共享模式)
+};
+
+#endif // OCCUPANCY_H
@@ -0,0 +1,128 @@
+#include "partition.h"
+#include <map>
+
+UnionFind::UnionFind(int count, std::pmr::memory_resource* resource)
+    : parent(count, resource), rank(count, 0, resource) {
+    for (int i = 0; i < count; i++) {
+        parent[i] = i;
+    }
+}
+
+int UnionFind::find(int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+void UnionFind::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return;
+    }
+    if (rank[a] < rank[b]) {
+        std::swap(a, b);
+    }
+    parent[b] = a;
+    if (rank[a] == rank[b]) {
+        rank[a]++;
+    }
+}
+
+std::pmr::vector<std::pmr::vector<int>> partitionRequests(
+    const std::vector<LabRequest>& requests,
+    std::span<const SlotMask> allowedMasks,
+    const OccupancyGrid& grid,
+    std::pmr::memory_resource* resource) {
+    std::pmr::vector<std::pmr::vector<int>> components(resource);
+    int count = static_cast<int>(requests.size());
+    if (grid.labCount() == 0) {
+        for (int i = 0; i < count; i++) {
+            components.emplace_back(1, i);
+        }
+        return components;
+    }
+
+    // 单元编号: labIndex × kSlotCount + slot
+    UnionFind cells(grid.labCount() * kSlotCount, resource);
+    auto cellOf = [](int labIndex, int slot) { return labIndex * kSlotCount + slot; };
+
+    // 候选实验室集合只取决于 (容量层级, 所需设备), 不同组合的数量很少。
+    // 对每个组合在其被使用的每个时间槽上, 把该列中所有候选实验室的单元合并;
+    // 之后每个申请只需把各允许时间槽上本组合的首个单元合并在一起,
+    // 就与逐单元合并整个 "候选实验室 × 允许时间槽" 矩形得到相同的分量
+    std::pmr::map<std::pair<int, FeatureMask>, int> groupIds(resource);
+    std::pmr::vector<std::pmr::vector<int>> groupLabs(resource);
+    std::pmr::vector<SlotMask> groupSlots(resource);
+    std::pmr::vector<int> groupOf(count, -1, resource);
+    for (int i = 0; i < count; i++) {
+        if (!allowedMasks[i]) {
+            continue;
+        }
+        auto key = std::make_pair(grid.capacityTier(requests[i].studentCount),
+                                  requests[i].requiredMask);
+        auto it = groupIds.find(key);
+        if (it == groupIds.end()) {
+            std::pmr::vector<int> labs(resource);
+            for (int rank = 0; rank < key.first; rank++) {
+                int labIndex = grid.labsByCapacity()[rank];
+                if (grid.hasFeatures(labIndex, key.second)) {
+                    labs.push_back(labIndex);
+                }
+            }
+            it = groupIds.emplace(key, static_cast<int>(groupLabs.size())).first;
+            groupLabs.push_back(std::move(labs));
+            groupSlots.push_back(0);
+        }
+        if (!groupLabs[it->second].empty()) {
+            groupOf[i] = it->second;
+            groupSlots[it->second] |= allowedMasks[i];
+        }
+    }
+
+    for (size_t g = 0; g < groupLabs.size(); g++) {
+        SlotMask used = groupSlots[g];
+        while (used) {
+            int slot = lowestSlot(used);
+            clearLowestSlot(used);
+            for (size_t k = 1; k < groupLabs[g].size(); k++) {
+                cells.unite(cellOf(groupLabs[g][0], slot), cellOf(groupLabs[g][k], slot));
+            }
+        }
+    }
+
+    std::pmr::vector<int> anchor(count, -1, resource);
+    for (int i = 0; i < count; i++) {
+        if (groupOf[i] < 0) {
+            continue;  // 没有候选单元
+        }
+        int anchorLab = groupLabs[groupOf[i]][0];
+        SlotMask allowed = allowedMasks[i];
+        int first = cellOf(anchorLab, lowestSlot(allowed));
+        anchor[i] = first;
+        clearLowestSlot(allowed);
+        while (allowed) {
+            cells.unite(first, cellOf(anchorLab, lowestSlot(allowed)));
+            clearLowestSlot(allowed);
+        }
+    }
+
+    // 按首次出现的顺序为分量编号, 保证结果确定
+    std::pmr::map<int, int> componentOf(resource);
+    for (int i = 0; i < count; i++) {
+        if (anchor[i] < 0) {
+            components.emplace_back(1, i);
+            continue;
+        }
+        int root = cells.find(anchor[i]);
+        auto it = componentOf.find(root);
+        if (it == componentOf.end()) {
+            it = componentOf.emplace(root, static_cast<int>(components.size())).first;
+            components.emplace_back();
+        }
+        components[it->second].push_back(i);
+    }
+    return components;
+}
@@ -0,0 +1,47 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "lab_types.h"
+#include "occupancy.h"
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief 并查集(路径减半 + 按秩合并)
+ */
+class UnionFind {
+public:
+    explicit UnionFind(int count,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    int find(int x);
+    void unite(int a, int b);
+
+private:
+    std::pmr::vector<int> parent;
+    std::pmr::vector<unsigned char> rank;
+};
+
+/**
+ * @brief 将申请划分为互不影响的独立分量
+ *
+ * 申请的候选单元为 (容量足够且设备齐全的实验室, 允许的时间槽)。
+ * 两个申请的候选单元有交集时才可能相互影响, 因此在 (实验室, 时间槽) 单元上
+ * 建立并查集, 同一申请的所有候选单元合并为一个集合, 最终每个集合对应一个分量。
+ * 例如只在第9周可用的申请与只在第10周可用的申请必然落在不同分量中。
+ *
+ * 各分量内部的贪心结果只依赖本分量的占用情况, 因此分别求解再合并
+ * 与整体顺序求解的结果完全相同。
+ *
+ * @return 各分量包含的申请下标(升序), 分量按其首个申请下标排序;
+ *         没有任何候选单元的申请各自单独成为一个分量;
+ *         结果与中间数据都从 resource 分配
+ */
+std::pmr::vector<std::pmr::vector<int>> partitionRequests(
+    const std::vector<LabRequest>& requests,
+    std::span<const SlotMask> allowedMasks,
+    const OccupancyGrid& grid,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+#endif // PARTITION_H
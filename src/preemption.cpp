@@ -0,0 +1,188 @@
+#include "preemption.h"
+#include <algorithm>
+#include <chrono>
+
+PreemptionSolver::PreemptionSolver(const std::vector<Laboratory>& labs,
+                                   const std::vector<LabRequest>& requests,
+                                   const SlotPatternTable& patterns,
+                                   const OccupancyGrid& initial,
+                                   std::pmr::memory_resource* resource)
+    : labs(labs), requests(requests), patterns(patterns), resource(resource),
+      occupancy(initial, resource), owners(resource), placementOf(resource), classOf(resource),
+      chainMark(resource), log(resource) {}
+
+bool PreemptionSolver::fits(int requestIndex, int labIndex) const {
+    const LabRequest& request = requests[requestIndex];
+    return labs[labIndex].capacity >= request.studentCount && occupancy.hasFeatures(labIndex, request.requiredMask);
+}
+
+bool PreemptionSolver::findFree(int requestIndex, Placement& placement) const {
+    int pattern = patterns.patternOf(requestIndex);
+    auto freeLab = [&](int slot) {
+        for (int lab = 0; lab < static_cast<int>(labs.size()); lab++) {
+            if (occupancy.isFree(lab, slot) && fits(requestIndex, lab)) {
+                return lab;
+            }
+        }
+        return -1;
+    };
+    for (int slot : patterns.preferred(pattern)) {
+        int lab = freeLab(slot);
+        if (lab >= 0) {
+            placement = {requestIndex, lab, slot, true, false};
+            return true;
+        }
+    }
+    SlotMask fallback = patterns.fallback(pattern);
+    for (int slot = 0; slot < kSlotCount; slot++) {
+        if (hasSlot(fallback, slot)) {
+            int lab = freeLab(slot);
+            if (lab >= 0) {
+                placement = {requestIndex, lab, slot, false, false};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool PreemptionSolver::hasFree(int requestIndex) const {
+    SlotMask allowed = patterns.allowedMasks()[requestIndex];
+    for (int lab = 0; lab < static_cast<int>(labs.size()); lab++) {
+        if ((occupancy.freeMask(lab) & allowed) != 0 && fits(requestIndex, lab)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PreemptionSolver::chooseVictim(int evictor, Placement& cell) const {
+    int pattern = patterns.patternOf(evictor);
+    int evictorClass = classOf[evictor];
+    bool found = false;
+    bool bestMovable = false;
+    int bestClass = 0;
+
+    auto consider = [&](int slot, bool preferred) {
+        for (int lab = 0; lab < static_cast<int>(labs.size()); lab++) {
+            const CellOwner& owner = owners[lab * kSlotCount + slot];
+            // 空闲单元已由 findFree 排除, 占用者为 -1 的是不可用时间段
+            if (owner.request < 0 || owner.priorityClass < evictorClass || !fits(evictor, lab) ||
+                chainMark[owner.request] == chain) {
+                continue;
+            }
+            bool movable = hasFree(owner.request);
+            if (owner.priorityClass == evictorClass && !movable) {
+                continue;
+            }
+            if (!found || (movable && !bestMovable) ||
+                (movable == bestMovable && owner.priorityClass > bestClass)) {
+                found = true;
+                bestMovable = movable;
+                bestClass = owner.priorityClass;
+                cell = {evictor, lab, slot, preferred, false};
+            }
+        }
+    };
+    for (int slot : patterns.preferred(pattern)) {
+        consider(slot, true);
+    }
+    SlotMask fallback = patterns.fallback(pattern);
+    for (int slot = 0; slot < kSlotCount; slot++) {
+        if (hasSlot(fallback, slot)) {
+            consider(slot, false);
+        }
+    }
+    return found;
+}
+
+void PreemptionSolver::assign(const Placement& placement, std::pmr::vector<Placement>& placements) {
+    int index = placement.requestIndex;
+    if (placementOf[index] >= 0) {
+        placements[placementOf[index]] = placement;
+    } else {
+        placementOf[index] = static_cast<int>(placements.size());
+        placements.push_back(placement);
+    }
+    occupancy.occupy(placement.labIndex, placement.slot);
+    owners[placement.labIndex * kSlotCount + placement.slot] = {index, classOf[index]};
+}
+
+PreemptionReport PreemptionSolver::solve(std::span<const int> failed, std::pmr::vector<Placement>& placements,
+                                         const PreemptionOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    PreemptionReport report;
+    log.clear();
+    int width = std::max(1, options.classWidth);
+    classOf.resize(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        classOf[i] = requests[i].priority / width;
+    }
+    chainMark.assign(requests.size(), 0);
+    chain = 0;
+
+    // 建立 (实验室, 时间槽) -> 占用者索引
+    owners.assign(labs.size() * kSlotCount, CellOwner());
+    placementOf.assign(requests.size(), -1);
+    for (size_t position = 0; position < placements.size(); position++) {
+        const Placement& placement = placements[position];
+        placementOf[placement.requestIndex] = static_cast<int>(position);
+        occupancy.occupy(placement.labIndex, placement.slot);
+        owners[placement.labIndex * kSlotCount + placement.slot] = {placement.requestIndex,
+                                                                    classOf[placement.requestIndex]};
+    }
+
+    bool anyDropped = false;
+    for (int index : failed) {
+        if (placementOf[index] >= 0) {
+            continue;
+        }
+        report.candidates++;
+        Placement placement;
+        if (findFree(index, placement)) {
+            assign(placement, placements);
+            report.filled++;
+            continue;
+        }
+        chain++;
+        chainMark[index] = chain;
+        if (!chooseVictim(index, placement)) {
+            continue;
+        }
+        report.preempted++;
+
+        // 连锁: evictor 取代 cell 中的占用者, 被取代者迁到空闲单元或继续向下取代
+        for (int depth = 1;; depth++) {
+            int victim = owners[placement.labIndex * kSlotCount + placement.slot].request;
+            chainMark[victim] = chain;
+            assign(placement, placements);
+            report.evictions++;
+            report.deepest = std::max(report.deepest, depth);
+            log.push_back({placement.requestIndex, victim, placement.labIndex, placement.slot, depth, false});
+
+            Placement next;
+            if (findFree(victim, next)) {
+                assign(next, placements);
+                log.back().relocated = true;
+                report.relocated++;
+                break;
+            }
+            if (depth >= options.maxDepth || !chooseVictim(victim, next)) {
+                placements[placementOf[victim]].requestIndex = -1;
+                placementOf[victim] = -1;
+                anyDropped = true;
+                report.dropped++;
+                break;
+            }
+            log.back().relocated = true;
+            report.relocated++;
+            placement = next;
+        }
+    }
+
+    if (anyDropped) {
+        std::erase_if(placements, [](const Placement& placement) { return placement.requestIndex < 0; });
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,131 @@
+#ifndef PREEMPTION_H
+#define PREEMPTION_H
+
+#include "lab_types.h"
+#include "occupancy.h"
+#include "slot_pattern.h"
+#include "solver.h"
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief 抢占设置
+ *
+ * 优先级类别为 priority / classWidth(与 PriorityBands 策略的分段相同), 类别编号越小越优先。
+ * classWidth 为 1 时 priority 不同即属于不同类别。
+ */
+struct PreemptionOptions {
+    int classWidth = 0;  // 优先级类别的宽度, <= 0 表示不启用抢占
+    int maxDepth = 4;    // 连锁迁移的最大深度: 被取代的申请至多再向下取代 maxDepth - 1 层
+
+    bool enabled() const { return classWidth > 0; }
+};
+
+/**
+ * @brief 一次取代: victim 原有的单元 (labIndex, slot) 改由 evictor 使用
+ */
+struct Eviction {
+    int evictor;     // 取代者的申请下标
+    int victim;      // 被取代者的申请下标
+    int labIndex;
+    int slot;
+    int depth;       // 在连锁中的层数(1 为未分配的申请直接取代)
+    bool relocated;  // 被取代者是否重新分配成功(直接迁到空闲单元, 或继续向下取代)
+};
+
+struct PreemptionReport {
+    int candidates = 0;  // 尝试抢占的未分配申请数
+    int filled = 0;      // 其中直接分配到空闲单元的申请数
+    int preempted = 0;   // 其中取代其他安排后分配成功的申请数
+    int evictions = 0;   // 被取代的安排数(含连锁中的各层)
+    int relocated = 0;   // 被取代后重新分配成功的申请数
+    int dropped = 0;     // 被取代后未能重新分配的申请数
+    int deepest = 0;     // 最长连锁的层数
+    double seconds = 0;
+};
+
+/**
+ * @brief 抢占式分配: 分配失败的申请取代优先级类别更低的安排, 被取代的申请有限深度地连锁重新分配
+ *
+ * 贪心求解中 priority 只决定处理顺序; 粘性重新生成时保留的安排先于所有申请占用单元,
+ * 课表公布后才加入的紧急申请只能使用剩余的单元。抢占在求解之后进行:
+ *   1. 按申请下标顺序(即 priority 顺序)处理每个未分配的申请, 先尝试空闲单元
+ *   2. 没有空闲单元时, 在它的可行单元(允许的时间段中容量足够、设备齐全的实验室)中选择一个
+ *      已有安排取代: 占用者的类别严格更低, 或类别相同但能直接迁到空闲单元(只移动, 不影响任何人)。
+ *      能直接迁到空闲单元的占用者优先, 其次类别最低者; 同等条件下按贪心的尝试顺序取第一个
+ *   3. 被取代的申请先尝试空闲单元, 否则按第 2 步继续向下取代, 直到迁移成功、没有可取代的单元
+ *      或达到 maxDepth 层(此时该申请未能重新分配)
+ * 除同类别的纯迁移外每一层被取代者的类别都严格高于取代者, 因此一条连锁中类别严格递增;
+ * 本次连锁中已涉及的申请也不再被选为被取代者(环检测), 连锁必然在 maxDepth 层内结束。
+ * 抢占不产生新的空闲单元, 类别最高(编号最小)的申请的成功数不会减少。
+ *
+ * 选择被取代者时通过 (实验室, 时间槽) -> (占用的申请, 其类别) 索引直接查找单元的占用者,
+ * 占用者能否迁到空闲单元按实验室的空闲时间槽位图判断, 不扫描单个单元。
+ * 只支持教室共享关闭的情况(一个单元至多一个班级)。
+ */
+class PreemptionSolver {
+public:
+    /**
+     * @param initial 求解前的占用(只含不可用时间段等固定占用, 不含 placements 中的分配)
+     */
+    PreemptionSolver(const std::vector<Laboratory>& labs,
+                     const std::vector<LabRequest>& requests,
+                     const SlotPatternTable& patterns,
+                     const OccupancyGrid& initial,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief 在 placements 之上为 failed 中的申请抢占
+     * @param failed 未分配的申请下标(按优先级顺序)
+     * @param placements 已有的分配结果, 就地修改: 被取代者的位置被更新或删除, 新的分配追加在末尾
+     */
+    PreemptionReport solve(std::span<const int> failed, std::pmr::vector<Placement>& placements,
+                           const PreemptionOptions& options);
+
+    /**
+     * @brief 最近一次 solve 中的各次取代(按发生顺序)
+     */
+    std::span<const Eviction> evictions() const { return log; }
+
+private:
+    // 单元的占用者: 申请下标(-1 表示空闲或固定占用)及其优先级类别
+    struct CellOwner {
+        int request = -1;
+        int priorityClass = 0;
+    };
+
+    const std::vector<Laboratory>& labs;
+    const std::vector<LabRequest>& requests;
+    const SlotPatternTable& patterns;
+    std::pmr::memory_resource* resource;
+    OccupancyGrid occupancy;
+    std::pmr::vector<CellOwner> owners;   // labIndex × kSlotCount + slot -> 占用者
+    std::pmr::vector<int> placementOf;    // 申请下标 -> 在 placements 中的位置, -1 表示未分配
+    std::pmr::vector<int> classOf;        // 申请下标 -> 优先级类别
+    std::pmr::vector<unsigned> chainMark; // 申请下标 -> 最近一次涉及它的连锁编号(环检测)
+    std::pmr::vector<Eviction> log;
+    unsigned chain = 0;
+
+    bool fits(int requestIndex, int labIndex) const;
+
+    /**
+     * @brief 按贪心的尝试顺序(期望时间段, 再按日历顺序的备选时间段)寻找空闲的可行单元
+     */
+    bool findFree(int requestIndex, Placement& placement) const;
+
+    /**
+     * @brief 申请是否有空闲的可行单元(只比较实验室的空闲时间槽位图)
+     */
+    bool hasFree(int requestIndex) const;
+
+    /**
+     * @brief 为 evictor 选择要取代的单元(见类说明第 2 步)
+     * @return 没有可取代的单元时返回 false
+     */
+    bool chooseVictim(int evictor, Placement& cell) const;
+
+    void assign(const Placement& placement, std::pmr::vector<Placement>& placements);
+};
+
+#endif // PREEMPTION_H
@@ -0,0 +1,341 @@
+#include "request_order.h"
+#include <algorithm>
+#include <map>
+
+const char* orderingStrategyName(OrderingStrategy strategy) {
+    switch (strategy) {
+    case OrderingStrategy::Priority:       return "priority";
+    case OrderingStrategy::FewestFeasible: return "fewest-feasible";
+    case OrderingStrategy::LargestClass:   return "largest-class";
+    case OrderingStrategy::PriorityBands:  return "priority-bands";
+    case OrderingStrategy::FairShare:      return "fair-share";
+    }
+    return "unknown";
+}
+
+const char* fairnessGroupName(FairnessGroup group) {
+    switch (group) {
+    case FairnessGroup::Teacher: return "teacher";
+    case FairnessGroup::Course:  return "course";
+    }
+    return "unknown";
+}
+
+RequestQueue::RequestQueue(OrderingStrategy strategy,
+                           const std::vector<LabRequest>& requests,
+                           std::span<const int> subset,
+                           std::span<const SlotMask> allowedMasks,
+                           const OccupancyGrid& grid,
+                           int bandWidth,
+                           std::pmr::memory_resource* resource)
+    : dynamic(strategy == OrderingStrategy::FewestFeasible ||
+              strategy == OrderingStrategy::PriorityBands),
+      requests(requests), grid(grid), order(resource), cursor(0),
+      classes(resource), members(resource), bandClasses(resource), bandStart(resource),
+      nextBand(0), heap(resource),
+      slotClasses(resource), slotStart(resource) {
+    if (!dynamic) {
+        order.assign(subset.begin(), subset.end());
+        if (strategy == OrderingStrategy::LargestClass) {
+            // 同人数的申请保持原有的优先级顺序(subset 为升序, 按下标比较即可)
+            std::sort(order.begin(), order.end(), [&requests](int a, int b) {
+                if (requests[a].studentCount != requests[b].studentCount) {
+                    return requests[a].studentCount > requests[b].studentCount;
+                }
+                return a < b;
+            });
+        }
+        return;
+    }
+
+    if (bandWidth < 1) {
+        bandWidth = 1;
+    }
+
+    // 按 (分段, 允许位图, 容量层级, 所需设备) 归类, 同类申请的可行单元数始终相同
+    std::pmr::map<std::tuple<int, SlotMask, int, FeatureMask>, int> classIds(resource);
+    std::pmr::vector<int> classOf(resource);
+    classOf.reserve(subset.size());
+    for (int i : subset) {
+        int band = strategy == OrderingStrategy::PriorityBands
+                       ? requests[i].priority / bandWidth : 0;
+        int tier = grid.capacityTier(requests[i].studentCount);
+        auto key = std::make_tuple(band, allowedMasks[i], tier, requests[i].requiredMask);
+
+        auto it = classIds.find(key);
+        if (it == classIds.end()) {
+            RequestClass rc;
+            rc.allowed = allowedMasks[i];
+            rc.tier = tier;
+            rc.required = requests[i].requiredMask;
+            rc.feasible = 0;
+            rc.head = 0;
+            rc.end = 0;
+            rc.position = -1;
+            it = classIds.emplace(key, static_cast<int>(classes.size())).first;
+            classes.push_back(rc);
+        }
+        classOf.push_back(it->second);
+        classes[it->second].end++;  // 暂存成员数
+    }
+
+    // 成员连续存放: 先按成员数划分区间, 再按处理顺序依次填入
+    int offset = 0;
+    for (auto& rc : classes) {
+        int count = rc.end;
+        rc.head = offset;
+        rc.end = offset;
+        offset += count;
+    }
+    members.resize(subset.size());
+    for (size_t k = 0; k < subset.size(); k++) {
+        members[classes[classOf[k]].end++] = subset[k];
+    }
+
+    // classIds 以分段为第一关键字有序, 顺序遍历即得到按分段升序排列的类别
+    size_t slotEntries = 0;
+    for (const auto& rc : classes) {
+        slotEntries += slotCount(rc.allowed);
+    }
+    int lastBand = 0;
+    for (const auto& entry : classIds) {
+        int band = std::get<0>(entry.first);
+        if (bandStart.empty() || band != lastBand) {
+            bandStart.push_back(static_cast<int>(bandClasses.size()));
+            lastBand = band;
+        }
+        bandClasses.push_back(entry.second);
+    }
+    bandStart.push_back(static_cast<int>(bandClasses.size()));
+
+    slotClasses.resize(slotEntries);
+    slotStart.assign(kSlotCount + 1, 0);
+    heap.reserve(classes.size());
+}
+
+void RequestQueue::activateBand(int band) {
+    // 统计每个时间槽的类别数, 前缀和得到各时间槽区间的结束位置, 再从后往前填入
+    std::fill(slotStart.begin(), slotStart.end(), 0);
+    for (int k = bandStart[band]; k < bandStart[band + 1]; k++) {
+        SlotMask allowed = classes[bandClasses[k]].allowed;
+        while (allowed) {
+            slotStart[lowestSlot(allowed)]++;
+            clearLowestSlot(allowed);
+        }
+    }
+    for (int slot = 1; slot < kSlotCount; slot++) {
+        slotStart[slot] += slotStart[slot - 1];
+    }
+    slotStart[kSlotCount] = slotStart[kSlotCount - 1];
+
+    for (int k = bandStart[band]; k < bandStart[band + 1]; k++) {
+        int c = bandClasses[k];
+        RequestClass& rc = classes[c];
+        rc.feasible = grid.feasibleCellsInTier(rc.allowed, rc.tier, rc.required);
+        heapPush(c);
+
+        SlotMask allowed = rc.allowed;
+        while (allowed) {
+            slotClasses[--slotStart[lowestSlot(allowed)]] = c;
+            clearLowestSlot(allowed);
+        }
+    }
+    for (int slot = 0; slot < kSlotCount; slot++) {
+        std::sort(slotClasses.begin() + slotStart[slot], slotClasses.begin() + slotStart[slot + 1],
+                  [this](int a, int b) {
+                      if (classes[a].tier != classes[b].tier) {
+                          return classes[a].tier > classes[b].tier;
+                      }
+                      return a < b;
+                  });
+    }
+}
+
+bool RequestQueue::before(int a, int b) const {
+    // 可行单元数相同时, 队首优先级高(下标小)的类别优先; 各类别的队首互不相同, 顺序是确定的
+    if (classes[a].feasible != classes[b].feasible) {
+        return classes[a].feasible < classes[b].feasible;
+    }
+    return members[classes[a].head] < members[classes[b].head];
+}
+
+void RequestQueue::heapPush(int classId) {
+    classes[classId].position = static_cast<int>(heap.size());
+    heap.push_back(classId);
+    siftUp(classes[classId].position);
+}
+
+void RequestQueue::siftUp(int position) {
+    int c = heap[position];
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (!before(c, heap[parent])) {
+            break;
+        }
+        heap[position] = heap[parent];
+        classes[heap[position]].position = position;
+        position = parent;
+    }
+    heap[position] = c;
+    classes[c].position = position;
+}
+
+void RequestQueue::siftDown(int position) {
+    int c = heap[position];
+    int size = static_cast<int>(heap.size());
+    while (true) {
+        int child = 2 * position + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!before(heap[child], c)) {
+            break;
+        }
+        heap[position] = heap[child];
+        classes[heap[position]].position = position;
+        position = child;
+    }
+    heap[position] = c;
+    classes[c].position = position;
+}
+
+bool RequestQueue::next(int& requestIndex) {
+    if (!dynamic) {
+        if (cursor >= order.size()) {
+            return false;
+        }
+        requestIndex = order[cursor++];
+        return true;
+    }
+
+    // 当前分段处理完毕后激活下一分段
+    while (heap.empty()) {
+        if (nextBand + 1 >= bandStart.size()) {
+            return false;
+        }
+        activateBand(static_cast<int>(nextBand++));
+    }
+
+    // 堆顶即可行单元数最少、相同时队首优先级最高(下标最小)的类别
+    RequestClass& rc = classes[heap.front()];
+    requestIndex = members[rc.head++];
+    if (rc.head >= rc.end) {
+        // 成员已取完: 移出堆, 由最后一个类别填补堆顶后下沉
+        rc.position = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap.front() = last;
+            siftDown(0);
+        }
+    } else {
+        siftDown(0);  // 队首后移, 关键字只会变大
+    }
+    return true;
+}
+
+void RequestQueue::onPlaced(int labIndex, int slot) {
+    if (!dynamic) {
+        return;
+    }
+
+    int capacityRank = grid.capacityRank(labIndex);
+    FeatureMask labFeatures = grid.labFeatures(labIndex);
+    for (int k = slotStart[slot]; k < slotStart[slot + 1]; k++) {
+        int c = slotClasses[k];
+        RequestClass& rc = classes[c];
+        if (capacityRank >= rc.tier) {
+            break;  // 其余类别的容量层级更低, 该实验室对它们不可行
+        }
+        if (rc.position < 0 || (labFeatures & rc.required) != rc.required) {
+            continue;
+        }
+        rc.feasible--;
+        siftUp(rc.position);
+    }
+}
+
+FairQueue::FairQueue(std::span<const int> subset,
+                     std::span<const int> groupOf,
+                     std::pmr::memory_resource* resource)
+    : subset(subset), groups(resource), members(subset.size(), resource), heap(resource) {
+    // 组按首个成员出现的顺序编号, 成员按 subset 顺序(即优先级顺序)连续存放
+    std::pmr::vector<int> localOf(resource);
+    std::pmr::vector<int> groupOfPosition(subset.size(), resource);
+    for (size_t k = 0; k < subset.size(); k++) {
+        int group = groupOf.empty() ? 0 : groupOf[subset[k]];
+        if (group >= static_cast<int>(localOf.size())) {
+            localOf.resize(group + 1, -1);
+        }
+        if (localOf[group] < 0) {
+            localOf[group] = static_cast<int>(groups.size());
+            groups.push_back({0, 0, 0, 0});
+        }
+        groupOfPosition[k] = localOf[group];
+        groups[localOf[group]].total++;
+    }
+
+    int start = 0;
+    for (auto& group : groups) {
+        group.head = group.end = start;
+        start += group.total;
+    }
+    for (size_t k = 0; k < subset.size(); k++) {
+        members[groups[groupOfPosition[k]].end++] = static_cast<int>(k);
+    }
+
+    heap.reserve(groups.size());
+    for (int g = 0; g < static_cast<int>(groups.size()); g++) {
+        heap.push_back(g);
+    }
+    std::make_heap(heap.begin(), heap.end(), [this](int a, int b) { return after(a, b); });
+}
+
+bool FairQueue::after(int a, int b) const {
+    // 比较满足比例 satisfied / total(交叉相乘, 避免浮点误差), 相同时比较队首的优先级
+    const Group& ga = groups[a];
+    const Group& gb = groups[b];
+    long long lhs = static_cast<long long>(ga.satisfied) * gb.total;
+    long long rhs = static_cast<long long>(gb.satisfied) * ga.total;
+    if (lhs != rhs) {
+        return lhs > rhs;
+    }
+    return members[ga.head] > members[gb.head];
+}
+
+void FairQueue::requeue(int group) {
+    if (groups[group].head < groups[group].end) {
+        heap.push_back(group);
+        std::push_heap(heap.begin(), heap.end(), [this](int a, int b) { return after(a, b); });
+    }
+}
+
+bool FairQueue::next(int& requestIndex) {
+    // 上一个申请没有反馈结果时按未满足处理
+    if (current >= 0) {
+        requeue(current);
+        current = -1;
+    }
+    if (heap.empty()) {
+        return false;
+    }
+    std::pop_heap(heap.begin(), heap.end(), [this](int a, int b) { return after(a, b); });
+    current = heap.back();
+    heap.pop_back();
+    requestIndex = subset[members[groups[current].head++]];
+    return true;
+}
+
+void FairQueue::onResult(bool preferred) {
+    if (current < 0) {
+        return;
+    }
+    if (preferred) {
+        groups[current].satisfied++;
+    }
+    requeue(current);
+    current = -1;
+}
@@ -0,0 +1,176 @@
+#ifndef REQUEST_ORDER_H
+#define REQUEST_ORDER_H
+
+#include "lab_types.h"
+#include "occupancy.h"
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief 申请处理顺序策略
+ */
+enum class OrderingStrategy {
+    Priority,        // 仅按优先级(与原算法一致, 默认)
+    FewestFeasible,  // 可行单元最少者优先(DSatur 式动态更新)
+    LargestClass,    // 大班优先, 同人数按优先级
+    PriorityBands,   // 按优先级分段, 段内可行单元最少者优先
+    FairShare        // 按组公平: 期望时间段满足比例最低的组优先, 组内按优先级(见 FairQueue)
+};
+
+const char* orderingStrategyName(OrderingStrategy strategy);
+
+/**
+ * @brief FairShare 策略下申请的分组方式
+ */
+enum class FairnessGroup {
+    Teacher,  // 按教师
+    Course    // 按课程(未填写课程的申请归为同一组)
+};
+
+const char* fairnessGroupName(FairnessGroup group);
+
+/**
+ * @brief 申请处理队列
+ *
+ * 静态策略(Priority/LargestClass)在构造时一次性排好顺序。
+ * 动态策略(FewestFeasible/PriorityBands)借鉴 DSatur 图着色:
+ * 每次取出当前可行单元(容量足够的实验室 × 允许的空闲时间槽)最少的申请,
+ * 并在每次成功分配后增量更新受影响申请的可行单元数。
+ *
+ * 可行单元数只取决于 (允许时间槽位图, 容量层级, 所需设备),
+ * 因此具有相同 (分段, 位图, 容量层级, 所需设备) 的申请归为一类, 共享一个计数。
+ * 每次分配只需遍历当前分段中允许该时间槽且容量层级覆盖该实验室的类别,
+ * 代价与受影响的类别数成正比, 与申请总数无关。
+ * 后续分段的计数在该分段被激活时才从占用索引一次性算出。
+ *
+ * 待处理的类别放在以 (可行单元数, 队首申请下标) 为关键字的索引二叉堆中:
+ * 堆顶即可行单元最少、同数时队首优先级最高的类别, 计数减一是一次上浮,
+ * 取出与计数更新都是 O(log 类别数), 与同一计数下的类别数无关。
+ *
+ * 所有数组在构造时从给定的内存资源一次性分配, 类别记录自己在堆中的位置,
+ * 因此 next()/onPlaced() 不再进行任何内存分配。
+ */
+class RequestQueue {
+public:
+    /**
+     * @param requests 申请列表(已按 priority 排序)
+     * @param subset 参与排序的申请下标(升序, 即按优先级顺序)
+     * @param allowedMasks 每个申请允许的时间槽位图(已去除排除时间段)
+     * @param grid 当前占用与容量索引
+     * @param bandWidth PriorityBands 策略下每个优先级分段的宽度
+     * @param resource 队列内部数组的内存来源
+     */
+    RequestQueue(OrderingStrategy strategy,
+                 const std::vector<LabRequest>& requests,
+                 std::span<const int> subset,
+                 std::span<const SlotMask> allowedMasks,
+                 const OccupancyGrid& grid,
+                 int bandWidth = 10,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief 取出下一个待处理申请的下标
+     * @return 队列为空时返回 false
+     */
+    bool next(int& requestIndex);
+
+    /**
+     * @brief 通知一次成功分配, 更新动态策略的可行单元计数
+     * @param labIndex 被占用的实验室下标
+     * @param slot 被占用的时间槽编号
+     */
+    void onPlaced(int labIndex, int slot);
+
+private:
+    struct RequestClass {
+        SlotMask allowed;
+        int tier;              // 容量足够的实验室数(容量索引前缀长度)
+        FeatureMask required;  // 所需设备特性
+        int feasible;          // 当前可行单元数
+        int head;              // 下一个待取出的成员(members 中的位置)
+        int end;               // 本类别成员在 members 中的结束位置
+        int position;          // 在堆中的位置, -1 表示不在堆中(所在分段未激活或已无待处理申请)
+    };
+
+    bool dynamic;
+    const std::vector<LabRequest>& requests;
+    const OccupancyGrid& grid;
+
+    // 静态顺序
+    std::pmr::vector<int> order;
+    size_t cursor;
+
+    // 动态顺序
+    std::pmr::vector<RequestClass> classes;
+    std::pmr::vector<int> members;        // 各类别成员依次连续存放, 类内按处理顺序排列
+    std::pmr::vector<int> bandClasses;    // 各分段的类别依次连续存放, 分段按升序排列
+    std::pmr::vector<int> bandStart;      // 分段 b 的类别为 bandClasses[bandStart[b], bandStart[b + 1])
+    size_t nextBand;
+    // 当前分段中尚有待处理申请的类别, 堆顶为 (可行单元数, 队首申请下标) 最小者
+    std::pmr::vector<int> heap;
+    // 当前分段中允许时间槽 slot 的类别为 slotClasses[slotStart[slot], slotStart[slot + 1]),
+    // 按容量层级降序排列
+    std::pmr::vector<int> slotClasses;
+    std::pmr::vector<int> slotStart;
+
+    void activateBand(int band);
+    // 类别 a 是否应先于类别 b 处理
+    bool before(int a, int b) const;
+    void heapPush(int classId);
+    void siftUp(int position);
+    void siftDown(int position);
+};
+
+/**
+ * @brief 按组公平的申请处理队列(最大化最小满足比例)
+ *
+ * 每组的申请按优先级排成一个队列; 所有组放在一个堆中, 以当前满足比例
+ * (已在期望时间段分配的申请数 / 组内申请总数)为关键字, 比例相同时取队首优先级更高的组。
+ * 每次取出比例最低的组的下一个申请, 分配结果通过 onResult 反馈后该组以新的比例重新入堆,
+ * 因此各组的期望时间段满足比例交替上升, 先申请者不能占满全部期望时间段。
+ * 每个申请的代价为 O(log 组数)。
+ *
+ * 与 RequestQueue 一样, 所有数组在构造时从给定的内存资源一次性分配。
+ */
+class FairQueue {
+public:
+    /**
+     * @param subset 参与排序的申请下标(升序, 即按优先级顺序)
+     * @param groupOf 每个申请的组编号(0..组数-1), 为空时所有申请属于同一组
+     */
+    FairQueue(std::span<const int> subset,
+              std::span<const int> groupOf,
+              std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief 取出下一个待处理申请的下标
+     * @return 队列为空时返回 false
+     */
+    bool next(int& requestIndex);
+
+    /**
+     * @brief 反馈上一个取出的申请是否在期望时间段完成分配
+     */
+    void onResult(bool preferred);
+
+private:
+    struct Group {
+        int head;       // 下一个待取出的成员(members 中的位置)
+        int end;        // 本组成员在 members 中的结束位置
+        int total;      // 组内申请总数
+        int satisfied;  // 已在期望时间段分配的申请数
+    };
+
+    std::span<const int> subset;
+    std::pmr::vector<Group> groups;
+    std::pmr::vector<int> members;  // 各组成员(subset 中的位置)依次连续存放, 组内按优先级排列
+    std::pmr::vector<int> heap;     // 组编号, 堆顶为满足比例最低的组
+    int current = -1;               // 最近一次取出申请所属的组, 等待 onResult
+
+    // 组 a 是否应排在组 b 之后
+    bool after(int a, int b) const;
+    void requeue(int group);
+};
+
+#endif // REQUEST_ORDER_H
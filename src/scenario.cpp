@@ -0,0 +1,302 @@
+#include "scenario.h"
+#include "arena.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <unordered_set>
+
+CowBlockedSlots::CowBlockedSlots(int labCount) : count(labCount) {
+    // 初始时所有页共享同一个空页
+    auto empty = std::make_shared<Page>();
+    pages.assign((labCount + kPageLabs - 1) / kPageLabs, empty);
+}
+
+CowBlockedSlots::Page& CowBlockedSlots::writablePage(int labIndex) {
+    std::shared_ptr<Page>& page = pages[labIndex / kPageLabs];
+    if (page.use_count() > 1) {
+        page = std::make_shared<Page>(*page);
+    }
+    return *page;
+}
+
+void CowBlockedSlots::block(int labIndex, SlotMask slots) {
+    writablePage(labIndex).masks[labIndex % kPageLabs] |= slots;
+}
+
+void CowBlockedSlots::unblock(int labIndex, SlotMask slots) {
+    writablePage(labIndex).masks[labIndex % kPageLabs] &= ~slots;
+}
+
+int CowBlockedSlots::ownedPages() const {
+    int owned = 0;
+    for (const auto& page : pages) {
+        if (page.use_count() == 1) {
+            owned++;
+        }
+    }
+    return owned;
+}
+
+Scenario Scenario::fromDatabase(Database& db) {
+    auto snapshot = std::make_shared<Baseline>();
+    snapshot->labs = db.getAllLaboratories();
+    snapshot->requests = db.getAllRequests();
+    snapshot->names = &db.names();
+    for (const auto& schedule : db.getAllSchedules()) {
+        snapshot->placed.emplace(schedule.requestId, schedule);
+    }
+
+    Scenario scenario;
+    scenario.blocked = CowBlockedSlots(static_cast<int>(snapshot->labs.size()));
+    scenario.baseline = std::move(snapshot);
+    return scenario;
+}
+
+Scenario Scenario::fork() const {
+    Scenario branch;
+    branch.baseline = baseline;
+    branch.blocked = blocked;
+    branch.added = added;
+    branch.removed = removed;
+    branch.nextTemporaryId = nextTemporaryId;
+    branch.ordering = ordering;
+    branch.bandWidth = bandWidth;
+    branch.sharing = sharing;
+    branch.fairness = fairness;
+    return branch;
+}
+
+void Scenario::setOrderingStrategy(OrderingStrategy strategy, int bandWidth) {
+    ordering = strategy;
+    this->bandWidth = bandWidth;
+}
+
+void Scenario::setRoomSharing(RoomSharing mode) {
+    sharing = mode;
+}
+
+bool Scenario::closeLab(const std::string& location, SlotMask slots) {
+    bool found = false;
+    for (int labIndex = 0; labIndex < static_cast<int>(baseline->labs.size()); labIndex++) {
+        if (baseline->labs[labIndex].location == location) {
+            blocked.block(labIndex, slots);
+            found = true;
+        }
+    }
+    if (!found) {
+        std::cerr << "场景中找不到实验室: " << location << std::endl;
+    }
+    return found;
+}
+
+int Scenario::addRequest(LabRequest request) {
+    request.id = nextTemporaryId--;
+    request.className = baseline->names->intern(request.classId);
+    request.teacherName = baseline->names->intern(request.teacher);
+    request.courseName = baseline->names->intern(request.course);
+    added.push_back(std::move(request));
+    return added.back().id;
+}
+
+bool Scenario::removeRequest(int requestId) {
+    auto it = std::find_if(added.begin(), added.end(),
+                           [requestId](const LabRequest& request) { return request.id == requestId; });
+    if (it != added.end()) {
+        added.erase(it);
+        return true;
+    }
+
+    bool inBaseline = std::any_of(baseline->requests.begin(), baseline->requests.end(),
+                                  [requestId](const LabRequest& request) { return request.id == requestId; });
+    if (!inBaseline || std::find(removed.begin(), removed.end(), requestId) != removed.end()) {
+        return false;
+    }
+    removed.push_back(requestId);
+    return true;
+}
+
+std::vector<LabRequest> Scenario::mergedRequests() const {
+    std::vector<LabRequest> requests;
+    requests.reserve(baseline->requests.size() + added.size());
+    for (const auto& request : baseline->requests) {
+        if (std::find(removed.begin(), removed.end(), request.id) == removed.end()) {
+            requests.push_back(request);
+        }
+    }
+    // 新增申请排在同优先级的基线申请之后, 与数据库按 priority 排序的结果一致
+    for (const auto& request : added) {
+        auto position = std::upper_bound(requests.begin(), requests.end(), request.priority,
+                                         [](int priority, const LabRequest& other) {
+                                             return priority < other.priority;
+                                         });
+        requests.insert(position, request);
+    }
+    return requests;
+}
+
+int Scenario::solve() {
+    const std::vector<Laboratory>& labs = baseline->labs;
+    // 没有增删申请时直接使用基线中的申请, 不复制
+    bool modified = !added.empty() || !removed.empty();
+    std::vector<LabRequest> merged;
+    if (modified) {
+        merged = mergedRequests();
+    }
+    const std::vector<LabRequest>& requests = modified ? merged : baseline->requests;
+
+    result.clear();
+    isSolved = true;
+    if (labs.empty() || requests.empty()) {
+        return 0;
+    }
+
+    RunArena arena(RunArena::estimateBytes(labs.size(), requests.size()));
+    std::pmr::memory_resource* resource = arena.resource();
+
+    // 封闭的时间槽在初始占用表中标记为已占用
+    OccupancyGrid grid(resource);
+    grid.reset(labs);
+    for (int labIndex = 0; labIndex < blocked.labCount(); labIndex++) {
+        SlotMask slots = blocked.blocked(labIndex);
+        while (slots) {
+            grid.occupy(labIndex, lowestSlot(slots));
+            clearLowestSlot(slots);
+        }
+    }
+
+    SlotPatternTable patterns(resource);
+    patterns.build(requests);
+    std::span<const SlotMask> allowedMasks = patterns.allowedMasks();
+    RequestGroups requestGroups(resource);
+    requestGroups.build(requests, patterns, grid);
+    std::pmr::vector<CourseKey> courseKeys(resource);
+    if (sharing != RoomSharing::Off) {
+        buildCourseKeys(requests, courseKeys);
+    }
+
+    std::pmr::vector<int> groups(resource);
+    if (ordering == OrderingStrategy::FairShare) {
+        buildFairnessGroups(requests, fairness, groups);
+    }
+
+    std::pmr::vector<int> all(requests.size(), resource);
+    std::iota(all.begin(), all.end(), 0);
+    std::pmr::vector<Placement> placements(resource);
+    GreedySolver solver(labs, requests, allowedMasks, grid, resource);
+    solver.setOrderingStrategy(ordering, bandWidth);
+    solver.setRoomSharing(sharing, courseKeys);
+    solver.setFairnessGroups(groups);
+    solver.setRequestGroups(patterns, requestGroups);
+    solver.solve(all, placements);
+
+    std::sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+        return a.requestIndex < b.requestIndex;
+    });
+    result.reserve(placements.size());
+    for (const auto& placement : placements) {
+        Schedule schedule;
+        schedule.id = 0;
+        schedule.requestId = requests[placement.requestIndex].id;
+        schedule.labId = labs[placement.labIndex].id;
+        schedule.timeSlot = slotFromIndex(placement.slot);
+        result.push_back(schedule);
+    }
+    return static_cast<int>(result.size());
+}
+
+void Scenario::solveAll(std::span<Scenario* const> scenarios, int threadCount) {
+    ThreadPool pool(threadCount);
+    for (Scenario* scenario : scenarios) {
+        pool.submit([scenario](int) { scenario->solve(); });
+    }
+    pool.wait();
+}
+
+ScenarioDiff Scenario::diff() const {
+    ScenarioDiff diff;
+    diff.baselinePlaced = static_cast<int>(baseline->placed.size());
+    diff.scenarioPlaced = static_cast<int>(result.size());
+
+    std::unordered_map<int, const LabRequest*> requestOf;
+    for (const auto& request : baseline->requests) {
+        requestOf.emplace(request.id, &request);
+    }
+    for (const auto& request : added) {
+        requestOf.emplace(request.id, &request);
+    }
+    auto classOf = [&requestOf](int requestId) {
+        auto it = requestOf.find(requestId);
+        return it != requestOf.end() ? it->second->classId : std::string();
+    };
+
+    // 场景中已分配的申请: 新分配、移动或不变
+    std::unordered_set<int> placedInScenario;
+    for (const auto& schedule : result) {
+        placedInScenario.insert(schedule.requestId);
+        auto it = baseline->placed.find(schedule.requestId);
+        if (it == baseline->placed.end()) {
+            ScheduleChange change{ScheduleChange::Kind::Placed, schedule.requestId, classOf(schedule.requestId)};
+            change.toLabId = schedule.labId;
+            change.to = schedule.timeSlot;
+            diff.changes.push_back(change);
+        } else if (it->second.labId != schedule.labId || !(it->second.timeSlot == schedule.timeSlot)) {
+            ScheduleChange change{ScheduleChange::Kind::Moved, schedule.requestId, classOf(schedule.requestId)};
+            change.fromLabId = it->second.labId;
+            change.from = it->second.timeSlot;
+            change.toLabId = schedule.labId;
+            change.to = schedule.timeSlot;
+            diff.changes.push_back(change);
+        } else {
+            diff.unchanged++;
+        }
+    }
+
+    // 基线中已分配而场景中未分配的申请(按基线的优先级顺序)
+    for (const auto& request : baseline->requests) {
+        auto it = baseline->placed.find(request.id);
+        if (it == baseline->placed.end() || placedInScenario.count(request.id)) {
+            continue;
+        }
+        ScheduleChange change{ScheduleChange::Kind::Dropped, request.id, request.classId};
+        change.fromLabId = it->second.labId;
+        change.from = it->second.timeSlot;
+        diff.changes.push_back(change);
+    }
+    return diff;
+}
+
+bool Scenario::commit(Database& db) const {
+    if (!isSolved) {
+        std::cerr << "错误: 场景尚未求解, 无法提交!" << std::endl;
+        return false;
+    }
+
+    if (!db.clearSchedules()) {
+        return false;
+    }
+    for (int requestId : removed) {
+        if (!db.deleteRequest(requestId)) {
+            std::cerr << "错误: 删除申请失败: " << requestId << std::endl;
+            return false;
+        }
+    }
+
+    // 新增申请写入数据库后以数据库分配的 id 替换临时编号
+    std::unordered_map<int, int> persistedId;
+    for (const auto& request : added) {
+        if (!db.addRequest(request)) {
+            std::cerr << "错误: 新增申请写入数据库失败: " << request.classId << std::endl;
+            return false;
+        }
+        persistedId.emplace(request.id, static_cast<int>(db.lastInsertId()));
+    }
+
+    std::vector<Schedule> schedules = result;
+    for (auto& schedule : schedules) {
+        if (schedule.requestId < 0) {
+            schedule.requestId = persistedId[schedule.requestId];
+        }
+    }
+    return db.addSchedules(schedules);
+}
@@ -0,0 +1,192 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "database.h"
+#include "occupancy.h"
+#include "request_order.h"
+#include "solver.h"
+#include <array>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 按页共享的实验室封闭时间表(写时复制)
+ *
+ * 每页保存 kPageLabs 个实验室的封闭时间槽位图。复制本表只复制页指针;
+ * 修改某个实验室时若其所在页仍被其他副本共享, 先复制这一页再修改,
+ * 因此分支场景的开销与修改过的页数成正比, 与实验室总数无关。
+ */
+class CowBlockedSlots {
+public:
+    static constexpr int kPageLabs = 64;
+
+    explicit CowBlockedSlots(int labCount = 0);
+
+    int labCount() const { return count; }
+
+    SlotMask blocked(int labIndex) const {
+        return pages[labIndex / kPageLabs]->masks[labIndex % kPageLabs];
+    }
+
+    void block(int labIndex, SlotMask slots);
+    void unblock(int labIndex, SlotMask slots);
+
+    /**
+     * @brief 本副本独占(已复制)的页数
+     */
+    int ownedPages() const;
+
+private:
+    struct Page {
+        std::array<SlotMask, kPageLabs> masks{};
+    };
+
+    std::vector<std::shared_ptr<Page>> pages;
+    int count = 0;
+
+    Page& writablePage(int labIndex);
+};
+
+// 场景课表相对基线的一处变化
+struct ScheduleChange {
+    enum class Kind {
+        Placed,   // 基线中未分配, 场景中分配成功(含新增申请)
+        Dropped,  // 基线中已分配, 场景中未分配(含删除的申请)
+        Moved     // 两者都已分配, 但实验室或时间段不同
+    };
+
+    Kind kind;
+    int requestId;        // 场景中新增的申请为负数(-1, -2, ...)
+    std::string classId;
+    int fromLabId = 0;    // 基线中的实验室(Placed 时无意义)
+    TimeSlot from{};
+    int toLabId = 0;      // 场景中的实验室(Dropped 时无意义)
+    TimeSlot to{};
+};
+
+// 场景与基线课表的差异
+struct ScenarioDiff {
+    int baselinePlaced = 0;  // 基线中已分配的申请数
+    int scenarioPlaced = 0;  // 场景中分配成功的申请数
+    int unchanged = 0;       // 分配结果完全相同的申请数
+    std::vector<ScheduleChange> changes;
+};
+
+/**
+ * @brief 假设分析场景: 在内存中修改调度输入并重新求解, 与基线课表比较
+ *
+ * 基线(实验室、申请与数据库中已保存的课表)只读取一次, 由所有分支共享;
+ * 实验室封闭时间按页写时复制(见 CowBlockedSlots), 新增/删除的申请只记录差量。
+ * 求解只在内存中进行, 不修改数据库, 直到调用 commit。
+ * 不同场景互不共享可变状态, 可以用 solveAll 并行求解。
+ *
+ * 用法:
+ *   Scenario base = Scenario::fromDatabase(db);
+ *   Scenario closed = base.fork();
+ *   closed.closeLab("实验楼B201", weekSlots(10));
+ *   closed.solve();
+ *   ScenarioDiff diff = closed.diff();
+ */
+class Scenario {
+public:
+    /**
+     * @brief 以数据库当前内容为基线建立场景
+     *
+     * 场景使用数据库的名称驻留表(见 Database::names), 数据库须比场景及其分支存活更久。
+     */
+    static Scenario fromDatabase(Database& db);
+
+    /**
+     * @brief 复制一个分支: 共享基线与封闭表的页, 复制差量与求解设置, 不复制求解结果
+     */
+    Scenario fork() const;
+
+    void setOrderingStrategy(OrderingStrategy strategy, int bandWidth = 10);
+    void setRoomSharing(RoomSharing mode);
+    void setFairnessGroup(FairnessGroup group) { fairness = group; }
+
+    /**
+     * @brief 在 slots 中封闭指定位置的实验室(所有同名实验室)
+     * @return 找不到该实验室时返回 false
+     */
+    bool closeLab(const std::string& location, SlotMask slots = kAllSlots);
+
+    /**
+     * @brief 加入一个新申请, 返回其在场景中的临时编号(负数)
+     *
+     * 申请的班级、教师与课程名称登记到基线数据库的名称驻留表中。
+     */
+    int addRequest(LabRequest request);
+
+    /**
+     * @brief 删除基线中的申请或场景中新增的申请
+     * @return 找不到该申请时返回 false
+     */
+    bool removeRequest(int requestId);
+
+    /**
+     * @brief 在内存中求解当前场景
+     * @return 成功分配的申请数量
+     */
+    int solve();
+
+    /**
+     * @brief 并行求解多个场景(每个场景占用一个工作线程)
+     * @param threadCount 工作线程数, <= 0 时使用硬件并发数
+     */
+    static void solveAll(std::span<Scenario* const> scenarios, int threadCount = 0);
+
+    bool solved() const { return isSolved; }
+
+    /**
+     * @brief 最近一次求解的课表(按申请优先级顺序), 新增申请的 requestId 为临时编号
+     */
+    const std::vector<Schedule>& schedules() const { return result; }
+
+    /**
+     * @brief 最近一次求解结果与基线课表的差异
+     */
+    ScenarioDiff diff() const;
+
+    /**
+     * @brief 将场景写入数据库: 删除/新增申请并用场景课表替换已保存的课表
+     *
+     * 实验室封闭只影响求解结果, 不写入数据库。
+     * 提交后数据库内容已变化, 之后的假设分析应重新调用 fromDatabase 建立基线。
+     */
+    bool commit(Database& db) const;
+
+    const CowBlockedSlots& blockedSlots() const { return blocked; }
+
+private:
+    struct Baseline {
+        std::vector<Laboratory> labs;
+        std::vector<LabRequest> requests;          // 按优先级排序
+        std::unordered_map<int, Schedule> placed;  // requestId -> 已保存的课程安排
+        StringInterner* names = nullptr;           // 基线数据库的名称驻留表
+    };
+
+    std::shared_ptr<const Baseline> baseline;
+    CowBlockedSlots blocked;
+    std::vector<LabRequest> added;  // 新增申请(id 为临时编号)
+    std::vector<int> removed;       // 删除的基线申请 id
+    int nextTemporaryId = -1;
+
+    OrderingStrategy ordering = OrderingStrategy::Priority;
+    int bandWidth = 10;
+    RoomSharing sharing = RoomSharing::Off;
+    FairnessGroup fairness = FairnessGroup::Teacher;
+
+    std::vector<Schedule> result;
+    bool isSolved = false;
+
+    /**
+     * @brief 参与求解的申请: 基线申请去掉删除的, 按优先级合并新增的
+     */
+    std::vector<LabRequest> mergedRequests() const;
+};
+
+#endif // SCENARIO_H
@@ -1,131 +1,148 @@
 #include "scheduler.h"
-#include <algorithm>
 #include <iostream>
+#include <optional>
+#include <unordered_map>
 
 Scheduler::Scheduler(Database* db) : database(db) {}
 
-std::vector<TimeSlot> Scheduler::getAllPossibleSlots() {
-    std::vector<TimeSlot> slots;
-    // 两周(第9周和第10周), 每周5天(周一到周五), 每天2个时段(上午/下午)
-    for (int week = 9; week <= 10; week++) {
-        for (int day = 0; day < 5; day++) {  // 0-4 表示周一到周五
-            for (int period = 0; period < 2; period++) {  // 0-上午, 1-下午
-                slots.push_back({week, day, period});
-            }
-        }
-    }
-    return slots;
-}
-
-bool Scheduler::isSlotExcluded(const TimeSlot& slot, const std::vector<TimeSlot>& excludedSlots) {
-    return std::find(excludedSlots.begin(), excludedSlots.end(), slot) != excludedSlots.end();
-}
-
-bool Scheduler::isLabAvailable(int labId, const TimeSlot& slot) {
-    auto it = labOccupancy.find(labId);
-    if (it == labOccupancy.end()) {
-        return true;  // 该实验室还没有任何占用
+int Scheduler::generateSchedule() {
+    profile.start();
+    DatabaseCounters before = database->counters();
+    
+    int successCount = runSchedule();
+    
+    // 内核阶段的耗时是各线程的累计值, 只计入阶段统计, 不生成跟踪事件
+    DatabaseCounters after = database->counters();
+    profile.database.statements = after.statements - before.statements;
+    profile.database.rowsRead = after.rowsRead - before.rowsRead;
+    profile.database.rowsWritten = after.rowsWritten - before.rowsWritten;
+    profile.addPhase(Phase::Preferred, profile.solver.preferredNanos);
+    profile.addPhase(Phase::Fallback, profile.solver.fallbackNanos);
+    profile.finish();
+    
+    if (!traceFile.empty() && profile.writeChromeTrace(traceFile) && verbose) {
+        std::cout << "跟踪文件已写入: " << traceFile << std::endl;
     }
-    return it->second.find(slot) == it->second.end();
-}
-
-void Scheduler::markLabOccupied(int labId, const TimeSlot& slot) {
-    labOccupancy[labId].insert(slot);
+    return successCount;
 }
 
-bool Scheduler::allocateRequest(const LabRequest& request, const std::vector<Laboratory>& labs) {
-    // 阶段1: 优先尝试分配到期望的时间段
-    for (const auto& preferredSlot : request.preferredSlots) {
-        // 检查是否在排除列表中
-        if (isSlotExcluded(preferredSlot, request.excludedSlots)) {
-            continue;
+void Scheduler::logSolve(const SchedulingProblem& problem) {
+    const std::vector<Laboratory>& labs = problem.labs;
+    const std::vector<LabRequest>& requests = problem.requests;
+    const StringInterner& names = database->names();
+    const FeasibilityReport& feasibility = result.feasibility;
+    
+    if (core.stickyRegenerate()) {
+        int keptCount = 0;
+        for (char kept : result.kept) {
+            keptCount += kept;
         }
-        
-        // 遍历所有实验室,寻找合适的实验室
-        for (const auto& lab : labs) {
-            // 检查容量是否满足
-            if (lab.capacity < request.studentCount) {
-                continue;
-            }
-            
-            // 检查实验室是否可用
-            if (!isLabAvailable(lab.id, preferredSlot)) {
-                continue;
-            }
-            
-            // 找到合适的实验室和时间段,进行分配
-            Schedule schedule;
-            schedule.requestId = request.id;
-            schedule.labId = lab.id;
-            schedule.timeSlot = preferredSlot;
-            
-            if (database->addSchedule(schedule)) {
-                markLabOccupied(lab.id, preferredSlot);
-                std::cout << "成功分配: 班级 " << request.classId 
-                          << " -> 实验室 " << lab.location 
-                          << " (第" << preferredSlot.week << "周 "
-                          << "周" << (preferredSlot.day + 1) << " "
-                          << (preferredSlot.period == 0 ? "上午" : "下午") << ")" << std::endl;
-                return true;
+        std::cout << "粘性重新生成: 原有安排 " << problem.previous.size() << " 节, 保留 " << keptCount
+                  << " 节, 待重新分配的申请 " << requests.size() - keptCount << " 个" << std::endl;
+    }
+    std::cout << "时间段模式: " << result.patterns << " 个, 候选单元相同的申请分组: "
+              << result.requestGroups << " 个" << std::endl;
+    if (feasibility.analyzed) {
+        std::cout << "可行性预检: 成功数上界 " << feasibility.maxPlacements << " / " << requests.size()
+                  << ", 没有任何可行单元的申请 " << feasibility.unplaceable.size() << " 个" << std::endl;
+        for (const auto& tier : feasibility.tiers) {
+            std::cout << "  容量 >= " << tier.minCapacity << " (" << tier.labs << " 个实验室): 申请 "
+                      << tier.requests << ", 空闲单元 " << tier.cells;
+            if (tier.shortfall > 0) {
+                std::cout << ", 至少 " << tier.shortfall << " 个无法分配";
             }
+            std::cout << std::endl;
         }
+        for (int index : feasibility.unplaceable) {
+            std::cout << "  无可行单元: 班级 " << names.view(requests[index].className)
+                      << " (教师: " << names.view(requests[index].teacherName) << ")" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    if (result.components > 0) {
+        std::cout << "独立分量数量: " << result.components
+                  << " (最大分量 " << result.largestComponent << " 个申请)" << std::endl;
+    } else if (result.threads > 0) {
+        std::cout << "推测并行: " << result.threads << " 个线程, "
+                  << profile.solver.speculativeConflicts << " 个申请的推测位置被更早的申请占用" << std::endl;
+    }
+    
+    const AnytimeResult& anytime = result.anytime;
+    if (core.anytimeOptions().enabled()) {
+        std::cout << "随时可停求解: 改进轮次 " << anytime.rounds << ", 找到更好课表 "
+                  << anytime.improvements << " 次(最优为第 " << anytime.bestRound << " 轮), 耗时 "
+                  << anytime.seconds << " 秒, 结束原因: " << anytimeStopName(anytime.stop) << std::endl;
     }
     
-    // 阶段2: 如果期望时间段都无法满足,尝试其他可用时间段
-    std::vector<TimeSlot> allSlots = getAllPossibleSlots();
-    for (const auto& slot : allSlots) {
-        // 跳过排除的时间段
-        if (isSlotExcluded(slot, request.excludedSlots)) {
-            continue;
+    const PreemptionReport& preemption = result.preemption;
+    if (core.preemptionOptions().enabled() && core.roomSharing() == RoomSharing::Off) {
+        for (const auto& eviction : result.evictions) {
+            TimeSlot time = slotFromIndex(eviction.slot);
+            std::cout << "抢占: 班级 " << names.view(requests[eviction.evictor].className)
+                      << " 取代 班级 " << names.view(requests[eviction.victim].className)
+                      << " (实验室 " << labs[eviction.labIndex].location << " 第" << time.week << "周 "
+                      << "周" << (time.day + 1) << " " << (time.period == 0 ? "上午" : "下午") << "), "
+                      << (eviction.relocated ? "被取代的班级已重新分配" : "被取代的班级未能重新分配")
+                      << std::endl;
         }
-        
-        // 跳过已经尝试过的期望时间段
-        if (std::find(request.preferredSlots.begin(), request.preferredSlots.end(), slot) 
-            != request.preferredSlots.end()) {
-            continue;
+        std::cout << "抢占: 未分配的申请 " << preemption.candidates << " 个, 取代后分配 "
+                  << preemption.preempted << " 个, 被取代 " << preemption.evictions
+                  << " 次(重新分配 " << preemption.relocated << ", 未能重新分配 "
+                  << preemption.dropped << "), 最长连锁 " << preemption.deepest << " 层" << std::endl;
+    }
+}
+
+int Scheduler::runSchedule() {
+    // 1. 清空旧的课程安排(粘性模式下读入旧安排, 求解后只改写变化的部分)
+    bool sticky = core.stickyRegenerate();
+    result = SchedulingResult();
+    result.regenerate.sticky = sticky;
+    if (!sticky) {
+        ScopedPhase phase(profile, Phase::Clear);
+        database->clearSchedules();
+    }
+    
+    // 2. 获取所有实验室和申请
+    SchedulingProblem problem;
+    {
+        ScopedPhase phase(profile, Phase::Load);
+        problem.labs = database->getAllLaboratories();
+        // 求解只使用名称编号, 不复制名称字符串; 日志与统计用 names 取回名称
+        problem.requests = database->getAllRequests(false);
+        if (sticky) {
+            problem.previous = database->getAllSchedules();
         }
-        
-        // 遍历所有实验室
-        for (const auto& lab : labs) {
-            if (lab.capacity < request.studentCount) {
-                continue;
+    }
+    const std::vector<Laboratory>& labs = problem.labs;
+    std::vector<LabRequest>& requests = problem.requests;
+    const StringInterner& names = database->names();
+    
+    // 教师在其他地方已有安排的时间槽按排除时间段处理
+    if (!teacherBusy.empty()) {
+        std::unordered_map<NameId, SlotMask> busyById;
+        for (const auto& [teacher, slots] : teacherBusy) {
+            NameId id = names.find(teacher);
+            if (id != kNoName) {
+                busyById.emplace(id, slots);
             }
-            
-            if (!isLabAvailable(lab.id, slot)) {
+        }
+        for (auto& request : requests) {
+            auto busy = busyById.find(request.teacherName);
+            if (busy == busyById.end()) {
                 continue;
             }
-            
-            // 找到可用的实验室和时间段
-            Schedule schedule;
-            schedule.requestId = request.id;
-            schedule.labId = lab.id;
-            schedule.timeSlot = slot;
-            
-            if (database->addSchedule(schedule)) {
-                markLabOccupied(lab.id, slot);
-                std::cout << "备选分配: 班级 " << request.classId 
-                          << " -> 实验室 " << lab.location 
-                          << " (第" << slot.week << "周 "
-                          << "周" << (slot.day + 1) << " "
-                          << (slot.period == 0 ? "上午" : "下午") << ")" << std::endl;
-                return true;
+            for (int slot = 0; slot < kSlotCount; slot++) {
+                if (hasSlot(busy->second, slot)) {
+                    request.excludedSlots.push_back(slotFromIndex(slot));
+                }
             }
         }
     }
+    result.regenerate.previous = static_cast<int>(problem.previous.size());
     
-    // 无法为该申请分配合适的时间段和实验室
-    std::cout << "分配失败: 班级 " << request.classId << " (教师: " << request.teacher << ")" << std::endl;
-    return false;
-}
-
-int Scheduler::generateSchedule() {
-    // 1. 清空旧的课程安排
-    database->clearSchedules();
-    labOccupancy.clear();
-    
-    // 2. 获取所有实验室和申请
-    std::vector<Laboratory> labs = database->getAllLaboratories();
-    std::vector<LabRequest> requests = database->getAllRequests();
+    if (sticky && (labs.empty() || requests.empty()) && !problem.previous.empty()) {
+        database->clearSchedules();
+    }
     
     if (labs.empty()) {
         std::cerr << "错误: 没有可用的实验室!" << std::endl;
@@ -137,25 +154,93 @@ int Scheduler::generateSchedule() {
         return 0;
     }
     
-    std::cout << "\n========== 开始生成课程安排 ==========" << std::endl;
-    std::cout << "可用实验室数量: " << labs.size() << std::endl;
-    std::cout << "待处理申请数量: " << requests.size() << std::endl;
-    std::cout << "====================================\n" << std::endl;
+    if (verbose) {
+        OrderingStrategy ordering = core.orderingStrategy();
+        std::cout << "\n========== 开始生成课程安排 ==========" << std::endl;
+        std::cout << "可用实验室数量: " << labs.size() << std::endl;
+        std::cout << "待处理申请数量: " << requests.size() << std::endl;
+        std::cout << "排序策略: " << orderingStrategyName(ordering);
+        if (ordering == OrderingStrategy::FairShare) {
+            std::cout << " (按" << (core.fairnessGroup() == FairnessGroup::Teacher ? "教师" : "课程") << "分组)";
+        }
+        std::cout << std::endl;
+        std::cout << "====================================\n" << std::endl;
+    }
     
-    // 3. 申请已按priority排序(在数据库查询时已排序)
+    // 3. 由调度内核在内存中求解(处理顺序、并行、粘性保留与抢占见 CoreScheduler)
+    result = core.solve(problem, &profile);
+    if (verbose) {
+        logSolve(problem);
+    }
     
-    // 4. 对每个申请进行分配
-    int successCount = 0;
-    for (const auto& request : requests) {
-        if (allocateRequest(request, labs)) {
-            successCount++;
+    // 4. 输出分配日志并写入数据库(粘性模式下保留的安排不再写入)
+    std::optional<ScopedPhase> report(std::in_place, profile, Phase::Report);
+    const std::vector<Placement>& placements = result.placements;
+    std::vector<Schedule> schedules;
+    schedules.reserve(placements.size());
+    size_t next = 0;
+    for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+        const LabRequest& request = requests[i];
+        if (next < placements.size() && placements[next].requestIndex == i) {
+            const Placement& placement = placements[next++];
+            Schedule schedule;
+            schedule.requestId = request.id;
+            schedule.labId = labs[placement.labIndex].id;
+            schedule.timeSlot = slotFromIndex(placement.slot);
+            if (!result.kept[i]) {
+                schedules.push_back(schedule);
+            }
+            
+            if (verbose) {
+                std::cout << (result.kept[i] ? "保留原安排: 班级 "
+                              : placement.preferred ? "成功分配: 班级 " : "备选分配: 班级 ") << names.view(request.className)
+                          << " -> 实验室 " << labs[placement.labIndex].location 
+                          << " (第" << schedule.timeSlot.week << "周 "
+                          << "周" << (schedule.timeSlot.day + 1) << " "
+                          << (schedule.timeSlot.period == 0 ? "上午" : "下午") << ")"
+                          << (placement.shared ? " [共用]" : "") << std::endl;
+            }
+        } else if (verbose) {
+            std::cout << "分配失败: 班级 " << names.view(request.className)
+                      << " (教师: " << names.view(request.teacherName) << ")" << std::endl;
         }
     }
+    RegenerateReport& regenerate = result.regenerate;
+    for (int index : result.changed) {
+        regenerate.changedClasses.emplace_back(names.view(requests[index].className));
+    }
+    report.reset();
+    
+    bool written;
+    {
+        ScopedPhase phase(profile, Phase::Persist);
+        written = sticky ? database->updateSchedules(result.removedIds, schedules) : database->addSchedules(schedules);
+    }
+    if (!written) {
+        std::cerr << "错误: 课程安排写入数据库失败!" << std::endl;
+        return 0;
+    }
+    int successCount = result.placed();
     
-    std::cout << "\n========== 课程安排生成完成 ==========" << std::endl;
-    std::cout << "成功分配: " << successCount << " / " << requests.size() << std::endl;
-    std::cout << "成功率: " << (successCount * 100.0 / requests.size()) << "%" << std::endl;
-    std::cout << "====================================\n" << std::endl;
+    if (verbose) {
+        const FeasibilityReport& feasibility = result.feasibility;
+        const ObjectiveScores& objective = result.objective;
+        std::cout << "\n========== 课程安排生成完成 ==========" << std::endl;
+        std::cout << "成功分配: " << successCount << " / " << requests.size();
+        if (feasibility.analyzed) {
+            std::cout << " (上界 " << feasibility.maxPlacements << ")";
+        }
+        std::cout << std::endl;
+        std::cout << "成功率: " << (successCount * 100.0 / requests.size()) << "%" << std::endl;
+        std::cout << "期望时间段: " << objective.preferred << ", 备选时间段: " << objective.fallback
+                  << ", 空置座位: " << objective.wastedSeats
+                  << ", 目标函数总分: " << objective.total << std::endl;
+        if (sticky) {
+            std::cout << "相对上一次课表: 不变 " << regenerate.kept << ", 调整 " << regenerate.moved
+                      << ", 取消 " << regenerate.dropped << ", 新增 " << regenerate.added << std::endl;
+        }
+        std::cout << "====================================\n" << std::endl;
+    }
     
     return successCount;
 }
@@ -163,7 +248,8 @@ int Scheduler::generateSchedule() {
 Scheduler::ScheduleStats Scheduler::getScheduleStats() {
     ScheduleStats stats;
     
-    std::vector<LabRequest> allRequests = database->getAllRequests();
+    std::vector<LabRequest> allRequests = database->getAllRequests(false);
+    const StringInterner& names = database->names();
     std::vector<Schedule> allSchedules = database->getAllSchedules();
     
     stats.totalRequests = allRequests.size();
@@ -182,9 +268,19 @@ Scheduler::ScheduleStats Scheduler::getScheduleStats() {
     // 找出失败的班级
     for (const auto& request : allRequests) {
         if (scheduledRequestIds.find(request.id) == scheduledRequestIds.end()) {
-            stats.failedClasses.push_back(request.classId + " (" + request.teacher + ")");
+            std::string_view classId = names.view(request.className);
+            std::string_view teacher = names.view(request.teacherName);
+            std::string& entry = stats.failedClasses.emplace_back();
+            entry.reserve(classId.size() + teacher.size() + 3);
+            entry.append(classId).append(" (").append(teacher).append(")");
         }
     }
+    stats.profile = profile;
+    stats.objective = result.objective;
+    stats.feasibility = result.feasibility;
+    stats.regenerate = result.regenerate;
+    stats.anytime = result.anytime;
+    stats.preemption = result.preemption;
     
     return stats;
 }
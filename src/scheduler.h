@@ -1,9 +1,12 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "core_scheduler.h"
 #include "database.h"
-#include <map>
+#include "instrumentation.h"
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -17,6 +20,15 @@
  * 3. 容量约束检查：确保实验室容量能够容纳班级人数
  * 4. 时间冲突检查：避免同一实验室同一时间段重复分配
  * 5. 排除时间段过滤：过滤掉教师不可用的时间段
+ * 6. 处理顺序可插拔：默认按优先级, 也可选择可行单元最少者优先等策略(见 request_order.h)
+ * 7. 并行求解：互不影响的申请分量可在线程池中并行求解, 也可推测并行后按顺序确认, 结果均与顺序求解一致
+ * 8. 可行性预检：求解前按容量档与时间槽比较供需, 给出成功数上界与注定无法分配的申请(见 feasibility.h)
+ * 9. 粘性重新生成：保留上一次课表中仍然有效的安排, 只为其余申请求解, 尽量减少教室调整
+ * 10. 随时可停求解：在时间预算内不断改进课表, 随时保留最好的完整课表(见 anytime.h)
+ * 11. 抢占：求解后未分配的申请可以取代优先级类别更低的安排, 被取代者有限深度地连锁重新分配(见 preemption.h)
+ *
+ * 求解逻辑都在调度内核(CoreScheduler, 见 core_scheduler.h)中, 只在内存中工作;
+ * 本类是它基于数据库的适配器: 读取实验室与申请, 调用内核求解, 统一写入数据库并输出日志。
  */
 class Scheduler {
 public:
@@ -27,75 +39,175 @@ public:
      * @return 成功分配的申请数量
      * 
      * 算法流程：
-     * 1. 清空旧的课程安排
+     * 1. 清空旧的课程安排(粘性模式下先保留, 见 setStickyRegenerate)
      * 2. 获取所有实验室和申请
-     * 3. 按优先级排序申请(先申请先满足)
+     * 3. 按所选策略确定处理顺序(默认按优先级, 先申请先满足)
      * 4. 对每个申请:
      *    a. 首先尝试分配到期望的时间段
      *    b. 如果期望时间段无法满足,尝试其他可用时间段
      *    c. 选择能容纳该班级的实验室
      *    d. 避免时间冲突
-     * 5. 将成功的分配结果写入数据库
+     * 5. 按申请顺序合并分配结果, 在一个事务中写入数据库
      */
     int generateSchedule();
     
     /**
-     * @brief 获取调度统计信息
+     * @brief 设置申请处理顺序策略
+     * @param bandWidth PriorityBands 策略下每个优先级分段的宽度
      */
-    struct ScheduleStats {
-        int totalRequests;      // 总申请数
-        int successfulRequests; // 成功分配的申请数
-        int failedRequests;     // 失败的申请数
-        double successRate;     // 成功率
-        std::vector<std::string> failedClasses; // 失败的班级列表
-    };
+    void setOrderingStrategy(OrderingStrategy strategy, int bandWidth = 10) {
+        core.setOrderingStrategy(strategy, bandWidth);
+    }
     
-    ScheduleStats getScheduleStats();
+    /**
+     * @brief FairShare 策略下的分组方式(默认按教师)
+     * 
+     * 组的满足比例在所有申请之间共享, 因此 FairShare 策略总是顺序求解, 不进行分区并行。
+     */
+    void setFairnessGroup(FairnessGroup group) { core.setFairnessGroup(group); }
     
-private:
-    Database* database;
+    /**
+     * @brief 是否输出逐条分配日志(批量处理或基准测试时可关闭)
+     */
+    void setVerbose(bool enabled) { verbose = enabled; }
+    
+    /**
+     * @brief 是否启用并行求解
+     * @param threadCount 工作线程数, <= 0 时使用硬件并发数
+     * @param mode 并行方式
+     * 
+     * Partitioned: 先将申请划分为互不影响的分量(见 partition.h), 再在工作窃取线程池中
+     * 并行求解各分量; 只有一个分量时自动退化为顺序求解。
+     * Speculative: 不要求申请之间互不影响, 所有申请连成一片时也能利用多核;
+     * 只支持 Priority/LargestClass 策略且教室共享关闭, 其他情况退化为顺序求解。
+     * 两种方式的结果都与顺序求解完全相同。
+     */
+    void setParallel(bool enabled, int threadCount = 0, ParallelMode mode = ParallelMode::Partitioned) {
+        core.setParallel(enabled, threadCount, mode);
+    }
     
-    // 实验室占用情况: lab_id -> set of occupied time slots
-    std::map<int, std::set<TimeSlot>> labOccupancy;
+    /**
+     * @brief 设置教室共享模式(默认关闭)
+     * 
+     * 启用后实验室按座位计算占用: 同一课程(course)的班级, 或都标记为可共享(shareable)
+     * 的班级, 在座位足够时可以共用同一个实验室时间段。
+     */
+    void setRoomSharing(RoomSharing mode) { core.setRoomSharing(mode); }
     
     /**
-     * @brief 尝试为申请分配实验室
-     * @param request 实验申请
-     * @param labs 可用实验室列表
-     * @return 是否成功分配
+     * @brief 是否使用粘性重新生成(默认关闭)
      * 
-     * 算法详细步骤：
-     * 1. 首先尝试期望时间段(优先级最高)
-     * 2. 对于每个期望时间段:
-     *    - 遍历所有实验室
-     *    - 检查容量是否满足
-     *    - 检查时间段是否已被占用
-     *    - 如果找到合适的实验室,分配并返回true
-     * 3. 如果期望时间段都无法满足,尝试所有可用时间段
-     * 4. 排除不可用时间段(excluded slots)
-     * 5. 返回分配结果
+     * 启用后不清空旧的课程安排, 而是按处理顺序检查每个申请上一次的安排: 时间段仍然允许、
+     * 实验室容量与设备仍然满足、且单元未被更早的申请占用时原样保留; 其余申请从保留安排之后的
+     * 占用出发重新求解。数据库中只删除失效的安排并写入新的安排, 未变化的行不改写。
+     * 与重新求解相比, 已公布的课表变动最少, 但结果可能不同于从零开始求解的课表。
+     * 粘性模式总是顺序求解。
      */
-    bool allocateRequest(const LabRequest& request, const std::vector<Laboratory>& labs);
+    void setStickyRegenerate(bool enabled) { core.setStickyRegenerate(enabled); }
     
     /**
-     * @brief 检查实验室在特定时间段是否可用
+     * @brief 设置随时可停求解(见 AnytimeSolver), 默认不启用
+     * 
+     * 启用后(给出时间预算、轮数上限或取消标记)先按所选策略得到完整课表,
+     * 再在预算内尝试其他排序策略与挤压轮次, 写入数据库的是按目标函数最好的课表。
+     * 回调在调用 generateSchedule 的线程中执行, 申请与实验室下标对应本次读取的列表。
+     * 随时可停求解总是顺序求解; 与粘性模式同时启用时只改进未保留的申请。
      */
-    bool isLabAvailable(int labId, const TimeSlot& slot);
+    void setAnytime(const AnytimeOptions& options) { core.setAnytime(options); }
     
     /**
-     * @brief 标记实验室时间段为已占用
+     * @brief 设置抢占(见 PreemptionSolver), 默认不启用
+     * 
+     * 启用后在求解(含粘性模式与随时可停求解)之后, 按优先级顺序让未分配的申请取代优先级类别更低的安排,
+     * 被取代的申请迁到空闲单元或继续向下取代, 至多 maxDepth 层。粘性模式下被取代的保留安排按调整处理。
+     * 用于课表公布后加入的紧急申请: 给它较小的 priority, 再以粘性模式重新生成。
+     * 教室共享模式下不进行抢占。
      */
-    void markLabOccupied(int labId, const TimeSlot& slot);
+    void setPreemption(const PreemptionOptions& options) { core.setPreemption(options); }
+    
+    /**
+     * @brief 教师在本数据库之外已有安排的时间槽(如其他校区的课程), 默认为空
+     * 
+     * 读取申请后把这些时间槽并入该教师各申请的排除时间段(只在内存中, 不写入数据库),
+     * 粘性模式下落在其中的旧安排视为失效。多校区求解(见 ShardedScheduler)用它协调跨校区的教师。
+     */
+    void setTeacherBusySlots(std::unordered_map<std::string, SlotMask> busy) { teacherBusy = std::move(busy); }
+    
+    /**
+     * @brief 最近一次随时可停求解的轮数、改进次数与结束原因
+     */
+    const AnytimeResult& lastAnytimeResult() const { return result.anytime; }
+    
+    /**
+     * @brief 最近一次抢占的统计(未启用时为默认值)
+     */
+    const PreemptionReport& lastPreemptionReport() const { return result.preemption; }
+    
+    /**
+     * @brief 最近一次 generateSchedule 相对上一次课表的变化
+     */
+    const RegenerateReport& lastRegenerateReport() const { return result.regenerate; }
+    
+    /**
+     * @brief 每次生成课程安排后把剖析数据写成 Chrome trace-event JSON(空字符串表示不写)
+     */
+    void setTraceFile(const std::string& path) { traceFile = path; }
+    
+    /**
+     * @brief 是否在剖析数据中分别统计期望/备选时间段阶段的耗时(默认关闭)
+     * 
+     * 开启后分配内核对每个申请读取 2~3 次时钟, 10 万级申请时有可见的开销;
+     * 关闭时 preferred/fallback 阶段为 0, solve 阶段的墙钟时间照常记录。
+     */
+    void setPhaseTiming(bool enabled) { core.setPhaseTiming(enabled); }
+    
+    /**
+     * @brief 最近一次 generateSchedule 的阶段耗时与计数器
+     */
+    const RunProfile& lastRunProfile() const { return profile; }
+    
+    /**
+     * @brief 设置目标函数权重(见 objective.h), 用于评价生成的课表
+     */
+    void setObjectiveWeights(const ObjectiveWeights& weights) { core.setObjectiveWeights(weights); }
+    
+    /**
+     * @brief 获取调度统计信息
+     */
+    struct ScheduleStats {
+        int totalRequests;      // 总申请数
+        int successfulRequests; // 成功分配的申请数
+        int failedRequests;     // 失败的申请数
+        double successRate;     // 成功率
+        std::vector<std::string> failedClasses; // 失败的班级列表
+        RunProfile profile;     // 最近一次生成的阶段耗时与计数器
+        ObjectiveScores objective; // 最近一次生成的课表的目标函数各分量
+        FeasibilityReport feasibility; // 最近一次生成前的可行性预检
+        RegenerateReport regenerate;   // 最近一次生成相对上一次课表的变化
+        AnytimeResult anytime;         // 最近一次随时可停求解的结果(未启用时为默认值)
+        PreemptionReport preemption;   // 最近一次抢占的统计(未启用时为默认值)
+    };
+    
+    ScheduleStats getScheduleStats();
+    
+private:
+    Database* database;
+    CoreScheduler core;
+    bool verbose = true;
+    std::unordered_map<std::string, SlotMask> teacherBusy;
+    std::string traceFile;
+    RunProfile profile;
+    SchedulingResult result;  // 最近一次求解的结果(regenerate.changedClasses 已按名称填写)
     
     /**
-     * @brief 获取所有可能的时间段(两周,每周5天,每天2个时段)
+     * @brief generateSchedule 的主体, 各阶段在 profile 中计时
      */
-    std::vector<TimeSlot> getAllPossibleSlots();
+    int runSchedule();
     
     /**
-     * @brief 检查时间段是否在排除列表中
+     * @brief 按内核的求解结果输出各阶段的汇总日志(verbose 时)
      */
-    bool isSlotExcluded(const TimeSlot& slot, const std::vector<TimeSlot>& excludedSlots);
+    void logSolve(const SchedulingProblem& problem);
 };
 
 #endif // SCHEDULER_H
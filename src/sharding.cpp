@@ -0,0 +1,240 @@
+#include "sharding.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <tuple>
+#include <unordered_map>
+
+bool ShardedDatabase::attach(const std::string& key, const std::string& path, int readerConnections) {
+    if (key.empty() || indexOf(key) >= 0) {
+        std::cerr << "分片键为空或已存在: " << key << std::endl;
+        return false;
+    }
+    auto db = std::make_unique<Database>(path, readerConnections);
+    if (!db->initialize()) {
+        std::cerr << "分片数据库初始化失败: " << key << " (" << path << ")" << std::endl;
+        return false;
+    }
+    keys.push_back(key);
+    shards.push_back(std::move(db));
+    return true;
+}
+
+int ShardedDatabase::indexOf(std::string_view key) const {
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == key) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+Database* ShardedDatabase::route(std::string_view key) {
+    int index = indexOf(key);
+    return index >= 0 ? shards[index].get() : nullptr;
+}
+
+void ShardedDatabase::forEachShard(const std::function<void(int shard, Database& db)>& task) {
+    if (shards.size() <= 1) {
+        for (size_t i = 0; i < shards.size(); i++) {
+            task(static_cast<int>(i), *shards[i]);
+        }
+        return;
+    }
+    // 分片查询主要等待磁盘, 每个分片一个线程
+    ThreadPool pool(static_cast<int>(shards.size()));
+    for (size_t i = 0; i < shards.size(); i++) {
+        pool.submit([&, i](int) {
+            task(static_cast<int>(i), *shards[i]);
+        });
+    }
+    pool.wait();
+}
+
+std::vector<ShardSchedule> ShardedDatabase::gather(const std::function<std::vector<Schedule>(Database&)>& query) {
+    std::vector<std::vector<Schedule>> parts(shards.size());
+    forEachShard([&](int shard, Database& db) {
+        parts[shard] = query(db);
+    });
+
+    std::vector<ShardSchedule> merged;
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    merged.reserve(total);
+    for (size_t shard = 0; shard < parts.size(); shard++) {
+        for (const auto& schedule : parts[shard]) {
+            merged.push_back({static_cast<int>(shard), schedule});
+        }
+    }
+    std::sort(merged.begin(), merged.end(), [](const ShardSchedule& a, const ShardSchedule& b) {
+        return std::make_tuple(slotIndex(a.schedule.timeSlot), a.shard, a.schedule.id) <
+               std::make_tuple(slotIndex(b.schedule.timeSlot), b.shard, b.schedule.id);
+    });
+    return merged;
+}
+
+std::vector<ShardSchedule> ShardedDatabase::getAllSchedules() {
+    return gather([](Database& db) {
+        return db.getAllSchedules();
+    });
+}
+
+std::vector<ShardSchedule> ShardedDatabase::getSchedulesByTeacher(const std::string& teacher) {
+    return gather([&teacher](Database& db) {
+        return db.getSchedulesByTeacher(teacher);
+    });
+}
+
+std::vector<ShardSchedule> ShardedDatabase::getSchedulesByClass(const std::string& classId) {
+    return gather([&classId](Database& db) {
+        return db.getSchedulesByClass(classId);
+    });
+}
+
+ShardedScheduler::ShardedScheduler(ShardedDatabase* shards) : shards(shards) {}
+
+int ShardedScheduler::generateSchedule() {
+    auto start = std::chrono::steady_clock::now();
+    int shardCount = shards->shardCount();
+    report = ShardedScheduleReport();
+    report.placed.assign(shardCount, 0);
+    report.teacherBusy.assign(shardCount, {});
+    schedulers.resize(shardCount);
+    for (int s = 0; s < shardCount; s++) {
+        if (!schedulers[s]) {
+            schedulers[s] = std::make_unique<Scheduler>(&shards->shard(s));
+        }
+    }
+
+    // 在多个分片中都有申请的教师依次编号; 各分片中这些教师的申请 id -> (教师编号, 优先级)
+    std::vector<std::vector<LabRequest>> requests(shardCount);
+    shards->forEachShard([&](int shard, Database& db) {
+        requests[shard] = db.getAllRequests();
+    });
+    std::unordered_map<std::string, int> firstShard;
+    std::unordered_map<std::string, int> sharedId;
+    std::vector<std::string> sharedNames;
+    for (int s = 0; s < shardCount; s++) {
+        for (const auto& request : requests[s]) {
+            auto first = firstShard.emplace(request.teacher, s).first;
+            if (first->second != s && sharedId.emplace(request.teacher, static_cast<int>(sharedNames.size())).second) {
+                sharedNames.push_back(request.teacher);
+            }
+        }
+    }
+    report.sharedTeachers = static_cast<int>(sharedNames.size());
+    std::vector<std::unordered_map<int, std::pair<int, int>>> requestInfo(shardCount);
+    for (int s = 0; s < shardCount; s++) {
+        for (const auto& request : requests[s]) {
+            auto shared = sharedId.find(request.teacher);
+            if (shared != sharedId.end()) {
+                requestInfo[s].emplace(request.id, std::make_pair(shared->second, request.priority));
+            }
+        }
+    }
+
+    // 每个分片中各共享教师的忙碌时间(由其他分片占用)
+    std::vector<std::vector<SlotMask>> busy(shardCount, std::vector<SlotMask>(sharedNames.size(), 0));
+    std::vector<std::vector<SlotMask>> used(shardCount, std::vector<SlotMask>(sharedNames.size(), 0));
+    std::vector<std::vector<Schedule>> schedules(shardCount);
+    std::vector<char> dirty(shardCount, 1);
+    ThreadPool pool(threadCount);
+
+    while (true) {
+        // 并行求解忙碌时间有变化的分片
+        bool roundSticky = sticky || report.rounds > 0;
+        for (int s = 0; s < shardCount; s++) {
+            if (!dirty[s]) {
+                continue;
+            }
+            std::unordered_map<std::string, SlotMask> teacherBusy;
+            for (size_t t = 0; t < sharedNames.size(); t++) {
+                if (busy[s][t] != 0) {
+                    teacherBusy.emplace(sharedNames[t], busy[s][t]);
+                }
+            }
+            Scheduler& scheduler = *schedulers[s];
+            scheduler.setVerbose(false);
+            if (setup) {
+                setup(scheduler);
+            }
+            scheduler.setStickyRegenerate(roundSticky);
+            scheduler.setTeacherBusySlots(teacherBusy);
+            report.teacherBusy[s] = std::move(teacherBusy);
+            pool.submit([&, s](int) {
+                report.placed[s] = schedulers[s]->generateSchedule();
+            });
+            report.shardSolves++;
+        }
+        pool.wait();
+        report.rounds++;
+        if (sharedNames.empty()) {
+            break;
+        }
+
+        // 共享教师的全部课程: (教师, 时间槽, 优先级, 分片); 本轮未求解的分片沿用上一轮读取的课表
+        shards->forEachShard([&](int shard, Database& db) {
+            if (dirty[shard]) {
+                schedules[shard] = db.getAllSchedules();
+            }
+        });
+        std::vector<std::tuple<int, int, int, int>> sessions;
+        for (int s = 0; s < shardCount; s++) {
+            std::fill(used[s].begin(), used[s].end(), 0);
+            for (const auto& schedule : schedules[s]) {
+                auto info = requestInfo[s].find(schedule.requestId);
+                if (info != requestInfo[s].end()) {
+                    int slot = slotIndex(schedule.timeSlot);
+                    sessions.emplace_back(info->second.first, slot, info->second.second, s);
+                    used[s][info->second.first] |= slotBit(slot);
+                }
+            }
+        }
+        std::sort(sessions.begin(), sessions.end());
+
+        // 同一 (教师, 时间槽) 出现在多个分片中: 排在最前的分片保留, 其余分片让出该时间槽,
+        // 并同时避开这位教师在其他分片已占用的时间槽, 使调整的班级不会落到新的冲突上
+        std::fill(dirty.begin(), dirty.end(), 0);
+        bool changed = false;
+        auto yield = [&](int shard, int teacher, int slot) {
+            SlotMask elsewhere = 0;
+            for (int s = 0; s < shardCount; s++) {
+                if (s != shard) {
+                    elsewhere |= used[s][teacher];
+                }
+            }
+            busy[shard][teacher] |= slotBit(slot) | (elsewhere & ~used[shard][teacher]);
+        };
+        for (size_t begin = 0; begin < sessions.size();) {
+            int teacher = std::get<0>(sessions[begin]);
+            int slot = std::get<1>(sessions[begin]);
+            int winner = std::get<3>(sessions[begin]);
+            size_t end = begin + 1;
+            while (end < sessions.size() && std::get<0>(sessions[end]) == teacher &&
+                   std::get<1>(sessions[end]) == slot) {
+                int shard = std::get<3>(sessions[end]);
+                if (shard != winner && !hasSlot(busy[shard][teacher], slot)) {
+                    yield(shard, teacher, slot);
+                    dirty[shard] = 1;
+                    report.conflicts++;
+                    changed = true;
+                }
+                end++;
+            }
+            begin = end;
+        }
+        if (!changed) {
+            break;
+        }
+    }
+
+    int total = 0;
+    for (int placed : report.placed) {
+        total += placed;
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
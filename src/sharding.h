@@ -0,0 +1,137 @@
+#ifndef SHARDING_H
+#define SHARDING_H
+
+#include "database.h"
+#include "scheduler.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 跨分片查询结果的一行: 课程安排及其所在的分片
+struct ShardSchedule {
+    int shard;          // 分片下标(见 ShardedDatabase::key)
+    Schedule schedule;  // 安排、申请与实验室的 id 只在所在分片内有效
+};
+
+/**
+ * @brief 按校区(或租户)分片的数据库: 每个分片是一个独立的 SQLite 数据库文件
+ *
+ * 分片以字符串键(如校区名)标识, 按加入顺序编号; 写入与单校区查询由 route 按键路由到
+ * 对应的 Database, 各分片的 id 互不相关。全局查询(如某位教师在所有校区的课表)在各分片上
+ * 并行执行, 每个分片使用自己的连接, 结果按 (时间段, 分片, 安排 id) 合并。
+ */
+class ShardedDatabase {
+public:
+    ShardedDatabase() = default;
+
+    ShardedDatabase(const ShardedDatabase&) = delete;
+    ShardedDatabase& operator=(const ShardedDatabase&) = delete;
+
+    /**
+     * @brief 打开并初始化一个分片的数据库
+     * @param readerConnections 该分片的只读连接数(见 Database 的连接池模式)
+     * @return 键为空或已存在、或数据库无法初始化时返回 false
+     */
+    bool attach(const std::string& key, const std::string& path, int readerConnections = 0);
+
+    int shardCount() const { return static_cast<int>(shards.size()); }
+    const std::string& key(int shard) const { return keys[shard]; }
+    Database& shard(int index) { return *shards[index]; }
+
+    /**
+     * @brief 分片键对应的下标, 键未知时返回 -1
+     */
+    int indexOf(std::string_view key) const;
+
+    /**
+     * @brief 按分片键路由到该分片的数据库, 键未知时返回 nullptr
+     */
+    Database* route(std::string_view key);
+
+    /**
+     * @brief 在每个分片上并行执行 task(每个分片一个线程), 全部完成后返回
+     */
+    void forEachShard(const std::function<void(int shard, Database& db)>& task);
+
+    // 全局查询: 在所有分片上执行并合并
+    std::vector<ShardSchedule> getAllSchedules();
+    std::vector<ShardSchedule> getSchedulesByTeacher(const std::string& teacher);
+    std::vector<ShardSchedule> getSchedulesByClass(const std::string& classId);
+
+private:
+    std::vector<std::string> keys;
+    std::vector<std::unique_ptr<Database>> shards;
+
+    std::vector<ShardSchedule> gather(const std::function<std::vector<Schedule>(Database&)>& query);
+};
+
+struct ShardedScheduleReport {
+    int rounds = 0;              // 求解轮数(第 1 轮求解全部分片, 之后只求解有冲突的分片)
+    int shardSolves = 0;         // 各轮求解的分片数之和
+    int sharedTeachers = 0;      // 在多个分片中都有申请的教师数
+    int conflicts = 0;           // 让出的 (教师, 时间槽, 分片) 数
+    std::vector<int> placed;     // 各分片成功分配的申请数
+    std::vector<std::unordered_map<std::string, SlotMask>> teacherBusy;  // 各分片最后一次求解时的教师忙碌时间
+    double seconds = 0;
+};
+
+/**
+ * @brief 多校区求解: 各分片并行求解, 同一教师在不同校区的课程不在同一时间段
+ *
+ * 每个分片由自己的 Scheduler 求解, 分片内部与单校区完全相同。跨分片的约束只有教师:
+ *   1. 第 1 轮并行求解全部分片
+ *   2. 检查在多个分片中都有申请的教师: 同一时间槽在多个分片中都有课时, 优先级最高
+ *      (优先级相同时分片下标最小)的保留, 其余分片把该时间槽记为这位教师的忙碌时间
+ *      (见 Scheduler::setTeacherBusySlots)
+ *   3. 忙碌时间有变化的分片以粘性模式并行重新求解, 只调整落在忙碌时间中的班级; 重复 2、3
+ * 忙碌时间只增不减, 每轮至少增加一个时间槽, 因此必然结束; 结束时没有跨分片的教师冲突。
+ * 同一分片内同一教师的多个班级不受此约束(与单校区求解一致)。
+ */
+class ShardedScheduler {
+public:
+    explicit ShardedScheduler(ShardedDatabase* shards);
+
+    /**
+     * @brief 每次求解某个分片前对其 Scheduler 调用 setup(排序策略、教室共享等设置)
+     *
+     * 调用 setup 前已关闭逐条日志; 粘性模式与教师忙碌时间由本类设置, setup 中的设置会被覆盖。
+     * 各分片在不同线程中求解, setup 与其中设置的回调(如随时可停求解的回调)需要可并发调用。
+     */
+    void configure(std::function<void(Scheduler&)> setup) { this->setup = std::move(setup); }
+
+    /**
+     * @brief 第 1 轮是否以粘性模式求解(之后各轮总是粘性模式)
+     */
+    void setStickyRegenerate(bool enabled) { sticky = enabled; }
+
+    /**
+     * @param threadCount 并行求解分片的线程数, <= 0 时使用硬件并发数
+     */
+    void setThreadCount(int threadCount) { this->threadCount = threadCount; }
+
+    /**
+     * @brief 为所有分片生成课程安排
+     * @return 各分片成功分配的申请数之和
+     */
+    int generateSchedule();
+
+    const ShardedScheduleReport& lastReport() const { return report; }
+
+    /**
+     * @brief 分片最近一次求解所用的 Scheduler(用于读取统计与剖析数据)
+     */
+    Scheduler& shardScheduler(int shard) { return *schedulers[shard]; }
+
+private:
+    ShardedDatabase* shards;
+    std::function<void(Scheduler&)> setup;
+    bool sticky = false;
+    int threadCount = 0;
+    std::vector<std::unique_ptr<Scheduler>> schedulers;
+    ShardedScheduleReport report;
+};
+
+#endif // SHARDING_H
@@ -0,0 +1,92 @@
+#include "slot_pattern.h"
+#include <map>
+#include <tuple>
+#include <utility>
+
+SlotPatternTable::SlotPatternTable(std::pmr::memory_resource* resource)
+    : patterns(resource), preferredSlots(resource), requestPattern(resource), masks(resource) {
+}
+
+void SlotPatternTable::build(const std::vector<LabRequest>& requests) {
+    std::pmr::memory_resource* resource = patterns.get_allocator().resource();
+    patterns.clear();
+    preferredSlots.clear();
+    requestPattern.clear();
+    masks.clear();
+    requestPattern.reserve(requests.size());
+    masks.reserve(requests.size());
+
+    // 以 (允许位图, 规范化后的期望列表) 为关键字; 规范化结果相同的申请分配行为完全相同
+    std::pmr::map<std::pair<SlotMask, std::pmr::vector<int>>, int> patternIds(resource);
+    std::pair<SlotMask, std::pmr::vector<int>> key(SlotMask(0), std::pmr::vector<int>(resource));
+    for (const auto& request : requests) {
+        SlotMask allowed = kAllSlots & ~toSlotMask(request.excludedSlots);
+        SlotMask listed = 0;
+        key.first = allowed;
+        key.second.clear();
+        for (const auto& preferredSlot : request.preferredSlots) {
+            int slot = slotIndex(preferredSlot);
+            if (slot < 0 || hasSlot(listed, slot)) {
+                continue;
+            }
+            listed |= slotBit(slot);
+            if (hasSlot(allowed, slot)) {
+                key.second.push_back(slot);
+            }
+        }
+
+        auto it = patternIds.find(key);
+        if (it == patternIds.end()) {
+            Pattern pattern;
+            pattern.allowed = allowed;
+            pattern.fallback = allowed & ~listed;
+            pattern.preferredBegin = static_cast<int>(preferredSlots.size());
+            pattern.preferredCount = static_cast<int>(key.second.size());
+            preferredSlots.insert(preferredSlots.end(), key.second.begin(), key.second.end());
+            it = patternIds.emplace(key, static_cast<int>(patterns.size())).first;
+            patterns.push_back(pattern);
+        }
+        requestPattern.push_back(it->second);
+        masks.push_back(allowed);
+    }
+}
+
+RequestGroups::RequestGroups(std::pmr::memory_resource* resource)
+    : groups(resource), candidateLabs(resource), requestGroup(resource) {
+}
+
+void RequestGroups::build(const std::vector<LabRequest>& requests, const SlotPatternTable& patterns,
+                          const OccupancyGrid& grid) {
+    std::pmr::memory_resource* resource = groups.get_allocator().resource();
+    groups.clear();
+    candidateLabs.clear();
+    requestGroup.clear();
+    requestGroup.reserve(requests.size());
+
+    // (容量层级, 所需设备) -> 候选列表区间; (模式, 容量层级, 所需设备) -> 组编号
+    std::pmr::map<std::pair<int, FeatureMask>, std::pair<int, int>> lists(resource);
+    std::pmr::map<std::tuple<int, int, FeatureMask>, int> groupIds(resource);
+    for (int i = 0; i < static_cast<int>(requests.size()); i++) {
+        const LabRequest& request = requests[i];
+        int tier = grid.capacityTier(request.studentCount);
+        auto key = std::make_tuple(patterns.patternOf(i), tier, request.requiredMask);
+        auto it = groupIds.find(key);
+        if (it == groupIds.end()) {
+            auto list = lists.find({tier, request.requiredMask});
+            if (list == lists.end()) {
+                int begin = static_cast<int>(candidateLabs.size());
+                for (int labIndex = 0; labIndex < grid.labCount(); labIndex++) {
+                    if (grid.capacityRank(labIndex) < tier && grid.hasFeatures(labIndex, request.requiredMask)) {
+                        candidateLabs.push_back(labIndex);
+                    }
+                }
+                int count = static_cast<int>(candidateLabs.size()) - begin;
+                list = lists.emplace(std::make_pair(tier, request.requiredMask), std::make_pair(begin, count)).first;
+            }
+            it = groupIds.emplace(key, static_cast<int>(groups.size())).first;
+            groups.push_back({patterns.patternOf(i), list->second.first, list->second.second});
+        }
+        requestGroup.push_back(it->second);
+    }
+    listCount = static_cast<int>(lists.size());
+}
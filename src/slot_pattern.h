@@ -0,0 +1,107 @@
+#ifndef SLOT_PATTERN_H
+#define SLOT_PATTERN_H
+
+#include "lab_types.h"
+#include "occupancy.h"
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief 时间段模式表
+ *
+ * 真实数据中成千上万个申请共享同一组期望/排除时间段(例如"工作日上午, 周五除外")。
+ * 期望时间段序列与允许时间槽都相同的申请登记为同一个模式, 按编号引用;
+ * 每个模式只计算一次:
+ *   - 允许时间槽位图(全部时间槽去掉排除时间段)
+ *   - 期望时间段编号列表(按申请中给出的顺序, 已去掉日历范围外、被排除和重复的时间段)
+ *   - 备选时间段位图(允许但不在期望列表中的时间槽, 按日历顺序尝试)
+ */
+class SlotPatternTable {
+public:
+    explicit SlotPatternTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief 为每个申请登记模式(清空原有内容)
+     */
+    void build(const std::vector<LabRequest>& requests);
+
+    int size() const { return static_cast<int>(patterns.size()); }
+    int patternOf(int requestIndex) const { return requestPattern[requestIndex]; }
+
+    SlotMask allowed(int pattern) const { return patterns[pattern].allowed; }
+    SlotMask fallback(int pattern) const { return patterns[pattern].fallback; }
+
+    std::span<const int> preferred(int pattern) const {
+        return std::span<const int>(preferredSlots).subspan(patterns[pattern].preferredBegin,
+                                                            patterns[pattern].preferredCount);
+    }
+
+    /**
+     * @brief 每个申请的允许时间槽位图, 与 buildAllowedMasks 的结果相同
+     */
+    std::span<const SlotMask> allowedMasks() const { return masks; }
+
+private:
+    struct Pattern {
+        SlotMask allowed;
+        SlotMask fallback;
+        int preferredBegin;  // 在 preferredSlots 中的区间
+        int preferredCount;
+    };
+
+    std::pmr::vector<Pattern> patterns;
+    std::pmr::vector<int> preferredSlots;  // 各模式的期望时间段编号依次连续存放
+    std::pmr::vector<int> requestPattern;  // 申请下标 -> 模式编号
+    std::pmr::vector<SlotMask> masks;      // 申请下标 -> 允许时间槽位图
+};
+
+/**
+ * @brief 候选单元完全相同的申请分组
+ *
+ * 时间段模式、容量层级(容量足够的实验室)与所需设备都相同的申请,
+ * 按分配顺序尝试的 (时间段, 实验室) 序列完全相同。
+ * 同组申请共用一份候选实验室列表(容量足够且设备齐全, 按实验室列表顺序),
+ * 容量层级与设备相同的组共用同一份列表。
+ *
+ * 分配内核为每组记录上一个成员的分配位置(见 GreedySolver::setRequestGroups):
+ * 占用只增不减, 该位置及之前的单元对后来的成员仍不可用, 下一个成员从它之后继续扫描,
+ * 因此一组申请合起来只把候选序列扫描一遍; 某个成员分配失败后, 同组其余成员直接判定失败。
+ */
+class RequestGroups {
+public:
+    explicit RequestGroups(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @param grid 提供实验室容量与设备特性(实验室下标与分配内核一致)
+     */
+    void build(const std::vector<LabRequest>& requests, const SlotPatternTable& patterns,
+               const OccupancyGrid& grid);
+
+    int size() const { return static_cast<int>(groups.size()); }
+    int groupOf(int requestIndex) const { return requestGroup[requestIndex]; }
+    int pattern(int group) const { return groups[group].pattern; }
+
+    // 容量足够且设备齐全的实验室下标(升序)
+    std::span<const int> candidates(int group) const {
+        return std::span<const int>(candidateLabs).subspan(groups[group].candidateBegin,
+                                                           groups[group].candidateCount);
+    }
+
+    // 不同的候选实验室列表数
+    int candidateListCount() const { return listCount; }
+
+private:
+    struct Group {
+        int pattern;
+        int candidateBegin;  // 在 candidateLabs 中的区间
+        int candidateCount;
+    };
+
+    std::pmr::vector<Group> groups;
+    std::pmr::vector<int> candidateLabs;  // 各候选列表依次连续存放
+    std::pmr::vector<int> requestGroup;   // 申请下标 -> 组编号
+    int listCount = 0;
+};
+
+#endif // SLOT_PATTERN_H
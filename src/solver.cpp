@@ -0,0 +1,513 @@
+#include "solver.h"
+#include <algorithm>
+#include <climits>
+#include <tuple>
+#include <unordered_map>
+
+const char* roomSharingName(RoomSharing mode) {
+    switch (mode) {
+    case RoomSharing::Off:      return "off";
+    case RoomSharing::FirstFit: return "first-fit";
+    case RoomSharing::BestFit:  return "best-fit";
+    }
+    return "unknown";
+}
+
+void buildAllowedMasks(const std::vector<LabRequest>& requests, std::pmr::vector<SlotMask>& masks) {
+    masks.clear();
+    masks.reserve(requests.size());
+    for (const auto& request : requests) {
+        masks.push_back(kAllSlots & ~toSlotMask(request.excludedSlots));
+    }
+}
+
+void buildCourseKeys(const std::vector<LabRequest>& requests, std::pmr::vector<CourseKey>& keys) {
+    std::pmr::unordered_map<NameId, CourseKey> courseIds(keys.get_allocator().resource());
+    keys.clear();
+    keys.reserve(requests.size());
+    for (const auto& request : requests) {
+        CourseKey key = 0;
+        // 空字符串的名称编号为 0, 未填写课程
+        if (request.courseName > 0) {
+            auto it = courseIds.find(request.courseName);
+            if (it != courseIds.end()) {
+                key = it->second;
+            } else if (static_cast<int>(courseIds.size()) < kMaxCourseKeys) {
+                key = static_cast<CourseKey>(courseIds.size() + 1);
+                courseIds.emplace(request.courseName, key);
+            }
+        }
+        keys.push_back(key);
+    }
+}
+
+void buildFairnessGroups(const std::vector<LabRequest>& requests, FairnessGroup grouping,
+                         std::pmr::vector<int>& groups) {
+    std::pmr::unordered_map<NameId, int> groupIds(groups.get_allocator().resource());
+    groups.clear();
+    groups.reserve(requests.size());
+    for (const auto& request : requests) {
+        NameId key = grouping == FairnessGroup::Teacher ? request.teacherName : request.courseName;
+        auto inserted = groupIds.emplace(key, static_cast<int>(groupIds.size()));
+        groups.push_back(inserted.first->second);
+    }
+}
+
+GreedySolver::GreedySolver(const std::vector<Laboratory>& labs,
+                           const std::vector<LabRequest>& requests,
+                           std::span<const SlotMask> allowedMasks,
+                           const OccupancyGrid& initial,
+                           std::pmr::memory_resource* resource)
+    : requests(requests), allowedMasks(allowedMasks), resource(resource),
+      occupancy(initial, resource), supply(resource), groupCursor(resource), groupState(resource),
+      labKeys(resource) {
+    labKeys.reserve(labs.size());
+    for (const auto& lab : labs) {
+        labKeys.push_back({lab.capacity, lab.featureMask});
+    }
+    supply.reset(occupancy);
+}
+
+void GreedySolver::setOrderingStrategy(OrderingStrategy strategy, int bandWidth) {
+    ordering = strategy;
+    this->bandWidth = bandWidth;
+}
+
+void GreedySolver::setRoomSharing(RoomSharing mode, std::span<const CourseKey> courseKeys) {
+    sharing = mode;
+    this->courseKeys = courseKeys;
+    if ((mode != RoomSharing::Off) != occupancy.seatMode()) {
+        occupancy.setSeatMode(mode != RoomSharing::Off);
+        supply.reset(occupancy);
+    }
+}
+
+int GreedySolver::shareAtSlot(int requestIndex, int slot, bool& joined) {
+    const LabRequest& request = requests[requestIndex];
+    const int studentCount = request.studentCount;
+    const FeatureMask required = request.requiredMask;
+    const CourseKey course = courseKeys[requestIndex];
+    
+    // 首次适应: 第一个可加入或空闲的实验室;
+    // 最佳适应: 加入后剩余座位最少的已用实验室, 没有时取第一个空闲实验室
+    int chosen = -1;
+    int firstFree = -1;
+    int leastLeft = INT_MAX;
+    for (int labIndex = 0; labIndex < static_cast<int>(labKeys.size()); labIndex++) {
+        const LabKey& key = labKeys[labIndex];
+        stats.labsScanned++;
+        if (key.capacity < studentCount || (key.features & required) != required) {
+            continue;
+        }
+        stats.bitTests++;
+        if (occupancy.isFree(labIndex, slot)) {
+            if (firstFree < 0) {
+                firstFree = labIndex;
+                if (sharing == RoomSharing::FirstFit) {
+                    break;
+                }
+            }
+            continue;
+        }
+        if (!occupancy.canJoin(labIndex, slot, studentCount, course, request.shareable)) {
+            continue;
+        }
+        int left = occupancy.freeSeats(labIndex, slot) - studentCount;
+        if (left < leastLeft) {
+            chosen = labIndex;
+            leastLeft = left;
+            if (sharing == RoomSharing::FirstFit) {
+                break;
+            }
+        }
+    }
+    
+    joined = chosen >= 0;
+    if (!joined) {
+        chosen = firstFree;
+    }
+    if (chosen >= 0) {
+        occupancy.occupySeats(chosen, slot, studentCount, course, request.shareable);
+    }
+    return chosen;
+}
+
+int GreedySolver::findAtSlot(const LabRequest& request, int slot, int firstLab,
+                             SolverCounters& counters) const {
+    const int studentCount = request.studentCount;
+    const FeatureMask required = request.requiredMask;
+    
+    // 遍历所有实验室,寻找合适的实验室:
+    // 容量、设备特性、占用三项检查合并为一次无分支的判断,
+    // 因此扫描过的每个实验室都做一次占用位测试
+    const int labCount = static_cast<int>(labKeys.size());
+    for (int labIndex = firstLab; labIndex < labCount; labIndex++) {
+        const LabKey& key = labKeys[labIndex];
+        bool fits = (key.capacity >= studentCount) &
+                    ((key.features & required) == required) &
+                    occupancy.isFree(labIndex, slot);
+        if (fits) {
+            counters.labsScanned += labIndex + 1 - firstLab;
+            counters.bitTests += labIndex + 1 - firstLab;
+            return labIndex;
+        }
+    }
+    counters.labsScanned += labCount - firstLab;
+    counters.bitTests += labCount - firstLab;
+    return -1;
+}
+
+int GreedySolver::findCandidate(std::span<const int> candidates, int slot, int firstLab,
+                                SolverCounters& counters) const {
+    auto begin = firstLab > 0 ? std::lower_bound(candidates.begin(), candidates.end(), firstLab)
+                              : candidates.begin();
+    for (auto it = begin; it != candidates.end(); ++it) {
+        if (occupancy.isFree(*it, slot)) {
+            counters.labsScanned += it - begin + 1;
+            counters.bitTests += it - begin + 1;
+            return *it;
+        }
+    }
+    counters.labsScanned += candidates.end() - begin;
+    counters.bitTests += candidates.end() - begin;
+    return -1;
+}
+
+/**
+ * @brief 按分配顺序依次在各时间段调用 tryAtSlot(slot, firstLab, joined), 直到得到实验室下标
+ * @param preferred 期望时间段编号(按申请中给出的顺序), 不在 allowed 中的跳过
+ * @param fallback 期望时间段之后按日历顺序尝试的时间槽(与 allowed 取交集)
+ *
+ * 每个时间段内按实验室列表顺序。
+ * resume 非空时从该分配位置之后继续: 占用只增不减, 该位置及之前的单元已确认不可用。
+ * timed 为 false 时不读时钟(见 GreedySolver::setPhaseTiming)。
+ */
+template <typename TryAtSlot>
+static bool scanSlots(std::span<const int> preferred, SlotMask fallback, SlotMask allowed,
+                      const Placement* resume, Placement& placement, SolverCounters& counters,
+                      bool timed, TryAtSlot tryAtSlot) {
+    const int64_t phaseStart = timed ? monotonicNanos() : 0;
+
+    // 阶段1: 优先尝试分配到期望的时间段(按申请中给出的顺序)
+    if (resume == nullptr || resume->preferred) {
+        bool skipping = resume != nullptr;
+        for (int slot : preferred) {
+            int firstLab = 0;
+            if (skipping) {
+                if (slot != resume->slot) {
+                    continue;
+                }
+                skipping = false;
+                firstLab = resume->labIndex + 1;
+            }
+            // 跳过排除列表中以及(剪枝时)没有足够大空闲实验室的时间段
+            if (!hasSlot(allowed, slot)) {
+                continue;
+            }
+
+            bool joined = false;
+            int labIndex = tryAtSlot(slot, firstLab, joined);
+            if (labIndex >= 0) {
+                placement.labIndex = labIndex;
+                placement.slot = slot;
+                placement.preferred = true;
+                placement.shared = joined;
+                if (timed) {
+                    counters.preferredNanos += monotonicNanos() - phaseStart;
+                }
+                return true;
+            }
+        }
+    }
+    const int64_t fallbackStart = timed ? monotonicNanos() : 0;
+    if (timed) {
+        counters.preferredNanos += fallbackStart - phaseStart;
+    }
+
+    // 阶段2: 如果期望时间段都无法满足,按日历顺序尝试其他可用时间段
+    // (跳过排除的时间段和已经尝试过的期望时间段)
+    SlotMask remaining = allowed & fallback;
+    const bool resumeFallback = resume != nullptr && !resume->preferred;
+    while (remaining) {
+        int slot = lowestSlot(remaining);
+        clearLowestSlot(remaining);
+        if (resumeFallback && slot < resume->slot) {
+            continue;
+        }
+
+        bool joined = false;
+        int firstLab = resumeFallback && slot == resume->slot ? resume->labIndex + 1 : 0;
+        int labIndex = tryAtSlot(slot, firstLab, joined);
+        if (labIndex >= 0) {
+            placement.labIndex = labIndex;
+            placement.slot = slot;
+            placement.preferred = false;
+            placement.shared = joined;
+            if (timed) {
+                counters.fallbackNanos += monotonicNanos() - fallbackStart;
+            }
+            return true;
+        }
+    }
+
+    // 无法为该申请分配合适的时间段和实验室
+    if (timed) {
+        counters.fallbackNanos += monotonicNanos() - fallbackStart;
+    }
+    return false;
+}
+
+/**
+ * @brief 申请自身的期望时间段编号(去掉日历范围外与重复的时间段), 返回其位图
+ */
+static SlotMask listPreferred(const LabRequest& request, int* slots, int& count) {
+    SlotMask listed = 0;
+    count = 0;
+    for (const auto& preferredSlot : request.preferredSlots) {
+        int slot = slotIndex(preferredSlot);
+        if (slot >= 0 && !hasSlot(listed, slot)) {
+            listed |= slotBit(slot);
+            slots[count++] = slot;
+        }
+    }
+    return listed;
+}
+
+/**
+ * @brief 分配位置在同组申请的尝试顺序中的先后, 用于比较两个续扫起点
+ */
+static std::tuple<int, int, int> scanPosition(std::span<const int> preferred, const Placement& placement) {
+    if (placement.preferred) {
+        int rank = static_cast<int>(std::find(preferred.begin(), preferred.end(), placement.slot) - preferred.begin());
+        return {0, rank, placement.labIndex};
+    }
+    return {1, placement.slot, placement.labIndex};
+}
+
+bool GreedySolver::probeRequest(int requestIndex, const Placement* resume, Placement& placement,
+                                SolverCounters& counters) const {
+    const LabRequest& request = requests[requestIndex];
+    SlotMask allowed = allowedMasks[requestIndex];
+    placement.requestIndex = requestIndex;
+
+    // 同组已有成员分配失败时, 本申请的候选单元也都已不可用
+    const int group = groups != nullptr ? groups->groupOf(requestIndex) : -1;
+    if (group >= 0 && groupState[group] == GroupState::Exhausted) {
+        counters.hopelessSkipped++;
+        return false;
+    }
+
+    // 只保留还有足够大的空闲实验室的时间段; 一个都没有时不必扫描
+    if (pruning) {
+        allowed &= supply.openSlots(supply.bandOf(request.studentCount));
+        if (!allowed) {
+            counters.hopelessSkipped++;
+            return false;
+        }
+    }
+
+    if (group < 0) {
+        int preferred[kSlotCount];
+        int count;
+        SlotMask listed = listPreferred(request, preferred, count);
+        return scanSlots(std::span<const int>(preferred, count), ~listed, allowed, resume, placement, counters,
+                         phaseTiming, [&](int slot, int firstLab, bool&) {
+                             return findAtSlot(request, slot, firstLab, counters);
+                         });
+    }
+
+    // 同组上一个成员的分配位置及之前的单元都已不可用: 从两个续扫起点中靠后的一个继续
+    const int pattern = groups->pattern(group);
+    std::span<const int> preferred = patterns->preferred(pattern);
+    if (groupState[group] == GroupState::Placed &&
+        (resume == nullptr || scanPosition(preferred, *resume) < scanPosition(preferred, groupCursor[group]))) {
+        resume = &groupCursor[group];
+    }
+    std::span<const int> candidates = groups->candidates(group);
+    return scanSlots(preferred, patterns->fallback(pattern), allowed, resume, placement, counters,
+                     phaseTiming, [&](int slot, int firstLab, bool&) {
+                         return findCandidate(candidates, slot, firstLab, counters);
+                     });
+}
+
+void GreedySolver::commit(const Placement& placement) {
+    // 找到合适的实验室和时间段,标记占用
+    occupancy.occupy(placement.labIndex, placement.slot);
+    supply.occupy(placement.labIndex, placement.slot);
+    (placement.preferred ? stats.preferredPlacements : stats.fallbackPlacements)++;
+    if (groups != nullptr) {
+        int group = groups->groupOf(placement.requestIndex);
+        groupCursor[group] = placement;
+        groupState[group] = GroupState::Placed;
+    }
+}
+
+void GreedySolver::markFailed(int requestIndex) {
+    if (groups != nullptr) {
+        groupState[groups->groupOf(requestIndex)] = GroupState::Exhausted;
+    }
+}
+
+bool GreedySolver::allocateRequest(int requestIndex, Placement& placement) {
+    stats.requests++;
+    if (sharing == RoomSharing::Off) {
+        if (!probeRequest(requestIndex, nullptr, placement, stats)) {
+            markFailed(requestIndex);
+            return false;
+        }
+        commit(placement);
+        return true;
+    }
+
+    // 教室共享模式: 已有人使用的单元仍可加入, 不剪枝也不按组续扫
+    const LabRequest& request = requests[requestIndex];
+    int preferred[kSlotCount];
+    int count;
+    SlotMask listed = listPreferred(request, preferred, count);
+    placement.requestIndex = requestIndex;
+    bool placed = scanSlots(std::span<const int>(preferred, count), ~listed, allowedMasks[requestIndex], nullptr,
+                            placement, stats, phaseTiming,
+                            [&](int slot, int, bool& joined) {
+                                return shareAtSlot(requestIndex, slot, joined);
+                            });
+    if (placed) {
+        (placement.preferred ? stats.preferredPlacements : stats.fallbackPlacements)++;
+    }
+    return placed;
+}
+
+int GreedySolver::solve(std::span<const int> subset, std::pmr::vector<Placement>& placements) {
+    if (ordering == OrderingStrategy::FairShare) {
+        return solveFair(subset, placements);
+    }
+    RequestQueue queue(ordering, requests, subset, allowedMasks, occupancy, bandWidth, resource);
+    placements.reserve(placements.size() + subset.size());
+
+    int successCount = 0;
+    int index;
+    while (queue.next(index)) {
+        Placement placement;
+        if (allocateRequest(index, placement)) {
+            successCount++;
+            placements.push_back(placement);
+            // 可行单元计数按单元是否有人使用计算, 加入已用单元不改变计数
+            if (!placement.shared) {
+                queue.onPlaced(placement.labIndex, placement.slot);
+            }
+        }
+    }
+    return successCount;
+}
+
+void GreedySolver::setRequestGroups(const SlotPatternTable& patterns, const RequestGroups& groups) {
+    this->patterns = &patterns;
+    this->groups = &groups;
+    groupCursor.assign(groups.size(), Placement{});
+    groupState.assign(groups.size(), GroupState::Fresh);
+}
+
+void GreedySolver::release(std::span<const Placement> placements, size_t from) {
+    // 撤销占用后各组记录的分配位置不再成立
+    std::fill(groupState.begin(), groupState.end(), GroupState::Fresh);
+    for (size_t i = from; i < placements.size(); i++) {
+        occupancy.release(placements[i].labIndex, placements[i].slot,
+                          requests[placements[i].requestIndex].studentCount);
+        if (sharing == RoomSharing::Off) {
+            supply.release(placements[i].labIndex, placements[i].slot);
+        }
+    }
+}
+
+int GreedySolver::solveFair(std::span<const int> subset, std::pmr::vector<Placement>& placements) {
+    FairQueue queue(subset, fairnessGroups, resource);
+    placements.reserve(placements.size() + subset.size());
+
+    int successCount = 0;
+    int index;
+    while (queue.next(index)) {
+        Placement placement;
+        bool placed = allocateRequest(index, placement);
+        if (placed) {
+            successCount++;
+            placements.push_back(placement);
+        }
+        queue.onResult(placed && placement.preferred);
+    }
+    return successCount;
+}
+
+int GreedySolver::solveSpeculative(std::span<const int> subset, std::pmr::vector<Placement>& placements,
+                                   ThreadPool& pool) {
+    const bool staticOrder = ordering == OrderingStrategy::Priority ||
+                             ordering == OrderingStrategy::LargestClass;
+    if (sharing != RoomSharing::Off || !staticOrder || pool.size() <= 1) {
+        return solve(subset, placements);
+    }
+
+    // 静态策略的处理顺序在开始时即已确定
+    std::pmr::vector<int> order(resource);
+    order.reserve(subset.size());
+    RequestQueue queue(ordering, requests, subset, allowedMasks, occupancy, bandWidth, resource);
+    int index;
+    while (queue.next(index)) {
+        order.push_back(index);
+    }
+    placements.reserve(placements.size() + order.size());
+
+    const size_t window = std::max(kMinSpeculationWindow, pool.size() * kSpeculationPerThread);
+    const size_t taskCount = pool.size() * 4;
+    std::pmr::vector<Placement> guesses(std::min(window, order.size()), resource);
+    std::pmr::vector<char> found(guesses.size(), resource);
+    // 每个工作线程的计数器独占一个缓存行
+    struct alignas(64) WorkerCounters {
+        SolverCounters counters;
+    };
+    std::pmr::vector<WorkerCounters> workerCounters(pool.size(), resource);
+
+    int successCount = 0;
+    for (size_t begin = 0; begin < order.size(); begin += window) {
+        const size_t count = std::min(window, order.size() - begin);
+
+        // 推测: 各线程在本窗口开始时的占用表上求出各申请的分配位置, 期间占用表只读
+        const size_t chunk = (count + taskCount - 1) / taskCount;
+        for (size_t from = 0; from < count; from += chunk) {
+            const size_t to = std::min(count, from + chunk);
+            pool.submit([this, &order, &guesses, &found, &workerCounters, begin, from, to](int worker) {
+                SolverCounters& counters = workerCounters[worker].counters;
+                for (size_t k = from; k < to; k++) {
+                    found[k] = probeRequest(order[begin + k], nullptr, guesses[k], counters);
+                }
+            });
+        }
+        pool.wait();
+
+        // 确认: 按处理顺序逐个检查推测位置是否已被本窗口中更早的申请占用
+        const int64_t confirmStart = monotonicNanos();
+        for (size_t k = 0; k < count; k++) {
+            stats.requests++;
+            // 推测时已无可行单元: 之后占用只增不减, 失败是确定的
+            if (!found[k]) {
+                markFailed(order[begin + k]);
+                continue;
+            }
+            Placement placement = guesses[k];
+            if (!occupancy.isFree(placement.labIndex, placement.slot)) {
+                // 冲突: 从推测位置之后继续扫描, 结果与顺序求解时这一步的结果相同
+                stats.speculativeConflicts++;
+                if (!probeRequest(order[begin + k], &guesses[k], placement, stats)) {
+                    markFailed(order[begin + k]);
+                    continue;
+                }
+            }
+            commit(placement);
+            placements.push_back(placement);
+            successCount++;
+        }
+        stats.confirmNanos += monotonicNanos() - confirmStart;
+    }
+
+    for (const auto& worker : workerCounters) {
+        stats.add(worker.counters);
+    }
+    return successCount;
+}
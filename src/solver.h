@@ -0,0 +1,259 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "feasibility.h"
+#include "instrumentation.h"
+#include "lab_types.h"
+#include "occupancy.h"
+#include "request_order.h"
+#include "slot_pattern.h"
+#include "thread_pool.h"
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// 单个申请的分配结果
+struct Placement {
+    int requestIndex;  // 申请在 requests 中的下标
+    int labIndex;      // 实验室在 labs 中的下标
+    int slot;          // 时间槽编号
+    bool preferred;    // 是否在第一阶段(期望时间段)完成分配
+    bool shared;       // 是否加入了已有其他班级使用的实验室时间段(教室共享模式)
+};
+
+/**
+ * @brief 教室共享模式
+ *
+ * 启用后一个 (实验室, 时间槽) 单元按座位计算占用, 同一课程的班级,
+ * 或者都标记为可共享的班级, 可以在座位足够时共用同一个实验室时间段。
+ */
+enum class RoomSharing {
+    Off,       // 每个单元只安排一个班级(默认)
+    FirstFit,  // 按实验室顺序放入第一个可加入或空闲的实验室
+    BestFit    // 优先加入放入后剩余座位最少的已用实验室, 没有时才占用新的实验室
+};
+
+const char* roomSharingName(RoomSharing mode);
+
+/**
+ * @brief 每个申请允许的时间槽位图: 全部时间槽去掉排除时间段
+ */
+void buildAllowedMasks(const std::vector<LabRequest>& requests, std::pmr::vector<SlotMask>& masks);
+
+/**
+ * @brief 教室共享模式下每个申请的课程编号, 同一课程的班级编号相同, 未填写课程为 0
+ *
+ * 按课程名称编号(LabRequest::courseName)归类, 不比较字符串;
+ * 课程过多时超出 kMaxCourseKeys 的部分编号为 0(不参与按课程共用)。
+ */
+void buildCourseKeys(const std::vector<LabRequest>& requests, std::pmr::vector<CourseKey>& keys);
+
+/**
+ * @brief FairShare 策略下每个申请的组编号(按首次出现的顺序从 0 编号)
+ *
+ * 按教师或课程的名称编号(LabRequest::teacherName / courseName)归类。
+ */
+void buildFairnessGroups(const std::vector<LabRequest>& requests, FairnessGroup grouping,
+                         std::pmr::vector<int>& groups);
+
+/**
+ * @brief 贪心分配内核
+ *
+ * 只在内存中的占用表上工作, 不访问数据库, 因此可以在多个线程中
+ * 各自持有一个实例并行求解互不相交的子问题。
+ * requests/allowedMasks 由调用方持有, 在内核生命周期内不得修改。
+ *
+ * 占用表副本、实验室属性和每次 solve 的排序队列都从构造时给定的内存资源分配。
+ * 传入单次运行的内存区域(见 arena.h)且 placements 预留足够容量时,
+ * 求解循环中不会向全局堆申请内存。
+ */
+class GreedySolver {
+public:
+    /**
+     * @param allowedMasks 每个申请允许的时间槽位图(已去除排除时间段)
+     * @param initial 初始占用与容量索引(内核保存一份副本)
+     * @param resource 内核内部数据的内存来源
+     */
+    GreedySolver(const std::vector<Laboratory>& labs,
+                 const std::vector<LabRequest>& requests,
+                 std::span<const SlotMask> allowedMasks,
+                 const OccupancyGrid& initial,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void setOrderingStrategy(OrderingStrategy strategy, int bandWidth);
+
+    /**
+     * @brief 设置教室共享模式
+     * @param courseKeys 每个申请的课程编号(0 表示不按课程共用), 由调用方持有
+     *
+     * 启用时内核的占用表切换为座位级占用, 初始已占用的单元视为没有剩余座位。
+     */
+    void setRoomSharing(RoomSharing mode, std::span<const CourseKey> courseKeys);
+    
+    /**
+     * @brief 是否用各容量档的空闲单元计数(见 SlotSupply)剪枝, 默认启用
+     *
+     * 启用时已没有足够大的空闲实验室的申请直接判定失败, 两个阶段都跳过没有足够大空闲实验室的时间段,
+     * 分配结果与不剪枝时完全相同。教室共享模式下已用单元仍可加入, 不剪枝。
+     */
+    void setPruning(bool enabled) { pruning = enabled; }
+
+    /**
+     * @brief 是否分别统计期望/备选时间段阶段的耗时(SolverCounters::preferredNanos/fallbackNanos), 默认关闭
+     *
+     * 开启时每个申请读取 2~3 次单调时钟; 关闭时分配循环中不读时钟, 两项保持为 0。
+     */
+    void setPhaseTiming(bool enabled) { phaseTiming = enabled; }
+
+    /**
+     * @brief 设置 FairShare 策略使用的组编号(见 buildFairnessGroups), 由调用方持有
+     */
+    void setFairnessGroups(std::span<const int> groups) { fairnessGroups = groups; }
+
+    /**
+     * @brief 设置时间段模式表与申请分组(见 slot_pattern.h), 由调用方持有
+     *
+     * 设置后(教室共享关闭时)每个申请的尝试顺序取自其模式, 只扫描所在组的候选实验室,
+     * 并从同组上一个成员的分配位置之后继续; 同组已有成员失败时直接判定失败。
+     * 分配结果与不设置时完全相同。
+     */
+    void setRequestGroups(const SlotPatternTable& patterns, const RequestGroups& groups);
+
+    /**
+     * @brief 按排序策略依次分配 subset 中的申请
+     * @param subset 待分配申请的下标(按优先级顺序)
+     * @param placements 成功的分配结果追加到此处(预先为 subset 预留容量)
+     * @return 成功分配的申请数量
+     */
+    int solve(std::span<const int> subset, std::pmr::vector<Placement>& placements);
+
+    /**
+     * @brief 推测并行求解, 结果与 solve 完全相同
+     * @param pool 执行推测的线程池
+     *
+     * 处理顺序按窗口切分。每个窗口先由线程池并行求出各申请在窗口开始时的占用表上的分配位置
+     * (推测, 期间占用表只读), 再由调用线程按处理顺序确认:
+     * 占用只增不减, 推测位置之前的单元此时仍不可用, 所以推测位置若仍空闲就是顺序求解的结果;
+     * 若已被同一窗口中更早的申请占用(冲突), 则从推测位置之后继续扫描。
+     * 确认时每个申请只需一次占用位测试, 扫描工作几乎全部在线程池中完成。
+     *
+     * 仅适用于处理顺序预先确定的策略(Priority/LargestClass)且教室共享关闭,
+     * 其他情况以及线程池只有一个线程时直接调用 solve。
+     */
+    int solveSpeculative(std::span<const int> subset, std::pmr::vector<Placement>& placements,
+                         ThreadPool& pool);
+
+    /**
+     * @brief 撤销 placements[from..] 在占用表中的占用,
+     *        使同一内核可以依次求解多个互不相交的子问题
+     *
+     * 教室共享时只归还这些班级的座位, 与其他班级共用的单元在其余班级撤销前保持占用。
+     */
+    void release(std::span<const Placement> placements, size_t from);
+
+    const OccupancyGrid& grid() const { return occupancy; }
+
+    /**
+     * @brief 自构造或上次 resetCounters 以来的内核计数器
+     */
+    const SolverCounters& counters() const { return stats; }
+    void resetCounters() { stats = SolverCounters(); }
+
+private:
+    const std::vector<LabRequest>& requests;
+    std::span<const SlotMask> allowedMasks;
+    std::pmr::memory_resource* resource;
+    OccupancyGrid occupancy;
+    SlotSupply supply;  // 与 occupancy 同步的各容量档空闲单元计数
+    bool pruning = true;
+    bool phaseTiming = false;
+    OrderingStrategy ordering = OrderingStrategy::Priority;
+    RoomSharing sharing = RoomSharing::Off;
+    std::span<const CourseKey> courseKeys;
+    std::span<const int> fairnessGroups;
+
+    // 申请分组与每组的续扫位置(未设置分组时为空)
+    enum class GroupState : uint8_t {
+        Fresh,     // 尚无成员分配
+        Placed,    // groupCursor 为最近一个成员的分配位置
+        Exhausted  // 已有成员分配失败
+    };
+    const SlotPatternTable* patterns = nullptr;
+    const RequestGroups* groups = nullptr;
+    std::pmr::vector<Placement> groupCursor;
+    std::pmr::vector<GroupState> groupState;
+
+    // 候选筛选所需的实验室属性, 连续存放以便在最内层循环中顺序扫描
+    struct LabKey {
+        int capacity;
+        FeatureMask features;
+    };
+    std::pmr::vector<LabKey> labKeys;
+    int bandWidth = 10;
+    SolverCounters stats;
+
+    // 推测窗口: 至少 kMinSpeculationWindow 个申请, 每个工作线程 kSpeculationPerThread 个
+    static constexpr size_t kMinSpeculationWindow = 512;
+    static constexpr size_t kSpeculationPerThread = 256;
+
+    /**
+     * @brief 尝试为申请分配实验室
+     * @return 是否成功分配
+     *
+     * 算法详细步骤：
+     * 1. 首先尝试期望时间段(优先级最高)
+     * 2. 对于每个期望时间段:
+     *    - 遍历所有实验室
+     *    - 检查容量与设备特性是否满足
+     *    - 检查时间段是否已被占用
+     *    - 如果找到合适的实验室,分配并返回true
+     * 3. 如果期望时间段都无法满足,按日历顺序尝试其余允许的时间段
+     * 4. 排除不可用时间段(excluded slots)
+     * 5. 返回分配结果
+     */
+    bool allocateRequest(int requestIndex, Placement& placement);
+
+    /**
+     * @brief 在当前占用表上求出申请的分配位置, 不修改占用表(教室共享关闭时)
+     * @param resume 非空时从这次推测结果之后继续扫描(见 solveSpeculative)
+     * @param counters 扫描计数累加到此处(推测时为工作线程自己的计数器)
+     * @return 是否找到可行单元
+     */
+    bool probeRequest(int requestIndex, const Placement* resume, Placement& placement,
+                      SolverCounters& counters) const;
+
+    /**
+     * @brief 占用 probeRequest 求出的单元, 并记录为所在组的续扫位置
+     */
+    void commit(const Placement& placement);
+
+    /**
+     * @brief 记录申请在当前占用下分配失败(所在组的其余成员随之失败)
+     */
+    void markFailed(int requestIndex);
+
+    /**
+     * @brief 在指定时间段从 firstLab 起按实验室列表顺序寻找容量足够、设备齐全且空闲的实验室
+     * @return 成功时返回实验室下标, 否则返回 -1
+     */
+    int findAtSlot(const LabRequest& request, int slot, int firstLab, SolverCounters& counters) const;
+
+    /**
+     * @brief 同上, 只检查组的候选实验室(均已满足容量与设备要求)
+     */
+    int findCandidate(std::span<const int> candidates, int slot, int firstLab, SolverCounters& counters) const;
+
+    /**
+     * @brief 教室共享模式下在指定时间段选择实验室并占用座位
+     * @param joined 输出是否加入了已有班级使用的实验室
+     * @return 成功时返回实验室下标, 否则返回 -1
+     */
+    int shareAtSlot(int requestIndex, int slot, bool& joined);
+
+    /**
+     * @brief FairShare 策略的求解循环: 按组满足比例取申请, 并把分配结果反馈给队列
+     */
+    int solveFair(std::span<const int> subset, std::pmr::vector<Placement>& placements);
+};
+
+#endif // SOLVER_H
@@ -0,0 +1,71 @@
+#include "string_interner.h"
+#include <cstring>
+#include <mutex>
+
+StringInterner::StringInterner() {
+    intern(std::string_view());
+}
+
+NameId StringInterner::intern(std::string_view text) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(text);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(text);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    // 超过一块大小的字符串单独占用一块, 当前块继续用于之后的字符串
+    char* copy = nullptr;
+    if (text.empty()) {
+        // 空字符串不占用存储
+    } else if (text.size() > kBlockBytes) {
+        blocks.push_back(std::make_unique<char[]>(text.size()));
+        copy = blocks.back().get();
+    } else {
+        if (!current || blockUsed + text.size() > kBlockBytes) {
+            blocks.push_back(std::make_unique<char[]>(kBlockBytes));
+            current = blocks.back().get();
+            blockUsed = 0;
+        }
+        copy = current + blockUsed;
+        blockUsed += text.size();
+    }
+    if (copy) {
+        std::memcpy(copy, text.data(), text.size());
+    }
+    stored += text.size();
+
+    NameId id = static_cast<NameId>(names.size());
+    std::string_view saved(copy, text.size());
+    names.push_back(saved);
+    ids.emplace(saved, id);
+    return id;
+}
+
+NameId StringInterner::find(std::string_view text) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(text);
+    return it != ids.end() ? it->second : kNoName;
+}
+
+std::string_view StringInterner::view(NameId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return id >= 0 && id < static_cast<NameId>(names.size()) ? names[id] : std::string_view();
+}
+
+int StringInterner::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return static_cast<int>(names.size());
+}
+
+size_t StringInterner::bytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return stored;
+}
@@ -0,0 +1,73 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 驻留字符串的编号, 只在同一个 StringInterner(即同一个数据库)内有效
+using NameId = int32_t;
+
+constexpr NameId kNoName = -1;
+
+/**
+ * @brief 字符串驻留表: 每个不同的字符串只保存一份, 以稳定的整数编号引用
+ *
+ * 数据库加载实验室与申请时把地址、班级、教师与课程名称登记到本表(见 Database::names),
+ * 求解过程只比较编号, 需要显示或导出时再用 view 取回名称。
+ * 字符串按块追加存放, 块既不移动也不释放, 因此 view 返回的 string_view 在本表的生命周期内一直有效。
+ * 编号从 0 起连续分配, 空字符串的编号总是 0。
+ * 可在多个线程中同时登记与查询(内部使用读写锁, 已登记的名称只需读锁)。
+ */
+class StringInterner {
+public:
+    StringInterner();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    /**
+     * @brief 获取字符串的编号, 首次出现时复制一份并分配新编号
+     */
+    NameId intern(std::string_view text);
+
+    /**
+     * @brief 查找已登记的字符串, 未登记时返回 kNoName
+     */
+    NameId find(std::string_view text) const;
+
+    /**
+     * @brief 编号对应的字符串, 编号无效时返回空串
+     */
+    std::string_view view(NameId id) const;
+
+    int size() const;
+
+    /**
+     * @brief 已保存的字符串字节数之和
+     */
+    size_t bytes() const;
+
+private:
+    struct TextHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    static constexpr size_t kBlockBytes = 64 * 1024;
+
+    mutable std::shared_mutex mutex;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current = nullptr;  // 正在追加的块
+    size_t blockUsed = 0;     // 当前块已用的字节数
+    size_t stored = 0;
+    std::vector<std::string_view> names;  // 编号 -> 字符串(指向 blocks)
+    std::unordered_map<std::string_view, NameId, TextHash, std::equal_to<>> ids;
+};
+
+#endif // STRING_INTERNER_H
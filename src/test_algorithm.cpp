@@ -1,4 +1,5 @@
 #include "database.h"
+#include "scenario.h"
 #include "scheduler.h"
 #include <iostream>
 #include <vector>
@@ -140,6 +141,31 @@ int main() {
                   << " - " << lab.location << std::endl;
     }
     
+    // 7. 假设分析: 第9周关闭A301, 只在内存中求解并与当前课表比较
+    std::cout << "\n[7] 假设分析: 第9周关闭实验楼A301" << std::endl;
+    Scenario baseline = Scenario::fromDatabase(db);
+    Scenario closed = baseline.fork();
+    closed.closeLab("实验楼A301", weekSlots(9));
+    closed.solve();
+    ScenarioDiff diff = closed.diff();
+    std::cout << "基线分配: " << diff.baselinePlaced << ", 场景分配: " << diff.scenarioPlaced
+              << ", 不变: " << diff.unchanged << std::endl;
+    for (const auto& change : diff.changes) {
+        const char* kind = change.kind == ScheduleChange::Kind::Placed ? "新分配"
+                         : change.kind == ScheduleChange::Kind::Dropped ? "失去分配" : "调整";
+        std::cout << "  " << kind << ": " << change.classId;
+        if (change.kind != ScheduleChange::Kind::Placed) {
+            std::cout << " 原 " << db.getLaboratory(change.fromLabId).location << " "
+                      << days[change.from.day] << " " << periods[change.from.period];
+        }
+        if (change.kind != ScheduleChange::Kind::Dropped) {
+            std::cout << " -> " << db.getLaboratory(change.toLabId).location << " "
+                      << days[change.to.day] << " " << periods[change.to.period];
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "数据库中的课表未改变: " << db.getAllSchedules().size() << " 条" << std::endl;
+    
     std::cout << "\n=== 测试完成 ===" << std::endl;
     return 0;
 }
@@ -0,0 +1,1336 @@
+#include "arena.h"
+#include "bulk_io.h"
+#include "core_scheduler.h"
+#include "database.h"
+#include "scenario.h"
+#include "scheduler.h"
+#include "sharding.h"
+#include "timetable_export.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 调度正确性测试(无界面, 供 ctest 运行): 随机生成实例, 运行所有求解方式,
+// 检查课表不变量, 并与一个直接按算法描述编写的参考实现逐条对照。
+// 用法: test_scheduler [实例数] [起始种子]
+// 全部通过时返回 0, 否则返回 1 并在标准错误输出中列出前若干处错误。
+
+static const char* const kFeatureNames[] = {"fume_hood", "gpu", "oscilloscope"};
+
+// 随机实例: 数据由生成器直接持有, 不经过数据库与任何索引
+struct Instance {
+    unsigned seed = 0;
+    std::vector<Laboratory> labs;      // 按导入顺序, 即数据库中的实验室顺序
+    std::vector<LabRequest> requests;  // 按 priority 排序(priority 互不相同)
+};
+
+// 一条分配结果, 以班级与实验室名称标识, 与数据库编号无关
+struct Assignment {
+    std::string classId;
+    std::string location;
+    int slot;
+
+    bool operator==(const Assignment& other) const {
+        return classId == other.classId && location == other.location && slot == other.slot;
+    }
+};
+
+static int failures = 0;
+static const int kMaxReportedFailures = 30;
+
+static void fail(unsigned seed, const std::string& engine, const std::string& message) {
+    failures++;
+    if (failures <= kMaxReportedFailures) {
+        std::cerr << "[种子 " << seed << "] " << engine << ": " << message << std::endl;
+    }
+}
+
+static bool contains(const std::vector<TimeSlot>& slots, const TimeSlot& slot) {
+    return std::find(slots.begin(), slots.end(), slot) != slots.end();
+}
+
+static bool hasFeatures(const Laboratory& lab, const LabRequest& request) {
+    for (const auto& name : request.requiredFeatures) {
+        if (std::find(lab.features.begin(), lab.features.end(), name) == lab.features.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool blackedOut(const Laboratory& lab, int slot) {
+    return hasSlot(lab.blackout, slot);
+}
+
+static std::vector<TimeSlot> randomSlots(std::mt19937& rng, int count) {
+    std::vector<TimeSlot> slots;
+    for (int k = 0; k < count; k++) {
+        slots.push_back(slotFromIndex(rng() % kSlotCount));
+    }
+    return slots;
+}
+
+static Instance randomInstance(unsigned seed) {
+    std::mt19937 rng(seed);
+    Instance instance;
+    instance.seed = seed;
+    const int capacities[] = {20, 30, 40, 50, 60, 80};
+    const bool withFeatures = seed % 2 == 1;
+
+    int labCount = 1 + rng() % 30;
+    for (int i = 0; i < labCount; i++) {
+        Laboratory lab{};
+        lab.location = "L" + std::to_string(i);
+        lab.capacity = capacities[rng() % 6];
+        for (const char* name : kFeatureNames) {
+            if (withFeatures && rng() % 3 == 0) {
+                lab.features.push_back(name);
+            }
+        }
+        instance.labs.push_back(lab);
+    }
+
+    // 不可用时间段使用独立的随机数序列; 每三个实例中有一个没有不可用时间段
+    std::mt19937 blackoutRng(seed + 4);
+    for (auto& lab : instance.labs) {
+        if (seed % 3 != 0 && blackoutRng() % 4 == 0) {
+            for (const auto& slot : randomSlots(blackoutRng, 1 + blackoutRng() % 6)) {
+                lab.blackout |= slotBit(slotIndex(slot));
+            }
+        }
+    }
+
+    // 少量共用的时间段模式使同一模式的申请互相竞争; 期望时间段可能重复或被排除
+    std::vector<std::pair<std::vector<TimeSlot>, std::vector<TimeSlot>>> patterns;
+    for (int i = 0; i < 6; i++) {
+        patterns.emplace_back(randomSlots(rng, 1 + rng() % 4), randomSlots(rng, rng() % (kSlotCount / 2)));
+    }
+
+    int requestCount = 1 + rng() % 400;
+    std::vector<int> priorities(requestCount);
+    std::iota(priorities.begin(), priorities.end(), 1);
+    std::shuffle(priorities.begin(), priorities.end(), rng);
+    for (int i = 0; i < requestCount; i++) {
+        LabRequest request{};
+        request.classId = "C" + std::to_string(i);
+        request.studentCount = 10 + rng() % 81;
+        request.teacher = "T" + std::to_string(rng() % 7);
+        request.priority = priorities[i];
+        if (rng() % 4 == 0) {
+            request.preferredSlots = randomSlots(rng, 1 + rng() % 4);
+            request.excludedSlots = randomSlots(rng, rng() % kSlotCount);
+        } else {
+            const auto& pattern = patterns[rng() % patterns.size()];
+            request.preferredSlots = pattern.first;
+            request.excludedSlots = pattern.second;
+        }
+        if (withFeatures && rng() % 5 == 0) {
+            request.requiredFeatures.push_back(kFeatureNames[rng() % 3]);
+        }
+        if (rng() % 2 == 0) {
+            request.course = "K" + std::to_string(rng() % 5);
+        }
+        request.shareable = rng() % 3 == 0;
+        instance.requests.push_back(request);
+    }
+    std::sort(instance.requests.begin(), instance.requests.end(),
+              [](const LabRequest& a, const LabRequest& b) { return a.priority < b.priority; });
+    return instance;
+}
+
+// ---------- 导入 ----------
+
+static std::string quoted(const std::string& text) {
+    return "\"" + text + "\"";
+}
+
+static std::string joinFeatures(const std::vector<std::string>& names) {
+    std::string text;
+    for (size_t i = 0; i < names.size(); i++) {
+        text += (i > 0 ? "," : "") + names[i];
+    }
+    return text;
+}
+
+/**
+ * @brief 把实例写成 CSV 文本, 申请按打乱的顺序导入数据库
+ *
+ * 数据库按 priority 返回申请, 因此导入顺序不应影响任何求解结果。
+ */
+static bool importInstance(const Instance& instance, Database& db) {
+    std::string labsCsv = "location,capacity,features,blackout_slots\n";
+    for (const auto& lab : instance.labs) {
+        std::vector<TimeSlot> blackout;
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            if (blackedOut(lab, slot)) {
+                blackout.push_back(slotFromIndex(slot));
+            }
+        }
+        labsCsv += lab.location + "," + std::to_string(lab.capacity) + "," +
+                   quoted(joinFeatures(lab.features)) + "," + quoted(Database::serializeTimeSlots(blackout)) + "\n";
+    }
+
+    std::vector<const LabRequest*> shuffled;
+    for (const auto& request : instance.requests) {
+        shuffled.push_back(&request);
+    }
+    std::mt19937 rng(instance.seed + 1);
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    std::string requestsCsv =
+        "class_id,student_count,teacher,preferred_slots,excluded_slots,priority,required_features,course,shareable\n";
+    for (const LabRequest* request : shuffled) {
+        requestsCsv += request->classId + "," + std::to_string(request->studentCount) + "," +
+                       request->teacher + "," +
+                       quoted(Database::serializeTimeSlots(request->preferredSlots)) + "," +
+                       quoted(Database::serializeTimeSlots(request->excludedSlots)) + "," +
+                       std::to_string(request->priority) + "," +
+                       quoted(joinFeatures(request->requiredFeatures)) + "," +
+                       request->course + "," + (request->shareable ? "1" : "0") + "\n";
+    }
+
+    ImportReport labReport;
+    ImportReport requestReport;
+    if (!importLaboratoriesBuffer(db, labsCsv.data(), labsCsv.size(), ',', labReport) ||
+        !importRequestsBuffer(db, requestsCsv.data(), requestsCsv.size(), ',', requestReport)) {
+        fail(instance.seed, "导入", "导入失败");
+        return false;
+    }
+    if (labReport.inserted != static_cast<long long>(instance.labs.size()) ||
+        requestReport.inserted != static_cast<long long>(instance.requests.size())) {
+        fail(instance.seed, "导入", "导入行数与实例不符");
+        return false;
+    }
+
+    std::vector<Laboratory> loadedLabs = db.getAllLaboratories();
+    for (size_t i = 0; i < loadedLabs.size(); i++) {
+        if (loadedLabs[i].location != instance.labs[i].location || loadedLabs[i].blackout != instance.labs[i].blackout) {
+            fail(instance.seed, "导入", "读回的实验室与实例不符: " + instance.labs[i].location);
+            return false;
+        }
+    }
+
+    std::vector<LabRequest> loaded = db.getAllRequests();
+    for (size_t i = 0; i < loaded.size(); i++) {
+        const LabRequest& expected = instance.requests[i];
+        if (loaded[i].classId != expected.classId || loaded[i].studentCount != expected.studentCount ||
+            loaded[i].preferredSlots != expected.preferredSlots ||
+            loaded[i].excludedSlots != expected.excludedSlots ||
+            loaded[i].requiredFeatures != expected.requiredFeatures ||
+            loaded[i].course != expected.course || loaded[i].shareable != expected.shareable) {
+            fail(instance.seed, "导入", "读回的申请与实例不符: " + expected.classId);
+            return false;
+        }
+    }
+
+    // 名称驻留: 只读编号的加载与复制名称的加载一致, 编号相同当且仅当名称相同
+    const StringInterner& names = db.names();
+    std::vector<LabRequest> compact = db.getAllRequests(false);
+    std::map<NameId, std::string> nameOf;
+    for (size_t i = 0; i < compact.size(); i++) {
+        const LabRequest& full = loaded[i];
+        const NameId ids[] = {compact[i].className, compact[i].teacherName, compact[i].courseName};
+        const std::string* texts[] = {&full.classId, &full.teacher, &full.course};
+        for (int k = 0; k < 3; k++) {
+            auto known = nameOf.emplace(ids[k], *texts[k]).first;
+            if (ids[k] == kNoName || names.view(ids[k]) != *texts[k] || known->second != *texts[k] ||
+                names.find(*texts[k]) != ids[k]) {
+                fail(instance.seed, "导入", "名称编号与名称不一致: " + full.classId);
+                return false;
+            }
+        }
+        if (!compact[i].classId.empty() || compact[i].className != full.className ||
+            compact[i].preferredSlots != full.preferredSlots || compact[i].requiredFeatures != full.requiredFeatures) {
+            fail(instance.seed, "导入", "只读编号的申请与完整加载不符: " + full.classId);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------- 参考实现 ----------
+
+/**
+ * @brief 参考实现: 直接按算法描述逐条分配, 不使用位图、容量索引或任何缓存
+ * @param blocked 不可使用的 (实验室下标, 时间槽), 实验室的不可用时间段另外跳过
+ *
+ * 按 priority 依次处理每个申请: 先按给出的顺序尝试期望时间段, 再按日历顺序尝试其余时间段,
+ * 跳过排除的时间段; 每个时间段内按实验室列表顺序选第一个容量足够、设备齐全且空闲的实验室。
+ */
+static std::vector<Assignment> referenceSchedule(const Instance& instance,
+                                                 const std::set<std::pair<int, int>>& blocked = {}) {
+    std::set<std::pair<int, int>> used = blocked;
+    std::vector<Assignment> result;
+    for (const auto& request : instance.requests) {
+        std::vector<int> order;
+        for (const auto& slot : request.preferredSlots) {
+            order.push_back(slotIndex(slot));
+        }
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            if (!contains(request.preferredSlots, slotFromIndex(slot))) {
+                order.push_back(slot);
+            }
+        }
+
+        bool placed = false;
+        for (int slot : order) {
+            if (slot < 0 || contains(request.excludedSlots, slotFromIndex(slot))) {
+                continue;
+            }
+            for (size_t labIndex = 0; labIndex < instance.labs.size() && !placed; labIndex++) {
+                const Laboratory& lab = instance.labs[labIndex];
+                if (lab.capacity >= request.studentCount && hasFeatures(lab, request) && !blackedOut(lab, slot) &&
+                    used.insert({static_cast<int>(labIndex), slot}).second) {
+                    result.push_back({request.classId, lab.location, slot});
+                    placed = true;
+                }
+            }
+            if (placed) {
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+// ---------- 不变量 ----------
+
+/**
+ * @brief 检查一份课表的不变量
+ *
+ * - 每个申请至多分配一次, 班级与实验室都存在
+ * - 时间段在日历范围内且不是该申请排除的时间段
+ * - 实验室容量足够且具备所需设备
+ * - 不使用实验室的不可用时间段
+ * - 教室共享关闭时每个 (实验室, 时间段) 至多一个班级, 且不使用 blocked 中的单元;
+ *   开启时同一单元的班级人数之和不超过容量, 且属于同一课程或都允许共用
+ * - 教室共享关闭时(贪心性质)每个未分配的申请在最终占用下没有任何可行的空闲单元
+ */
+static void checkInvariants(const Instance& instance, const std::vector<Assignment>& result,
+                            const std::string& engine, RoomSharing sharing = RoomSharing::Off,
+                            const std::set<std::pair<int, int>>& blocked = {}) {
+    std::map<std::string, const LabRequest*> requestOf;
+    for (const auto& request : instance.requests) {
+        requestOf.emplace(request.classId, &request);
+    }
+    std::map<std::string, int> labOf;
+    for (size_t i = 0; i < instance.labs.size(); i++) {
+        labOf.emplace(instance.labs[i].location, static_cast<int>(i));
+    }
+
+    std::set<std::string> assigned;
+    std::map<std::pair<int, int>, std::vector<const LabRequest*>> cells;
+    for (const auto& assignment : result) {
+        auto request = requestOf.find(assignment.classId);
+        auto lab = labOf.find(assignment.location);
+        if (request == requestOf.end() || lab == labOf.end()) {
+            fail(instance.seed, engine, "课表引用了不存在的班级或实验室: " + assignment.classId);
+            continue;
+        }
+        if (!assigned.insert(assignment.classId).second) {
+            fail(instance.seed, engine, "班级被分配了多次: " + assignment.classId);
+        }
+        if (assignment.slot < 0 || assignment.slot >= kSlotCount) {
+            fail(instance.seed, engine, "时间段不在日历范围内: " + assignment.classId);
+            continue;
+        }
+        const LabRequest& req = *request->second;
+        const Laboratory& labInfo = instance.labs[lab->second];
+        if (contains(req.excludedSlots, slotFromIndex(assignment.slot))) {
+            fail(instance.seed, engine, "使用了排除的时间段: " + assignment.classId);
+        }
+        if (labInfo.capacity < req.studentCount) {
+            fail(instance.seed, engine, "实验室容量不足: " + assignment.classId);
+        }
+        if (!hasFeatures(labInfo, req)) {
+            fail(instance.seed, engine, "实验室缺少所需设备: " + assignment.classId);
+        }
+        if (blocked.count({lab->second, assignment.slot})) {
+            fail(instance.seed, engine, "使用了封闭的实验室时间段: " + assignment.classId);
+        }
+        if (blackedOut(labInfo, assignment.slot)) {
+            fail(instance.seed, engine, "使用了实验室的不可用时间段: " + assignment.classId);
+        }
+        cells[{lab->second, assignment.slot}].push_back(&req);
+    }
+
+    for (const auto& [cell, classes] : cells) {
+        if (classes.size() == 1) {
+            continue;
+        }
+        std::string where = instance.labs[cell.first].location + " 时间槽 " + std::to_string(cell.second);
+        if (sharing == RoomSharing::Off) {
+            fail(instance.seed, engine, "同一实验室时间段安排了多个班级: " + where);
+            continue;
+        }
+        int seats = 0;
+        bool sameCourse = !classes[0]->course.empty();
+        bool allShareable = true;
+        for (const LabRequest* request : classes) {
+            seats += request->studentCount;
+            sameCourse = sameCourse && request->course == classes[0]->course;
+            allShareable = allShareable && request->shareable;
+        }
+        if (seats > instance.labs[cell.first].capacity) {
+            fail(instance.seed, engine, "共用实验室的人数超过容量: " + where);
+        }
+        if (!sameCourse && !allShareable) {
+            fail(instance.seed, engine, "不允许共用的班级共用了实验室: " + where);
+        }
+    }
+
+    if (sharing != RoomSharing::Off) {
+        return;
+    }
+    for (const auto& request : instance.requests) {
+        if (assigned.count(request.classId)) {
+            continue;
+        }
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            if (contains(request.excludedSlots, slotFromIndex(slot))) {
+                continue;
+            }
+            for (size_t labIndex = 0; labIndex < instance.labs.size(); labIndex++) {
+                std::pair<int, int> cell(static_cast<int>(labIndex), slot);
+                if (instance.labs[labIndex].capacity >= request.studentCount &&
+                    hasFeatures(instance.labs[labIndex], request) && !blackedOut(instance.labs[labIndex], slot) &&
+                    !cells.count(cell) && !blocked.count(cell)) {
+                    fail(instance.seed, engine, "未分配的班级仍有可行的空闲单元: " + request.classId);
+                    slot = kSlotCount;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void expectSame(const Instance& instance, const std::vector<Assignment>& expected,
+                       const std::vector<Assignment>& actual, const std::string& engine) {
+    if (expected.size() != actual.size()) {
+        fail(instance.seed, engine, "分配数 " + std::to_string(actual.size()) + ", 应为 " +
+                                    std::to_string(expected.size()));
+        return;
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (!(expected[i] == actual[i])) {
+            fail(instance.seed, engine, "班级 " + expected[i].classId + " 的分配与参考结果不同");
+            return;
+        }
+    }
+}
+
+// ---------- 各求解方式 ----------
+
+static std::vector<Assignment> sorted(std::vector<Assignment> result) {
+    std::sort(result.begin(), result.end(), [](const Assignment& a, const Assignment& b) {
+        return a.classId < b.classId;
+    });
+    return result;
+}
+
+static std::vector<Assignment> fromPlacements(std::span<const Placement> placements,
+                                              const std::vector<Laboratory>& labs,
+                                              const std::vector<LabRequest>& requests) {
+    std::vector<Assignment> result;
+    for (const auto& placement : placements) {
+        result.push_back({requests[placement.requestIndex].classId, labs[placement.labIndex].location,
+                          placement.slot});
+    }
+    return sorted(std::move(result));
+}
+
+static std::vector<Assignment> fromSchedules(const std::vector<Schedule>& schedules,
+                                             const std::vector<Laboratory>& labs,
+                                             const std::vector<LabRequest>& requests) {
+    std::map<int, std::string> locationOf;
+    for (const auto& lab : labs) {
+        locationOf.emplace(lab.id, lab.location);
+    }
+    std::map<int, std::string> classOf;
+    for (const auto& request : requests) {
+        classOf.emplace(request.id, request.classId);
+    }
+    std::vector<Assignment> result;
+    for (const auto& schedule : schedules) {
+        result.push_back({classOf[schedule.requestId], locationOf[schedule.labId], slotIndex(schedule.timeSlot)});
+    }
+    return sorted(std::move(result));
+}
+
+// 分配内核: 各排序策略, 剪枝/分组/推测并行与基本求解结果一致
+static void testSolver(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+    OccupancyGrid grid;
+    grid.reset(labs);
+    SlotPatternTable patterns;
+    patterns.build(requests);
+    RequestGroups groups;
+    groups.build(requests, patterns, grid);
+    std::pmr::vector<int> fairnessGroups;
+    buildFairnessGroups(requests, FairnessGroup::Teacher, fairnessGroups);
+    std::vector<int> all(requests.size());
+    std::iota(all.begin(), all.end(), 0);
+    ThreadPool pool(3);
+
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority, OrderingStrategy::FewestFeasible, OrderingStrategy::LargestClass,
+        OrderingStrategy::PriorityBands, OrderingStrategy::FairShare
+    };
+    for (OrderingStrategy strategy : strategies) {
+        std::string name = std::string("内核 ") + orderingStrategyName(strategy);
+        auto run = [&](bool pruning, bool grouped, bool speculative) {
+            GreedySolver solver(labs, requests, patterns.allowedMasks(), grid);
+            solver.setOrderingStrategy(strategy, 50);
+            solver.setFairnessGroups(fairnessGroups);
+            solver.setPruning(pruning);
+            if (grouped) {
+                solver.setRequestGroups(patterns, groups);
+            }
+            std::pmr::vector<Placement> placements;
+            if (speculative) {
+                solver.solveSpeculative(all, placements, pool);
+            } else {
+                solver.solve(all, placements);
+            }
+            return fromPlacements(placements, labs, requests);
+        };
+
+        std::vector<Assignment> base = run(true, false, false);
+        checkInvariants(instance, base, name);
+        if (strategy == OrderingStrategy::Priority) {
+            expectSame(instance, reference, base, name);
+        }
+        expectSame(instance, base, run(false, false, false), name + " 不剪枝");
+        expectSame(instance, base, run(true, true, false), name + " 申请分组");
+        if (strategy == OrderingStrategy::Priority || strategy == OrderingStrategy::LargestClass) {
+            expectSame(instance, base, run(true, true, true), name + " 推测并行");
+        }
+    }
+
+    // 教室共享时撤销一部分分配: 仍有班级入座的单元保持占用且剩余座位正确, 其余单元恢复原状
+    std::pmr::vector<CourseKey> courseKeys;
+    buildCourseKeys(requests, courseKeys);
+    GreedySolver shared(labs, requests, patterns.allowedMasks(), grid);
+    shared.setRoomSharing(RoomSharing::BestFit, courseKeys);
+    std::pmr::vector<Placement> placements;
+    shared.solve(all, placements);
+    for (size_t kept : {placements.size() / 2, size_t(0)}) {
+        shared.release(placements, kept);
+        placements.resize(kept);
+        std::map<std::pair<int, int>, int> seated;
+        for (const auto& placement : placements) {
+            seated[{placement.labIndex, placement.slot}] += requests[placement.requestIndex].studentCount;
+        }
+        const OccupancyGrid& after = shared.grid();
+        for (int labIndex = 0; labIndex < after.labCount(); labIndex++) {
+            for (int slot = 0; slot < kSlotCount; slot++) {
+                auto cell = seated.find({labIndex, slot});
+                bool restored = cell == seated.end()
+                                    ? after.isFree(labIndex, slot) == grid.isFree(labIndex, slot)
+                                    : !after.isFree(labIndex, slot) &&
+                                          after.freeSeats(labIndex, slot) == after.capacity(labIndex) - cell->second;
+                if (!restored) {
+                    fail(instance.seed, "内核 教室共享 撤销", "保留 " + std::to_string(kept) + " 个分配时单元 (" +
+                                                          labs[labIndex].location + ", " + std::to_string(slot) +
+                                                          ") 的占用不正确");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// 完整的 generateSchedule: 顺序、分区并行与推测并行写入数据库的课表一致, 教室共享满足座位约束
+static void testScheduler(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+
+    const OrderingStrategy strategies[] = {
+        OrderingStrategy::Priority, OrderingStrategy::FewestFeasible, OrderingStrategy::LargestClass
+    };
+    for (OrderingStrategy strategy : strategies) {
+        std::vector<Assignment> sequential;
+        for (int mode = 0; mode < 3; mode++) {
+            Scheduler scheduler(&db);
+            scheduler.setVerbose(false);
+            scheduler.setOrderingStrategy(strategy, 50);
+            scheduler.setParallel(mode > 0, 3, mode == 2 ? ParallelMode::Speculative : ParallelMode::Partitioned);
+            scheduler.generateSchedule();
+            std::vector<Assignment> result = fromSchedules(db.getAllSchedules(), labs, requests);
+
+            std::string name = std::string("generateSchedule ") + orderingStrategyName(strategy);
+            if (mode == 0) {
+                checkInvariants(instance, result, name);
+                if (strategy == OrderingStrategy::Priority) {
+                    expectSame(instance, reference, result, name);
+                }
+                sequential = std::move(result);
+            } else {
+                expectSame(instance, sequential, result, name + (mode == 1 ? " 分区并行" : " 推测并行"));
+            }
+        }
+    }
+
+    for (RoomSharing sharing : {RoomSharing::FirstFit, RoomSharing::BestFit}) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setRoomSharing(sharing);
+        scheduler.generateSchedule();
+        checkInvariants(instance, fromSchedules(db.getAllSchedules(), labs, requests),
+                        std::string("教室共享 ") + roomSharingName(sharing), sharing);
+    }
+
+    // 分阶段计时默认关闭, 分配循环中不读时钟; 开启后课表不变
+    for (bool timing : {false, true}) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        scheduler.setPhaseTiming(timing);
+        scheduler.generateSchedule();
+        const SolverCounters& counters = scheduler.lastRunProfile().solver;
+        expectSame(instance, reference, fromSchedules(db.getAllSchedules(), labs, requests), "分阶段计时");
+        if (!timing && counters.preferredNanos + counters.fallbackNanos != 0) {
+            fail(instance.seed, "分阶段计时", "未开启时仍记录了期望/备选阶段耗时");
+        }
+    }
+}
+
+// 调度内核: 不经过数据库直接构造的问题与参考结果一致, 各种设置下与 generateSchedule 写入数据库的课表一致,
+// 以上一次的结果粘性重新生成时全部保留
+static void testCore(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+
+    // 只填写名称与设备特性字符串, 申请倒序给出, 由 prepareProblem 登记并按 priority 排序
+    SchedulingProblem problem;
+    problem.labs = instance.labs;
+    problem.requests = instance.requests;
+    for (size_t i = 0; i < problem.labs.size(); i++) {
+        problem.labs[i].id = static_cast<int>(i) + 1;
+    }
+    for (size_t i = 0; i < problem.requests.size(); i++) {
+        problem.requests[i].id = static_cast<int>(i) + 1;
+    }
+    std::reverse(problem.requests.begin(), problem.requests.end());
+    StringInterner names;
+    FeatureRegistry features;
+    prepareProblem(problem, names, features);
+
+    CoreScheduler core;
+    SchedulingResult result = core.solve(problem);
+    std::vector<Assignment> base = fromPlacements(result.placements, problem.labs, problem.requests);
+    expectSame(instance, reference, base, "调度内核");
+    if (!std::is_sorted(result.placements.begin(), result.placements.end(),
+                        [](const Placement& a, const Placement& b) { return a.requestIndex < b.requestIndex; }) ||
+        result.regenerate.added != result.placed() || !result.removedIds.empty()) {
+        fail(instance.seed, "调度内核", "结果未按申请顺序排列或变化统计不一致");
+    }
+
+    // 上一次的结果原样作为 previous: 全部保留, 无需删除或重新保存任何安排
+    for (const auto& placement : result.placements) {
+        problem.previous.push_back({static_cast<int>(problem.previous.size()) + 1,
+                                    problem.requests[placement.requestIndex].id,
+                                    problem.labs[placement.labIndex].id, slotFromIndex(placement.slot)});
+    }
+    core.setStickyRegenerate(true);
+    SchedulingResult again = core.solve(problem);
+    expectSame(instance, base, fromPlacements(again.placements, problem.labs, problem.requests), "调度内核 粘性");
+    int keptCount = static_cast<int>(std::count(again.kept.begin(), again.kept.end(), 1));
+    if (again.regenerate.kept != result.placed() || keptCount != result.placed() || !again.removedIds.empty() ||
+        !again.changed.empty()) {
+        fail(instance.seed, "调度内核 粘性", "上一次的安排未全部保留");
+    }
+    problem.previous.clear();
+
+    struct Setting {
+        const char* name;
+        OrderingStrategy ordering;
+        bool parallel;
+        ParallelMode mode;
+        RoomSharing sharing;
+        bool preempt;
+    };
+    const Setting settings[] = {
+        {"最大班级优先 推测并行", OrderingStrategy::LargestClass, true, ParallelMode::Speculative, RoomSharing::Off, false},
+        {"分区并行", OrderingStrategy::Priority, true, ParallelMode::Partitioned, RoomSharing::Off, false},
+        {"公平分配", OrderingStrategy::FairShare, false, ParallelMode::Partitioned, RoomSharing::Off, false},
+        {"教室共享", OrderingStrategy::Priority, false, ParallelMode::Partitioned, RoomSharing::BestFit, false},
+        {"抢占", OrderingStrategy::Priority, false, ParallelMode::Partitioned, RoomSharing::Off, true},
+    };
+    PreemptionOptions preemption;
+    preemption.classWidth = static_cast<int>(instance.requests.size()) / 4 + 1;
+    auto configure = [&](auto& target, const Setting& setting) {
+        target.setOrderingStrategy(setting.ordering);
+        target.setParallel(setting.parallel, 3, setting.mode);
+        target.setRoomSharing(setting.sharing);
+        target.setPreemption(setting.preempt ? preemption : PreemptionOptions());
+    };
+    for (const auto& setting : settings) {
+        Scheduler scheduler(&db);
+        scheduler.setVerbose(false);
+        configure(scheduler, setting);
+        scheduler.generateSchedule();
+        CoreScheduler solver;
+        configure(solver, setting);
+        SchedulingResult solved = solver.solve(problem);
+        expectSame(instance, fromSchedules(db.getAllSchedules(), labs, requests),
+                   fromPlacements(solved.placements, problem.labs, problem.requests),
+                   std::string("调度内核 ") + setting.name);
+    }
+}
+
+// 假设分析场景: 不做修改时与参考结果一致, 封闭实验室后与带封闭单元的参考结果一致
+static void testScenario(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+    Scenario base = Scenario::fromDatabase(db);
+
+    Scenario same = base.fork();
+    same.solve();
+    expectSame(instance, reference, fromSchedules(same.schedules(), labs, requests), "场景");
+
+    std::mt19937 rng(instance.seed + 2);
+    int closedLab = rng() % labs.size();
+    SlotMask closedSlots = weekSlots(kFirstWeek + static_cast<int>(rng() % kWeekCount));
+    std::set<std::pair<int, int>> blocked;
+    for (int slot = 0; slot < kSlotCount; slot++) {
+        if (hasSlot(closedSlots, slot)) {
+            blocked.insert({closedLab, slot});
+        }
+    }
+    Scenario closed = base.fork();
+    closed.closeLab(labs[closedLab].location, closedSlots);
+    closed.solve();
+    std::vector<Assignment> result = fromSchedules(closed.schedules(), labs, requests);
+    checkInvariants(instance, result, "场景 封闭实验室", RoomSharing::Off, blocked);
+    expectSame(instance, sorted(referenceSchedule(instance, blocked)), result, "场景 封闭实验室");
+}
+
+// 批量导出: 每个实验室与每个班级各一个 iCalendar 文件, 两组文件中的事件数都等于课表中的课程数
+static void testExport(const Instance& instance, Database& db) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("lab_schedule_test_export_" + std::to_string(instance.seed));
+    std::filesystem::remove_all(dir);
+    TimetableCache cache(&db);
+    auto snapshot = cache.snapshot();
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    TimetableExportOptions options;
+    options.format = TimetableFormat::ICalendar;
+    options.outputDir = dir.string();
+    options.threadCount = 2;
+    TimetableExportReport report;
+    if (!exportTimetables(*snapshot, labs, options, report)) {
+        fail(instance.seed, "课表导出", "导出失败");
+        return;
+    }
+
+    std::set<std::string_view> classes;
+    for (const auto& entry : snapshot->all()) {
+        classes.insert(entry.classId);
+    }
+    if (report.labFiles != static_cast<int>(labs.size()) || report.classFiles != static_cast<int>(classes.size())) {
+        fail(instance.seed, "课表导出", "文件数与实验室数/班级数不符");
+    }
+    for (const char* sub : {"labs", "classes"}) {
+        size_t files = 0;
+        size_t events = 0;
+        for (const auto& file : std::filesystem::directory_iterator(dir / sub)) {
+            std::ifstream in(file.path(), std::ios::binary);
+            std::string line;
+            while (std::getline(in, line)) {
+                events += line == "BEGIN:VEVENT\r";
+            }
+            files++;
+        }
+        if (events != snapshot->size() || files != static_cast<size_t>(std::string_view(sub) == "labs"
+                                                                            ? report.labFiles : report.classFiles)) {
+            fail(instance.seed, "课表导出", std::string(sub) + " 中的事件数或文件数与课表不符");
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// 课表导出的文件名: 清理后相同(或只有大小写不同)的实验室地址与班级编号各自输出到不同的文件,
+// 索引中的链接互不相同且都指向实际写出的文件
+static void testExportFileNames() {
+    Instance instance;
+    for (const char* location : {"A/1", "A_1", "a_1", "A_1-2"}) {
+        Laboratory lab{};
+        lab.location = location;
+        lab.capacity = 40;
+        instance.labs.push_back(lab);
+    }
+    int priority = 1;
+    for (const char* classId : {"C/1", "C_1", "C:1", "C_1-1"}) {
+        LabRequest request{};
+        request.classId = classId;
+        request.studentCount = 20;
+        request.teacher = classId;
+        request.priority = priority++;
+        request.preferredSlots = {slotFromIndex(0), slotFromIndex(1)};
+        instance.requests.push_back(request);
+    }
+    Database db(":memory:");
+    if (!db.initialize() || !importInstance(instance, db)) {
+        fail(0, "课表导出 文件名", "无法导入数据");
+        return;
+    }
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    if (scheduler.generateSchedule() != static_cast<int>(instance.requests.size())) {
+        fail(0, "课表导出 文件名", "申请未全部分配");
+        return;
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "lab_schedule_test_export_names";
+    std::filesystem::remove_all(dir);
+    TimetableCache cache(&db);
+    auto snapshot = cache.snapshot();
+    TimetableExportOptions options;
+    options.format = TimetableFormat::Html;
+    options.outputDir = dir.string();
+    options.threadCount = 2;
+    TimetableExportReport report;
+    if (!exportTimetables(*snapshot, db.getAllLaboratories(), options, report)) {
+        fail(0, "课表导出 文件名", "导出失败");
+        return;
+    }
+    for (const char* sub : {"labs", "classes"}) {
+        auto files = std::distance(std::filesystem::directory_iterator(dir / sub), std::filesystem::directory_iterator());
+        if (files != 4) {
+            fail(0, "课表导出 文件名", std::string(sub) + " 中有 " + std::to_string(files) + " 个文件, 应为 4 个");
+        }
+    }
+
+    std::ifstream in(dir / "index.html", std::ios::binary);
+    std::string index((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::set<std::string> links;
+    const std::string href = "href=\"";
+    for (size_t at = index.find(href); at != std::string::npos; at = index.find(href, at)) {
+        at += href.size();
+        std::string link = index.substr(at, index.find('"', at) - at);
+        if (!std::filesystem::exists(dir / link)) {
+            fail(0, "课表导出 文件名", "索引链接的文件不存在: " + link);
+        }
+        links.insert(link);
+    }
+    if (links.size() != 8) {
+        fail(0, "课表导出 文件名", "索引中有 " + std::to_string(links.size()) + " 个不同的链接, 应为 8 个");
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// 时间段文本: 序列化后能原样读回, 校验通过的文本读出的时间段数与校验结果一致
+static void testSlotText(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<TimeSlot> slots = randomSlots(rng, rng() % 8);
+    std::string text = Database::serializeTimeSlots(slots);
+    if (Database::deserializeTimeSlots(text) != slots) {
+        fail(seed, "时间段文本", "序列化后读回不一致: " + text);
+    }
+
+    const char alphabet[] = "0123456789,;- x";
+    std::string noise;
+    for (int k = rng() % 24; k > 0; k--) {
+        noise += alphabet[rng() % (sizeof(alphabet) - 1)];
+    }
+    int count = 0;
+    if (validateSlotList(noise, count)) {
+        std::vector<TimeSlot> parsed = Database::deserializeTimeSlots(noise);
+        bool inCalendar = std::all_of(parsed.begin(), parsed.end(),
+                                      [](const TimeSlot& slot) { return slotIndex(slot) >= 0; });
+        if (static_cast<int>(parsed.size()) != count || !inCalendar) {
+            fail(seed, "时间段文本", "校验通过但读出的时间段不符: " + noise);
+        }
+    }
+}
+
+// 随时可停求解: 回调收到的总分严格递增, 最终课表满足全部约束且不差于初始贪心解;
+// 已取消或回调立即要求停止时结果就是按优先级的贪心解
+static void testAnytime(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    scheduler.generateSchedule();
+    double greedyTotal = scheduler.getScheduleStats().objective.total;
+
+    std::vector<double> totals;
+    AnytimeOptions options;
+    options.maxRounds = 12;
+    options.seed = instance.seed;
+    options.onIncumbent = [&](const AnytimeIncumbent& incumbent) {
+        if (totals.empty() != (incumbent.round == 0) || static_cast<int>(incumbent.placements.size()) != incumbent.scores.placed) {
+            fail(instance.seed, "随时可停求解", "回调收到的课表与轮次不一致");
+        }
+        totals.push_back(incumbent.scores.total);
+        return true;
+    };
+    scheduler.setAnytime(options);
+    scheduler.generateSchedule();
+    std::vector<Assignment> result = fromSchedules(db.getAllSchedules(), labs, requests);
+    checkInvariants(instance, result, "随时可停求解");
+    double total = scheduler.getScheduleStats().objective.total;
+    if (totals.empty() || !std::is_sorted(totals.begin(), totals.end(), std::less_equal<double>()) ||
+        std::abs(totals.back() - total) > 1e-6 || total < greedyTotal - 1e-6 ||
+        scheduler.lastAnytimeResult().stop != AnytimeStop::Rounds) {
+        fail(instance.seed, "随时可停求解", "最优课表的总分 " + std::to_string(total) + " 与改进过程不一致");
+    }
+
+    CancellationToken token;
+    token.cancel();
+    options = AnytimeOptions();
+    options.cancel = &token;
+    scheduler.setAnytime(options);
+    scheduler.generateSchedule();
+    expectSame(instance, reference, fromSchedules(db.getAllSchedules(), labs, requests), "随时可停求解 已取消");
+
+    options = AnytimeOptions();
+    options.timeBudget = 60;
+    options.onIncumbent = [](const AnytimeIncumbent&) { return false; };
+    scheduler.setAnytime(options);
+    scheduler.generateSchedule();
+    expectSame(instance, reference, fromSchedules(db.getAllSchedules(), labs, requests), "随时可停求解 回调停止");
+    if (scheduler.lastAnytimeResult().stop != AnytimeStop::Callback || scheduler.lastAnytimeResult().rounds != 0) {
+        fail(instance.seed, "随时可停求解 回调停止", "回调返回 false 后仍继续求解");
+    }
+
+    // 从调用方内存区域分配的字节数不随轮数增长: 每轮的内核在本轮的区域中, 下一轮开始时回收
+    auto callerBytes = [&](int rounds) {
+        CountingResource counting;
+        OccupancyGrid grid(&counting);
+        grid.reset(labs);
+        SlotPatternTable patterns(&counting);
+        patterns.build(requests);
+        std::vector<int> all(requests.size());
+        std::iota(all.begin(), all.end(), 0);
+        std::pmr::vector<Placement> placements(&counting);
+        AnytimeSolver solver(labs, requests, patterns.allowedMasks(), grid, &counting);
+        AnytimeOptions bounded;
+        bounded.maxRounds = rounds;
+        bounded.seed = instance.seed;
+        solver.solve(all, placements, bounded);
+        return counting.bytesAllocated();
+    };
+    size_t fewRounds = callerBytes(20);
+    size_t manyRounds = callerBytes(400);
+    if (manyRounds > 2 * fewRounds) {
+        fail(instance.seed, "随时可停求解 内存", "400 轮分配 " + std::to_string(manyRounds) + " 字节, 20 轮只分配 " +
+                                                   std::to_string(fewRounds) + " 字节");
+    }
+}
+
+// 抢占: 结果满足全部不变量, 未分配的申请在任何可行单元中都找不到类别更低的占用者,
+// 类别最高的申请成功数不少于同一排序策略不抢占时; 粘性模式下加入的紧急申请只调整被取代的班级
+// (会修改数据库, 结束前删除紧急申请)
+static void testPreemption(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    PreemptionOptions options;
+    options.classWidth = static_cast<int>(instance.requests.size()) / 4 + 1;
+    options.maxDepth = 8;  // 不少于类别数, 连锁不会因深度上限中断
+    auto classOf = [&](const LabRequest& request) {
+        return request.priority / options.classWidth;
+    };
+
+    auto topCount = [&](const Instance& data, const std::vector<Assignment>& result) {
+        std::set<std::string> top;
+        for (const auto& request : data.requests) {
+            if (classOf(request) == 0) {
+                top.insert(request.classId);
+            }
+        }
+        return std::count_if(result.begin(), result.end(),
+                             [&](const Assignment& assignment) { return top.count(assignment.classId) > 0; });
+    };
+    auto check = [&](const Instance& data, const std::vector<Assignment>& result, const std::string& engine) {
+        checkInvariants(data, result, engine);
+        std::map<std::string, const LabRequest*> requestOf;
+        for (const auto& request : data.requests) {
+            requestOf.emplace(request.classId, &request);
+        }
+        std::map<std::string, int> labOf;
+        for (size_t i = 0; i < data.labs.size(); i++) {
+            labOf.emplace(data.labs[i].location, static_cast<int>(i));
+        }
+        std::map<std::pair<int, int>, const LabRequest*> owner;
+        for (const auto& assignment : result) {
+            owner[{labOf[assignment.location], assignment.slot}] = requestOf[assignment.classId];
+        }
+        std::set<std::string> assigned;
+        for (const auto& assignment : result) {
+            assigned.insert(assignment.classId);
+        }
+        for (const auto& request : data.requests) {
+            if (assigned.count(request.classId)) {
+                continue;
+            }
+            for (int slot = 0; slot < kSlotCount; slot++) {
+                if (contains(request.excludedSlots, slotFromIndex(slot))) {
+                    continue;
+                }
+                for (size_t labIndex = 0; labIndex < data.labs.size(); labIndex++) {
+                    auto cell = owner.find({static_cast<int>(labIndex), slot});
+                    if (cell != owner.end() && data.labs[labIndex].capacity >= request.studentCount &&
+                        hasFeatures(data.labs[labIndex], request) && classOf(*cell->second) > classOf(request)) {
+                        fail(instance.seed, engine, "未分配的班级 " + request.classId + " 可以取代类别更低的班级 " +
+                                                    cell->second->classId);
+                        return;
+                    }
+                }
+            }
+        }
+    };
+    // 按优先级处理时先处理的申请类别不高于后处理的, 只有同类别的迁移; 按班级大小处理时才有真正的取代
+    std::vector<LabRequest> requests = db.getAllRequests();
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    const PreemptionReport& report = scheduler.lastPreemptionReport();
+    std::vector<Assignment> result;
+    for (OrderingStrategy strategy : {OrderingStrategy::Priority, OrderingStrategy::LargestClass}) {
+        std::string name = std::string("抢占 ") + orderingStrategyName(strategy);
+        scheduler.setOrderingStrategy(strategy);
+        scheduler.setPreemption(PreemptionOptions());
+        int baseline = scheduler.generateSchedule();
+        result = fromSchedules(db.getAllSchedules(), labs, requests);
+        if (strategy == OrderingStrategy::Priority) {
+            expectSame(instance, reference, result, name + " 不抢占");
+        }
+        auto baselineTop = topCount(instance, result);
+        scheduler.setPreemption(options);
+        int placed = scheduler.generateSchedule();
+        result = fromSchedules(db.getAllSchedules(), labs, requests);
+        check(instance, result, name);
+        if (topCount(instance, result) < baselineTop) {
+            fail(instance.seed, name, "类别最高的申请成功数少于不抢占时");
+        }
+        if (report.evictions != report.relocated + report.dropped ||
+            placed != baseline + report.filled + report.preempted - report.dropped) {
+            fail(instance.seed, name, "抢占统计与课表不符");
+        }
+    }
+    scheduler.setOrderingStrategy(OrderingStrategy::Priority);
+
+    // 课表公布后加入紧急申请(priority 最小), 以粘性模式重新生成
+    Scheduler cold(&db);
+    cold.setVerbose(false);
+    cold.generateSchedule();
+    scheduler.setStickyRegenerate(true);
+    scheduler.generateSchedule();
+    Instance changed = instance;
+    std::mt19937 rng(instance.seed + 5);
+    LabRequest urgent = instance.requests[rng() % instance.requests.size()];
+    urgent.classId = "U";
+    urgent.priority = 0;
+    changed.requests.insert(changed.requests.begin(), urgent);
+    if (!db.addRequest(urgent)) {
+        fail(instance.seed, "抢占 紧急申请", "无法加入申请");
+        return;
+    }
+    requests = db.getAllRequests();
+    int before = static_cast<int>(db.getAllSchedules().size());
+    scheduler.generateSchedule();
+    result = fromSchedules(db.getAllSchedules(), labs, requests);
+    check(changed, result, "抢占 紧急申请");
+    const RegenerateReport& regenerate = scheduler.lastRegenerateReport();
+    if (report.preempted > 1 ||
+        regenerate.moved + regenerate.dropped != report.evictions ||
+        regenerate.kept != before - report.evictions) {
+        fail(instance.seed, "抢占 紧急申请", "被调整的班级数 " + std::to_string(regenerate.moved + regenerate.dropped) +
+                                            ", 被取代 " + std::to_string(report.evictions));
+    }
+    for (const auto& request : requests) {
+        if (request.classId == "U") {
+            db.deleteRequest(request.id);
+        }
+    }
+}
+
+// 粘性重新生成: 数据不变时课表与行都不变; 实验室新增不可用时间段或被删除后只有受影响的班级被调整,
+// 其余班级的安排保持不变, 且结果满足全部约束(最后运行, 会修改数据库)
+static void testSticky(const Instance& instance, Database& db, const std::vector<Assignment>& reference) {
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    std::vector<LabRequest> requests = db.getAllRequests();
+    Scheduler cold(&db);
+    cold.setVerbose(false);
+    cold.generateSchedule();
+
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    scheduler.setStickyRegenerate(true);
+    scheduler.generateSchedule();
+    const RegenerateReport& unchanged = scheduler.lastRegenerateReport();
+    expectSame(instance, reference, fromSchedules(db.getAllSchedules(), labs, requests), "粘性重新生成");
+    if (unchanged.kept != static_cast<int>(reference.size()) || unchanged.moved + unchanged.dropped + unchanged.added != 0 ||
+        scheduler.lastRunProfile().database.rowsWritten != 0) {
+        fail(instance.seed, "粘性重新生成", "数据不变时课表发生了变化");
+    }
+    if (labs.size() < 2) {
+        return;
+    }
+
+    // 数据修改后粘性重新生成: 恰好调整 isAffected 的班级, 其余班级保持原安排
+    Instance changed = instance;
+    std::vector<Assignment> current = reference;
+    auto regenerate = [&](const std::string& name, const std::function<bool(const Assignment&)>& isAffected) {
+        int affected = 0;
+        std::vector<Assignment> untouched;
+        for (const auto& assignment : current) {
+            if (isAffected(assignment)) {
+                affected++;
+            } else {
+                untouched.push_back(assignment);
+            }
+        }
+        scheduler.generateSchedule();
+        const RegenerateReport& report = scheduler.lastRegenerateReport();
+        std::vector<Assignment> result = fromSchedules(db.getAllSchedules(), labs, requests);
+        checkInvariants(changed, result, name);
+        if (report.moved + report.dropped != affected || report.kept != static_cast<int>(untouched.size())) {
+            fail(instance.seed, name, "调整的班级数 " + std::to_string(report.moved + report.dropped) +
+                                      ", 应为 " + std::to_string(affected));
+        }
+        std::set<std::string> kept;
+        for (const auto& assignment : result) {
+            kept.insert(assignment.classId + "@" + assignment.location + "#" + std::to_string(assignment.slot));
+        }
+        for (const auto& assignment : untouched) {
+            if (!kept.count(assignment.classId + "@" + assignment.location + "#" + std::to_string(assignment.slot))) {
+                fail(instance.seed, name, "未受影响的班级被调整: " + assignment.classId);
+                break;
+            }
+        }
+        current = result;
+    };
+
+    std::mt19937 rng(instance.seed + 3);
+    int closed = rng() % labs.size();
+    SlotMask added = weekSlots(kFirstWeek + static_cast<int>(rng() % kWeekCount)) & ~changed.labs[closed].blackout;
+    changed.labs[closed].blackout |= added;
+    if (!db.setLabBlackout(labs[closed].id, changed.labs[closed].blackout)) {
+        fail(instance.seed, "粘性重新生成 不可用时间段", "无法修改实验室的不可用时间段");
+    }
+    regenerate("粘性重新生成 不可用时间段", [&](const Assignment& assignment) {
+        return assignment.location == labs[closed].location && hasSlot(added, assignment.slot);
+    });
+
+    int removed = rng() % labs.size();
+    db.deleteLaboratory(labs[removed].id);
+    changed.labs.erase(changed.labs.begin() + removed);
+    regenerate("粘性重新生成 删除实验室", [&](const Assignment& assignment) {
+        return assignment.location == labs[removed].location;
+    });
+}
+
+// 多校区求解: 实例按下标拆成两个校区, 教师在两个校区都有申请。
+// 结束时没有跨校区的教师冲突; 把最终的教师忙碌时间并入排除时间段后, 各校区的课表满足全部不变量;
+// 按教师的全局查询与逐个分片查询的结果一致
+static void testSharded(const Instance& instance) {
+    const int kShards = 2;
+    if (instance.labs.size() < kShards) {
+        return;
+    }
+    ShardedDatabase shards;
+    std::vector<Instance> parts(kShards);
+    for (int s = 0; s < kShards; s++) {
+        parts[s].seed = instance.seed;
+        for (size_t i = s; i < instance.labs.size(); i += kShards) {
+            parts[s].labs.push_back(instance.labs[i]);
+        }
+        for (size_t i = s; i < instance.requests.size(); i += kShards) {
+            parts[s].requests.push_back(instance.requests[i]);
+        }
+        if (!shards.attach("校区" + std::to_string(s), ":memory:") || !importInstance(parts[s], shards.shard(s))) {
+            fail(instance.seed, "多校区", "无法建立分片");
+            return;
+        }
+    }
+    if (shards.route("校区1") != &shards.shard(1) || shards.route("校区9") != nullptr) {
+        fail(instance.seed, "多校区", "分片路由错误");
+    }
+
+    ShardedScheduler scheduler(&shards);
+    scheduler.setThreadCount(kShards);
+    int placed = scheduler.generateSchedule();
+    const ShardedScheduleReport& report = scheduler.lastReport();
+
+    std::map<std::pair<std::string, int>, int> teacherSlot;  // (教师, 时间槽) -> 分片
+    int total = 0;
+    for (int s = 0; s < kShards; s++) {
+        Database& db = shards.shard(s);
+        std::vector<Laboratory> labs = db.getAllLaboratories();
+        std::vector<LabRequest> requests = db.getAllRequests();
+        std::vector<Schedule> schedules = db.getAllSchedules();
+        std::map<int, std::string> teacherOf;
+        for (const auto& request : requests) {
+            teacherOf.emplace(request.id, request.teacher);
+        }
+        for (const auto& schedule : schedules) {
+            auto cell = teacherSlot.emplace(std::make_pair(teacherOf[schedule.requestId], slotIndex(schedule.timeSlot)), s);
+            if (cell.first->second != s) {
+                fail(instance.seed, "多校区", "教师 " + teacherOf[schedule.requestId] + " 同一时间段在两个校区都有课");
+            }
+        }
+        total += static_cast<int>(schedules.size());
+
+        Instance constrained = parts[s];
+        for (auto& request : constrained.requests) {
+            auto busy = report.teacherBusy[s].find(request.teacher);
+            for (int slot = 0; busy != report.teacherBusy[s].end() && slot < kSlotCount; slot++) {
+                if (hasSlot(busy->second, slot) && !contains(request.excludedSlots, slotFromIndex(slot))) {
+                    request.excludedSlots.push_back(slotFromIndex(slot));
+                }
+            }
+        }
+        checkInvariants(constrained, fromSchedules(schedules, labs, requests), "多校区 " + shards.key(s));
+    }
+    if (placed != total) {
+        fail(instance.seed, "多校区", "成功数 " + std::to_string(placed) + ", 课程安排 " + std::to_string(total));
+    }
+
+    std::vector<ShardSchedule> global = shards.getSchedulesByTeacher("T0");
+    size_t expected = 0;
+    for (int s = 0; s < kShards; s++) {
+        expected += shards.shard(s).getSchedulesByTeacher("T0").size();
+    }
+    bool ordered = std::is_sorted(global.begin(), global.end(), [](const ShardSchedule& a, const ShardSchedule& b) {
+        return slotIndex(a.schedule.timeSlot) < slotIndex(b.schedule.timeSlot);
+    });
+    if (global.size() != expected || !ordered) {
+        fail(instance.seed, "多校区", "按教师的全局查询结果与各分片不符");
+    }
+}
+
+// 连接池: 写连接反复整批替换课表时, 读连接只能看到完整的批次(0 行或整批), 不能看到事务中途的状态
+static void checkConnectionPool(const Instance& instance, const std::string& path) {
+    // 内存数据库会退回单连接, 必须使用文件数据库才能真正并发读写
+    Database db(path, 4);
+    if (!db.initialize() || db.readerCount() != 4 || !importInstance(instance, db)) {
+        fail(instance.seed, "连接池", "无法以连接池模式打开文件数据库");
+        return;
+    }
+    Scheduler scheduler(&db);
+    scheduler.setVerbose(false);
+    scheduler.generateSchedule();
+    std::vector<Schedule> batch = db.getAllSchedules();
+    if (batch.empty()) {
+        return;
+    }
+    int labId = batch.front().labId;
+    size_t labRows = std::count_if(batch.begin(), batch.end(), [&](const Schedule& s) {
+        return s.labId == labId;
+    });
+
+    std::atomic<bool> writing{true};
+    std::atomic<int> reads{0};
+    std::atomic<int> partial{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; r++) {
+        readers.emplace_back([&, r]() {
+            while (writing.load(std::memory_order_acquire)) {
+                size_t rows = r % 2 == 0 ? db.getAllSchedules().size()
+                                         : db.getSchedulesByLab(labId).size();
+                size_t full = r % 2 == 0 ? batch.size() : labRows;
+                if (rows != 0 && rows != full) {
+                    partial.fetch_add(1, std::memory_order_relaxed);
+                }
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // 交替两种整批写入: 清空后 addSchedules, 以及 updateSchedules 在一个事务中删除全部旧行并写回
+    bool ok = true;
+    for (int round = 0; round < 20 && ok; round++) {
+        std::vector<int> removedIds;
+        for (const Schedule& s : db.getAllSchedules()) {
+            removedIds.push_back(s.id);
+        }
+        if (round % 2 == 0) {
+            ok = db.clearSchedules() && db.addSchedules(batch);
+        } else {
+            ok = db.updateSchedules(removedIds, batch);
+        }
+    }
+    // 保证读线程至少完成了一些查询
+    while (ok && reads.load(std::memory_order_relaxed) < 8) {
+        std::this_thread::yield();
+    }
+    writing.store(false, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    if (!ok) {
+        fail(instance.seed, "连接池", "批量写入失败");
+    } else if (partial.load() != 0) {
+        fail(instance.seed, "连接池", "读连接看到了未完成的批量写入 (" + std::to_string(partial.load()) + " 次)");
+    } else if (db.getAllSchedules().size() != batch.size()) {
+        fail(instance.seed, "连接池", "写入结束后课表行数不符");
+    }
+}
+
+static void testConnectionPool(const Instance& instance) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "lab_schedule_test_pool.db";
+    auto removeFiles = [&]() {
+        for (const char* suffix : {"", "-wal", "-shm"}) {
+            std::filesystem::remove(path.string() + suffix);
+        }
+    };
+    removeFiles();
+    checkConnectionPool(instance, path.string());
+    removeFiles();
+}
+
+int main(int argc, char* argv[]) {
+    int caseCount = argc > 1 ? std::atoi(argv[1]) : 60;
+    unsigned firstSeed = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 1;
+
+    testExportFileNames();
+
+    for (unsigned seed = firstSeed; seed < firstSeed + caseCount; seed++) {
+        Instance instance = randomInstance(seed);
+        Database db(":memory:");
+        if (!db.initialize()) {
+            std::cerr << "数据库初始化失败!" << std::endl;
+            return 1;
+        }
+        testSlotText(seed);
+        if (!importInstance(instance, db)) {
+            continue;
+        }
+        std::vector<Assignment> reference = sorted(referenceSchedule(instance));
+        checkInvariants(instance, reference, "参考实现");
+        testSolver(instance, db, reference);
+        testScheduler(instance, db, reference);
+        testCore(instance, db, reference);
+        testScenario(instance, db, reference);
+        if (seed % 10 == 0) {
+            testExport(instance, db);
+            testConnectionPool(instance);
+        }
+        testAnytime(instance, db, reference);
+        testPreemption(instance, db, reference);
+        testSticky(instance, db, reference);
+        testSharded(instance);
+    }
+
+    if (failures > 0) {
+        std::cerr << caseCount << " 个实例中发现 " << failures << " 处错误" << std::endl;
+        return 1;
+    }
+    std::cout << caseCount << " 个随机实例全部通过" << std::endl;
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        target = nextQueue++ % queues.size();
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queued++;
+    }
+    wakeCondition.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    doneCondition.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::tryPop(int worker, Task& task) {
+    int count = static_cast<int>(queues.size());
+    for (int i = 0; i < count; i++) {
+        int victim = (worker + i) % count;
+        WorkerQueue& queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // 自己的队列从尾部取(局部性更好), 窃取时从头部取
+        if (victim == worker) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int worker) {
+    while (true) {
+        Task task;
+        if (tryPop(worker, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queued--;
+            }
+            task(worker);
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pending == 0) {
+                doneCondition.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        wakeCondition.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
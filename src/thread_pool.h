@@ -0,0 +1,65 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 工作窃取线程池
+ *
+ * 每个工作线程拥有自己的任务队列: 优先从自己队列尾部取任务,
+ * 自己的队列为空时从其他线程队列头部窃取, 使大小不均的任务也能均衡负载。
+ * 任务接收执行它的工作线程编号, 便于使用按线程划分的私有数据。
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void(int worker)>;
+
+    /**
+     * @param threadCount 工作线程数, <= 0 时使用硬件并发数
+     */
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(threads.size()); }
+
+    /**
+     * @brief 提交任务(按轮转方式放入各线程队列)
+     */
+    void submit(Task task);
+
+    /**
+     * @brief 阻塞直到所有已提交的任务执行完毕
+     */
+    void wait();
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    int queued = 0;    // 已入队但尚未被取走的任务数
+    int pending = 0;   // 尚未执行完毕的任务数
+    bool stopping = false;
+    size_t nextQueue = 0;
+
+    void workerLoop(int worker);
+    bool tryPop(int worker, Task& task);
+};
+
+#endif // THREAD_POOL_H
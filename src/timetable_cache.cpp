@@ -0,0 +1,159 @@
+#include "timetable_cache.h"
+#include <algorithm>
+#include <iostream>
+
+static const char* const kDayTexts[] = {"周一", "周二", "周三", "周四", "周五", "周六", "周日"};
+static const char* const kPeriodTexts[] = {"上午(2-5节)", "下午(6-9节)"};
+
+std::string_view timetableDayText(int day) {
+    return day >= 0 && day < 7 ? kDayTexts[day] : "";
+}
+
+std::string_view timetablePeriodText(int period) {
+    return period >= 0 && period < 2 ? kPeriodTexts[period] : "";
+}
+
+std::span<const TimetableEntry> TimetableSnapshot::byLab(int labId) const {
+    auto it = labIndex.find(labId);
+    if (it == labIndex.end()) {
+        return {};
+    }
+    return std::span<const TimetableEntry>(labOrder).subspan(it->second.begin, it->second.count);
+}
+
+std::span<const TimetableEntry> TimetableSnapshot::byClass(std::string_view classId) const {
+    auto it = classIndex.find(classId);
+    if (it == classIndex.end()) {
+        return {};
+    }
+    return std::span<const TimetableEntry>(classOrder).subspan(it->second.begin, it->second.count);
+}
+
+std::string_view TimetableSnapshot::intern(std::unordered_map<std::string_view, std::string_view>& seen,
+                                           std::string_view text) {
+    auto it = seen.find(text);
+    if (it != seen.end()) {
+        return it->second;
+    }
+    std::string_view stored = strings.emplace_back(text);
+    seen.emplace(stored, stored);
+    return stored;
+}
+
+TimetableCache::TimetableCache(Database* db) : database(db) {
+}
+
+std::shared_ptr<const TimetableSnapshot> TimetableCache::load() const {
+    std::lock_guard<std::mutex> lock(currentMutex);
+    return current;
+}
+
+std::shared_ptr<const TimetableSnapshot> TimetableCache::snapshot() {
+    uint64_t version = database->scheduleVersion();
+    std::shared_ptr<const TimetableSnapshot> cached = load();
+    if (cached && cached->version() == version) {
+        return cached;
+    }
+
+    std::lock_guard<std::mutex> rebuildLock(rebuildMutex);
+    // 等待期间其他线程可能已经建好了同一版本
+    version = database->scheduleVersion();
+    cached = load();
+    if (cached && cached->version() == version) {
+        return cached;
+    }
+
+    std::shared_ptr<const TimetableSnapshot> fresh = build(version);
+    {
+        std::lock_guard<std::mutex> lock(currentMutex);
+        current = fresh;
+    }
+    rebuilds.fetch_add(1, std::memory_order_relaxed);
+    return fresh;
+}
+
+void TimetableCache::invalidate() {
+    std::lock_guard<std::mutex> lock(currentMutex);
+    current.reset();
+}
+
+std::shared_ptr<const TimetableSnapshot> TimetableCache::build(uint64_t version) {
+    // 版本号在读取数据之前取得: 若读取期间课表被改写, 快照带着旧版本号, 下次查询会再次重建
+    auto snapshot = std::make_shared<TimetableSnapshot>();
+    snapshot->scheduleVersion = version;
+
+    std::vector<Laboratory> labs = database->getAllLaboratories();
+    std::vector<LabRequest> requests = database->getAllRequests();
+    std::vector<Schedule> schedules = database->getAllSchedules();
+
+    std::unordered_map<int, const Laboratory*> labOf;
+    for (const auto& lab : labs) {
+        labOf.emplace(lab.id, &lab);
+    }
+    std::unordered_map<int, const LabRequest*> requestOf;
+    for (const auto& request : requests) {
+        requestOf.emplace(request.id, &request);
+    }
+
+    std::unordered_map<std::string_view, std::string_view> seen;
+    std::unordered_map<int, std::string_view> weekTexts;
+    std::vector<TimetableEntry>& entries = snapshot->labOrder;
+    entries.reserve(schedules.size());
+    for (const auto& schedule : schedules) {
+        auto lab = labOf.find(schedule.labId);
+        auto request = requestOf.find(schedule.requestId);
+        if (lab == labOf.end() || request == requestOf.end()) {
+            std::cerr << "课表缓存: 忽略引用不存在的实验室或申请的课程安排 " << schedule.id << std::endl;
+            continue;
+        }
+
+        auto week = weekTexts.find(schedule.timeSlot.week);
+        if (week == weekTexts.end()) {
+            std::string text = "第" + std::to_string(schedule.timeSlot.week) + "周";
+            week = weekTexts.emplace(schedule.timeSlot.week, snapshot->intern(seen, text)).first;
+        }
+
+        TimetableEntry entry;
+        entry.requestId = schedule.requestId;
+        entry.labId = schedule.labId;
+        entry.timeSlot = schedule.timeSlot;
+        entry.classId = snapshot->intern(seen, request->second->classId);
+        entry.teacher = snapshot->intern(seen, request->second->teacher);
+        entry.location = snapshot->intern(seen, lab->second->location);
+        entry.weekText = week->second;
+        entry.dayText = timetableDayText(schedule.timeSlot.day);
+        entry.periodText = timetablePeriodText(schedule.timeSlot.period);
+        entries.push_back(entry);
+    }
+
+    snapshot->classOrder = entries;
+    std::sort(snapshot->labOrder.begin(), snapshot->labOrder.end(),
+              [](const TimetableEntry& a, const TimetableEntry& b) {
+                  if (a.labId != b.labId) return a.labId < b.labId;
+                  if (!(a.timeSlot == b.timeSlot)) return a.timeSlot < b.timeSlot;
+                  return a.classId < b.classId;
+              });
+    std::sort(snapshot->classOrder.begin(), snapshot->classOrder.end(),
+              [](const TimetableEntry& a, const TimetableEntry& b) {
+                  if (a.classId != b.classId) return a.classId < b.classId;
+                  if (!(a.timeSlot == b.timeSlot)) return a.timeSlot < b.timeSlot;
+                  return a.location < b.location;
+              });
+
+    // 排序后相同键的课程相邻, 一次扫描得到各区间
+    auto buildIndex = [](const std::vector<TimetableEntry>& ordered, auto& index, auto key) {
+        uint32_t begin = 0;
+        while (begin < ordered.size()) {
+            uint32_t end = begin + 1;
+            while (end < ordered.size() && key(ordered[end]) == key(ordered[begin])) {
+                end++;
+            }
+            index.emplace(key(ordered[begin]), TimetableSnapshot::Range{begin, end - begin});
+            begin = end;
+        }
+    };
+    buildIndex(snapshot->labOrder, snapshot->labIndex, [](const TimetableEntry& entry) { return entry.labId; });
+    buildIndex(snapshot->classOrder, snapshot->classIndex,
+               [](const TimetableEntry& entry) { return entry.classId; });
+    return snapshot;
+}
@@ -0,0 +1,123 @@
+#ifndef TIMETABLE_CACHE_H
+#define TIMETABLE_CACHE_H
+
+#include "database.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 只读课表中的一节课, 文本字段引用所属快照的字符串表, 随快照一起失效
+struct TimetableEntry {
+    int requestId;
+    int labId;
+    TimeSlot timeSlot;
+    std::string_view classId;
+    std::string_view teacher;
+    std::string_view location;
+    std::string_view weekText;    // 如 "第9周"
+    std::string_view dayText;     // 如 "周一"
+    std::string_view periodText;  // 如 "上午(2-5节)"
+};
+
+// 星期(0 为周一)与时段的显示文本, 超出范围时为空
+std::string_view timetableDayText(int day);
+std::string_view timetablePeriodText(int period);
+
+/**
+ * @brief 某一课表版本的只读视图
+ *
+ * 同一批课程按两种顺序各保存一份连续数组:
+ *   - 按实验室: (实验室, 时间段, 班级)
+ *   - 按班级:   (班级, 时间段, 实验室)
+ * 哈希索引把实验室 id / 班级 id 映射到数组中的区间, 查询返回 span, 不访问数据库也不分配内存。
+ * 快照建好后不再修改, 多个线程可以同时读取。
+ */
+class TimetableSnapshot {
+public:
+    /**
+     * @brief 建立快照时的课表版本(见 Database::scheduleVersion)
+     */
+    uint64_t version() const { return scheduleVersion; }
+
+    std::span<const TimetableEntry> byLab(int labId) const;
+    std::span<const TimetableEntry> byClass(std::string_view classId) const;
+
+    // 全部课程(按实验室顺序)
+    std::span<const TimetableEntry> all() const { return labOrder; }
+    // 全部课程(按班级顺序), 同一班级的课程相邻
+    std::span<const TimetableEntry> allByClass() const { return classOrder; }
+    size_t size() const { return labOrder.size(); }
+
+private:
+    friend class TimetableCache;
+
+    struct Range {
+        uint32_t begin;
+        uint32_t count;
+    };
+
+    uint64_t scheduleVersion = 0;
+    std::deque<std::string> strings;  // 去重后的文本, deque 追加时不移动已有元素
+    std::vector<TimetableEntry> labOrder;
+    std::vector<TimetableEntry> classOrder;
+    std::unordered_map<int, Range> labIndex;
+    std::unordered_map<std::string_view, Range> classIndex;
+
+    std::string_view intern(std::unordered_map<std::string_view, std::string_view>& seen,
+                            std::string_view text);
+};
+
+/**
+ * @brief 课表查询缓存: 每个课表版本只从数据库读取一次
+ *
+ * 数据库在课表被改写(clearSchedules、写入课程安排、删除实验室/申请)时递增版本号,
+ * snapshot() 发现版本号变化后重新建立快照并原子地替换旧快照。
+ * 调用方持有的 shared_ptr 使旧快照在读取期间保持有效, 因此读者之间、读者与重建之间都不需要加锁。
+ *
+ * 重建会访问数据库, 同一时刻只有一个线程重建, 其他线程等待并共享其结果。
+ *
+ * 用法:
+ *   TimetableCache cache(&db);
+ *   auto timetable = cache.snapshot();
+ *   for (const TimetableEntry& entry : timetable->byLab(labId)) { ... }
+ */
+class TimetableCache {
+public:
+    explicit TimetableCache(Database* db);
+
+    TimetableCache(const TimetableCache&) = delete;
+    TimetableCache& operator=(const TimetableCache&) = delete;
+
+    /**
+     * @brief 当前课表版本的快照(版本变化时先重建)
+     */
+    std::shared_ptr<const TimetableSnapshot> snapshot();
+
+    /**
+     * @brief 丢弃当前快照, 下次查询时重建
+     */
+    void invalidate();
+
+    // 已建立快照的次数
+    int rebuildCount() const { return rebuilds.load(std::memory_order_relaxed); }
+
+private:
+    Database* database;
+
+    mutable std::mutex currentMutex;  // 只保护 current 指针的读写
+    std::shared_ptr<const TimetableSnapshot> current;
+    std::mutex rebuildMutex;          // 保证同一时刻只有一个线程重建
+    std::atomic<int> rebuilds{0};
+
+    std::shared_ptr<const TimetableSnapshot> load() const;
+    std::shared_ptr<const TimetableSnapshot> build(uint64_t version);
+};
+
+#endif // TIMETABLE_CACHE_H
@@ -0,0 +1,562 @@
+#include "timetable_export.h"
+#include "occupancy.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// 输出缓冲区积满该大小时写入文件
+static const size_t kFlushBytes = 64 * 1024;
+// 每个线程池任务渲染的课表数
+static const size_t kTimetablesPerTask = 32;
+// iCalendar 内容行的最大字节数(不含换行)
+static const size_t kICalLineBytes = 75;
+
+const char* timetableFormatName(TimetableFormat format) {
+    switch (format) {
+    case TimetableFormat::Html:      return "html";
+    case TimetableFormat::Markdown:  return "markdown";
+    case TimetableFormat::ICalendar: return "ical";
+    }
+    return "unknown";
+}
+
+bool parseTimetableFormat(std::string_view name, TimetableFormat& format) {
+    if (name == "html" || name == "htm") {
+        format = TimetableFormat::Html;
+    } else if (name == "markdown" || name == "md") {
+        format = TimetableFormat::Markdown;
+    } else if (name == "ical" || name == "ics" || name == "icalendar") {
+        format = TimetableFormat::ICalendar;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static const char* extensionOf(TimetableFormat format) {
+    switch (format) {
+    case TimetableFormat::Html:      return ".html";
+    case TimetableFormat::Markdown:  return ".md";
+    case TimetableFormat::ICalendar: return ".ics";
+    }
+    return "";
+}
+
+/**
+ * @brief 带缓冲的文件输出
+ *
+ * 内容先追加到调用方提供的缓冲区(每个工作线程一个, 在各文件之间复用容量),
+ * 积满 kFlushBytes 或关闭时一次写入文件。
+ */
+class BufferedFile {
+public:
+    BufferedFile(const std::string& path, std::string& buffer)
+        : file(std::fopen(path.c_str(), "wb")), buffer(buffer) {
+        buffer.clear();
+    }
+
+    ~BufferedFile() { close(); }
+
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    BufferedFile& operator<<(std::string_view text) {
+        buffer.append(text);
+        if (buffer.size() >= kFlushBytes) {
+            flush();
+        }
+        return *this;
+    }
+
+    BufferedFile& operator<<(long long value) { return *this << std::string_view(std::to_string(value)); }
+
+    /**
+     * @brief 写出剩余内容并关闭文件
+     * @return 所有写入是否成功
+     */
+    bool close() {
+        if (!file) {
+            return false;
+        }
+        flush();
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    long long bytesWritten() const { return written; }
+
+private:
+    std::FILE* file;
+    std::string& buffer;
+    long long written = 0;
+    bool ok = true;
+
+    void flush() {
+        if (!buffer.empty()) {
+            ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && ok;
+            written += static_cast<long long>(buffer.size());
+            buffer.clear();
+        }
+    }
+};
+
+// 一张待输出的课表: 快照中按实验室或按班级排好的一段课程
+struct TimetableJob {
+    bool byLab;
+    std::string title;     // 实验室地址或班级编号
+    std::string fileName;  // 相对输出目录的路径
+    std::span<const TimetableEntry> entries;
+};
+
+/**
+ * @brief 文件名: 去掉路径分隔符、控制字符及在文件名或链接中有特殊含义的字符
+ */
+static std::string safeFileName(std::string_view text) {
+    std::string name;
+    for (char c : text) {
+        bool special = static_cast<unsigned char>(c) < 0x20 || std::string_view("/\\:*?\"<>|#%").find(c) != std::string_view::npos;
+        name += special ? '_' : c;
+    }
+    if (name.empty() || name == "." || name == "..") {
+        name = "_" + name;
+    }
+    return name;
+}
+
+/**
+ * @brief 同一目录中各课表的文件名, 保证互不相同
+ *
+ * 清理后相同的名称(如 "A/1" 与 "A_1")附加 "-" 与区分号: tags 非空时用对应的值(实验室 id),
+ * 否则用同名中的序号。比较时不区分 ASCII 大小写, 在不区分大小写的文件系统上也不会覆盖;
+ * 附加后仍与其他名称相同时(如 "A_1-2")继续附加序号。
+ */
+static std::vector<std::string> distinctFileNames(std::span<const std::string_view> titles, std::span<const int> tags) {
+    auto folded = [](std::string name) {
+        for (char& c : name) {
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+        return name;
+    };
+    std::vector<std::string> names;
+    names.reserve(titles.size());
+    std::unordered_map<std::string, int> sameName;
+    for (std::string_view title : titles) {
+        names.push_back(safeFileName(title));
+        sameName[folded(names.back())]++;
+    }
+    std::unordered_map<std::string, int> serial;
+    std::unordered_set<std::string> used;
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string key = folded(names[i]);
+        if (sameName[key] > 1) {
+            names[i] += "-" + std::to_string(tags.empty() ? ++serial[key] : tags[i]);
+        }
+        std::string name = names[i];
+        for (int extra = 2; !used.insert(folded(name)).second; extra++) {
+            name = names[i] + "-" + std::to_string(extra);
+        }
+        names[i] = std::move(name);
+    }
+    return names;
+}
+
+// 每个时间槽在课程数组中的区间; 课程已按时间段排序, 同一时间槽的课程相邻
+using SlotRanges = std::array<std::span<const TimetableEntry>, kSlotCount>;
+
+static SlotRanges slotRanges(std::span<const TimetableEntry> entries) {
+    SlotRanges ranges{};
+    size_t begin = 0;
+    while (begin < entries.size()) {
+        size_t end = begin + 1;
+        while (end < entries.size() && entries[end].timeSlot == entries[begin].timeSlot) {
+            end++;
+        }
+        int slot = slotIndex(entries[begin].timeSlot);
+        if (slot >= 0) {
+            ranges[slot] = entries.subspan(begin, end - begin);
+        }
+        begin = end;
+    }
+    return ranges;
+}
+
+static std::string weekText(int week) {
+    return "第" + std::to_string(week) + "周";
+}
+
+// ---------- HTML ----------
+
+static void writeHtmlText(BufferedFile& out, std::string_view text) {
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        const char* entity = nullptr;
+        switch (text[i]) {
+        case '&': entity = "&amp;"; break;
+        case '<': entity = "&lt;"; break;
+        case '>': entity = "&gt;"; break;
+        case '"': entity = "&quot;"; break;
+        }
+        if (entity) {
+            out << text.substr(start, i - start) << entity;
+            start = i + 1;
+        }
+    }
+    out << text.substr(start);
+}
+
+static void writeHtmlHead(BufferedFile& out, std::string_view title) {
+    out << "<!DOCTYPE html>\n<html lang=\"zh-CN\">\n<head>\n<meta charset=\"utf-8\">\n<title>";
+    writeHtmlText(out, title);
+    out << "</title>\n<style>\n"
+           "body { font-family: sans-serif; }\n"
+           "table { border-collapse: collapse; width: 100%; }\n"
+           "th, td { border: 1px solid #444; padding: 4px 6px; vertical-align: top; }\n"
+           "td div + div { border-top: 1px dashed #999; margin-top: 2px; padding-top: 2px; }\n"
+           "@media print { @page { size: A4 landscape; } }\n"
+           "</style>\n</head>\n<body>\n";
+}
+
+static void writeHtml(BufferedFile& out, const TimetableJob& job) {
+    std::string title = (job.byLab ? "实验室 " : "班级 ") + job.title + " 课表";
+    writeHtmlHead(out, title);
+    out << "<h1>";
+    writeHtmlText(out, title);
+    out << "</h1>\n<table>\n<thead><tr><th></th>";
+    for (int day = 0; day < kDaysPerWeek; day++) {
+        out << "<th>" << timetableDayText(day) << "</th>";
+    }
+    out << "</tr></thead>\n<tbody>\n";
+
+    SlotRanges ranges = slotRanges(job.entries);
+    for (int week = kFirstWeek; week < kFirstWeek + kWeekCount; week++) {
+        for (int period = 0; period < kPeriodsPerDay; period++) {
+            out << "<tr><th>" << weekText(week) << "<br>" << timetablePeriodText(period) << "</th>";
+            for (int day = 0; day < kDaysPerWeek; day++) {
+                out << "<td>";
+                for (const TimetableEntry& entry : ranges[slotIndex(TimeSlot{week, day, period})]) {
+                    out << "<div>";
+                    writeHtmlText(out, job.byLab ? entry.classId : entry.location);
+                    out << "<br>";
+                    writeHtmlText(out, entry.teacher);
+                    out << "</div>";
+                }
+                out << "</td>";
+            }
+            out << "</tr>\n";
+        }
+    }
+    out << "</tbody>\n</table>\n<p>共 " << static_cast<long long>(job.entries.size())
+        << " 节课</p>\n</body>\n</html>\n";
+}
+
+// ---------- Markdown ----------
+
+static void writeMarkdownText(BufferedFile& out, std::string_view text) {
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        const char* replacement = nullptr;
+        switch (text[i]) {
+        case '|': replacement = "\\|"; break;
+        case '<': replacement = "&lt;"; break;
+        case '>': replacement = "&gt;"; break;
+        case '\r':
+        case '\n': replacement = " "; break;
+        }
+        if (replacement) {
+            out << text.substr(start, i - start) << replacement;
+            start = i + 1;
+        }
+    }
+    out << text.substr(start);
+}
+
+static void writeMarkdown(BufferedFile& out, const TimetableJob& job) {
+    out << "# " << (job.byLab ? "实验室 " : "班级 ");
+    writeMarkdownText(out, job.title);
+    out << " 课表\n\n| 时间 |";
+    for (int day = 0; day < kDaysPerWeek; day++) {
+        out << " " << timetableDayText(day) << " |";
+    }
+    out << "\n|---|";
+    for (int day = 0; day < kDaysPerWeek; day++) {
+        out << "---|";
+    }
+    out << "\n";
+
+    SlotRanges ranges = slotRanges(job.entries);
+    for (int week = kFirstWeek; week < kFirstWeek + kWeekCount; week++) {
+        for (int period = 0; period < kPeriodsPerDay; period++) {
+            out << "| " << weekText(week) << " " << timetablePeriodText(period) << " |";
+            for (int day = 0; day < kDaysPerWeek; day++) {
+                out << " ";
+                bool first = true;
+                for (const TimetableEntry& entry : ranges[slotIndex(TimeSlot{week, day, period})]) {
+                    out << (first ? "" : "<br>");
+                    writeMarkdownText(out, job.byLab ? entry.classId : entry.location);
+                    out << " (";
+                    writeMarkdownText(out, entry.teacher);
+                    out << ")";
+                    first = false;
+                }
+                out << " |";
+            }
+            out << "\n";
+        }
+    }
+    out << "\n共 " << static_cast<long long>(job.entries.size()) << " 节课\n";
+}
+
+// ---------- iCalendar ----------
+
+/**
+ * @brief 写一个 iCalendar 内容行: 转义文本值, 超过 75 字节时折行(不拆开 UTF-8 多字节字符)
+ */
+static void writeICalLine(BufferedFile& out, std::string_view name, std::string_view value, bool text = true) {
+    std::string line(name);
+    line += ':';
+    for (char c : value) {
+        if (text && (c == '\\' || c == ';' || c == ',')) {
+            line += '\\';
+            line += c;
+        } else if (text && c == '\n') {
+            line += "\\n";
+        } else if (c != '\r') {
+            line += c;
+        }
+    }
+
+    std::string_view rest = line;
+    size_t limit = kICalLineBytes;
+    while (rest.size() > limit) {
+        size_t cut = limit;
+        while (cut > 0 && (static_cast<unsigned char>(rest[cut]) & 0xC0) == 0x80) {
+            cut--;
+        }
+        out << rest.substr(0, cut) << "\r\n ";
+        rest.remove_prefix(cut);
+        limit = kICalLineBytes - 1;  // 续行以一个空格开头
+    }
+    out << rest << "\r\n";
+}
+
+static std::string icalDateTime(std::chrono::sys_days date, int hhmm) {
+    std::chrono::year_month_day ymd(date);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%04d%02d%02dT%02d%02d00", static_cast<int>(ymd.year()),
+                  static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()), hhmm / 100, hhmm % 100);
+    return text;
+}
+
+static std::string icalTimestamp(std::chrono::system_clock::time_point time) {
+    auto seconds = std::chrono::floor<std::chrono::seconds>(time);
+    auto date = std::chrono::floor<std::chrono::days>(seconds);
+    std::chrono::hh_mm_ss clock(seconds - date);
+    std::chrono::year_month_day ymd(date);
+    char text[32];
+    std::snprintf(text, sizeof(text), "%04d%02d%02dT%02d%02d%02dZ", static_cast<int>(ymd.year()),
+                  static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                  static_cast<int>(clock.hours().count()), static_cast<int>(clock.minutes().count()),
+                  static_cast<int>(clock.seconds().count()));
+    return text;
+}
+
+static void writeICalendar(BufferedFile& out, const TimetableJob& job, const TimetableExportOptions& options,
+                           const std::string& stamp) {
+    std::string title = (job.byLab ? "实验室 " : "班级 ") + job.title + " 课表";
+    writeICalLine(out, "BEGIN", "VCALENDAR", false);
+    writeICalLine(out, "VERSION", "2.0", false);
+    writeICalLine(out, "PRODID", "-//algo-homework//timetable export//ZH", false);
+    writeICalLine(out, "CALSCALE", "GREGORIAN", false);
+    writeICalLine(out, "X-WR-CALNAME", title);
+
+    const std::chrono::sys_days termStart(options.termStart);
+    for (const TimetableEntry& entry : job.entries) {
+        const TimeSlot& slot = entry.timeSlot;
+        if (slot.period < 0 || slot.period > 1) {
+            continue;
+        }
+        std::chrono::sys_days date = termStart + std::chrono::days((slot.week - 1) * 7 + slot.day);
+        std::string uid = std::to_string(entry.requestId) + "-" + std::to_string(entry.labId) + "-" +
+                          std::to_string(slot.week) + "-" + std::to_string(slot.day) + "-" +
+                          std::to_string(slot.period) + "@algo-homework";
+        std::string summary = std::string(entry.classId) + " 实验 @ " + std::string(entry.location);
+
+        writeICalLine(out, "BEGIN", "VEVENT", false);
+        writeICalLine(out, "UID", uid, false);
+        writeICalLine(out, "DTSTAMP", stamp, false);
+        writeICalLine(out, "DTSTART", icalDateTime(date, options.periodStart[slot.period]), false);
+        writeICalLine(out, "DTEND", icalDateTime(date, options.periodEnd[slot.period]), false);
+        writeICalLine(out, "SUMMARY", summary);
+        writeICalLine(out, "LOCATION", entry.location);
+        writeICalLine(out, "DESCRIPTION", "教师: " + std::string(entry.teacher) + "\n" +
+                                          std::string(entry.weekText) + " " + std::string(entry.dayText) + " " +
+                                          std::string(entry.periodText));
+        writeICalLine(out, "END", "VEVENT", false);
+    }
+    writeICalLine(out, "END", "VCALENDAR", false);
+}
+
+// ---------- 索引 ----------
+
+static bool writeIndex(const std::vector<TimetableJob>& jobs, const TimetableExportOptions& options,
+                       std::string& buffer, long long& bytes) {
+    std::string path = (std::filesystem::path(options.outputDir) /
+                        (std::string("index") + extensionOf(options.format))).string();
+    BufferedFile out(path, buffer);
+    if (!out.isOpen()) {
+        std::cerr << "无法创建文件: " << path << std::endl;
+        return false;
+    }
+
+    bool html = options.format == TimetableFormat::Html;
+    if (html) {
+        writeHtmlHead(out, "课表索引");
+        out << "<h1>课表索引</h1>\n";
+    } else {
+        out << "# 课表索引\n";
+    }
+    for (int byLab = 1; byLab >= 0; byLab--) {
+        bool opened = false;
+        for (const TimetableJob& job : jobs) {
+            if (job.byLab != (byLab == 1)) {
+                continue;
+            }
+            if (!opened) {
+                out << (html ? "<h2>" : "\n## ") << (byLab ? "实验室" : "班级") << (html ? "</h2>\n<ul>\n" : "\n\n");
+                opened = true;
+            }
+            if (html) {
+                out << "<li><a href=\"";
+                writeHtmlText(out, job.fileName);
+                out << "\">";
+                writeHtmlText(out, job.title);
+                out << "</a> (" << static_cast<long long>(job.entries.size()) << ")</li>\n";
+            } else {
+                out << "- [";
+                writeMarkdownText(out, job.title);
+                out << "](<" << job.fileName << ">) (" << static_cast<long long>(job.entries.size()) << ")\n";
+            }
+        }
+        if (opened && html) {
+            out << "</ul>\n";
+        }
+    }
+    if (html) {
+        out << "</body>\n</html>\n";
+    }
+    bool ok = out.close();
+    bytes += out.bytesWritten();
+    if (!ok) {
+        std::cerr << "写入文件失败: " << path << std::endl;
+    }
+    return ok;
+}
+
+bool exportTimetables(const TimetableSnapshot& snapshot, const std::vector<Laboratory>& labs,
+                      const TimetableExportOptions& options, TimetableExportReport& report) {
+    report = TimetableExportReport();
+    auto start = std::chrono::steady_clock::now();
+    const std::string extension = extensionOf(options.format);
+    const std::filesystem::path root(options.outputDir);
+
+    for (const char* sub : {"labs", "classes"}) {
+        std::error_code error;
+        std::filesystem::create_directories(root / sub, error);
+        if (error) {
+            std::cerr << "无法创建目录: " << (root / sub).string() << " (" << error.message() << ")" << std::endl;
+            return false;
+        }
+    }
+
+    // 按实验室的课表按实验室列表顺序, 文件名相同的实验室在文件名后附加实验室 id
+    std::vector<TimetableJob> jobs;
+    if (options.labs) {
+        std::vector<std::string_view> titles;
+        std::vector<int> ids;
+        for (const auto& lab : labs) {
+            titles.push_back(lab.location);
+            ids.push_back(lab.id);
+        }
+        std::vector<std::string> names = distinctFileNames(titles, ids);
+        for (size_t i = 0; i < labs.size(); i++) {
+            jobs.push_back({true, labs[i].location, "labs/" + names[i] + extension, snapshot.byLab(labs[i].id)});
+        }
+    }
+    // 按班级的课表: 按班级排序的课程数组中每个班级是连续的一段, 文件名相同的班级附加序号
+    if (options.classes) {
+        std::span<const TimetableEntry> byClass = snapshot.allByClass();
+        std::vector<std::string_view> titles;
+        std::vector<std::span<const TimetableEntry>> entries;
+        size_t begin = 0;
+        while (begin < byClass.size()) {
+            size_t end = begin + 1;
+            while (end < byClass.size() && byClass[end].classId == byClass[begin].classId) {
+                end++;
+            }
+            titles.push_back(byClass[begin].classId);
+            entries.push_back(byClass.subspan(begin, end - begin));
+            begin = end;
+        }
+        std::vector<std::string> names = distinctFileNames(titles, {});
+        for (size_t i = 0; i < titles.size(); i++) {
+            jobs.push_back({false, std::string(titles[i]), "classes/" + names[i] + extension, entries[i]});
+        }
+    }
+
+    const std::string stamp = icalTimestamp(std::chrono::system_clock::now());
+    ThreadPool pool(options.threadCount);
+    std::vector<std::string> buffers(pool.size());
+    std::atomic<long long> bytes{0};
+    std::atomic<int> failed{0};
+    std::mutex errorMutex;
+    for (size_t first = 0; first < jobs.size(); first += kTimetablesPerTask) {
+        size_t last = std::min(jobs.size(), first + kTimetablesPerTask);
+        pool.submit([&, first, last](int worker) {
+            for (size_t i = first; i < last; i++) {
+                const TimetableJob& job = jobs[i];
+                std::string path = (root / job.fileName).string();
+                BufferedFile out(path, buffers[worker]);
+                bool ok = out.isOpen();
+                if (ok) {
+                    switch (options.format) {
+                    case TimetableFormat::Html:      writeHtml(out, job); break;
+                    case TimetableFormat::Markdown:  writeMarkdown(out, job); break;
+                    case TimetableFormat::ICalendar: writeICalendar(out, job, options, stamp); break;
+                    }
+                    ok = out.close();
+                }
+                bytes.fetch_add(out.bytesWritten(), std::memory_order_relaxed);
+                if (!ok) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    std::cerr << "无法写入文件: " << path << std::endl;
+                }
+            }
+        });
+    }
+    pool.wait();
+
+    report.bytes = bytes.load();
+    report.failedFiles = failed.load();
+    for (const TimetableJob& job : jobs) {
+        (job.byLab ? report.labFiles : report.classFiles)++;
+        report.entries += static_cast<long long>(job.entries.size());
+    }
+    if (options.format != TimetableFormat::ICalendar && !writeIndex(jobs, options, buffers[0], report.bytes)) {
+        report.failedFiles++;
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report.failedFiles == 0;
+}
@@ -0,0 +1,66 @@
+#ifndef TIMETABLE_EXPORT_H
+#define TIMETABLE_EXPORT_H
+
+#include "database.h"
+#include "timetable_cache.h"
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 批量导出课表的文件格式
+ */
+enum class TimetableFormat {
+    Html,       // 可直接打印的网格表(每个文件一页)
+    Markdown,   // Markdown 表格
+    ICalendar   // iCalendar(.ics), 每节课一个事件, 可导入日历软件
+};
+
+const char* timetableFormatName(TimetableFormat format);
+
+/**
+ * @brief 由名称(html/markdown/md/ical/ics)解析格式
+ * @return 名称无法识别时返回 false
+ */
+bool parseTimetableFormat(std::string_view name, TimetableFormat& format);
+
+struct TimetableExportOptions {
+    TimetableFormat format = TimetableFormat::Html;
+    std::string outputDir;  // 其下创建 labs/ 与 classes/ 两个子目录
+    bool labs = true;       // 是否导出每个实验室的课表
+    bool classes = true;    // 是否导出每个班级的课表
+    int threadCount = 0;    // 渲染线程数, <= 0 时使用硬件并发数
+
+    // iCalendar: 第 1 周周一的日期, 与各时段的起止时间(当地时间, 时×100+分)
+    std::chrono::year_month_day termStart{std::chrono::year(2025), std::chrono::month(9), std::chrono::day(1)};
+    int periodStart[2] = {800, 1400};
+    int periodEnd[2] = {1145, 1745};
+};
+
+struct TimetableExportReport {
+    int labFiles = 0;
+    int classFiles = 0;
+    long long entries = 0;   // 写出的课程数(按实验室与按班级分别计入)
+    long long bytes = 0;     // 写出的总字节数
+    int failedFiles = 0;     // 无法创建或写入的文件数
+    double seconds = 0;
+};
+
+/**
+ * @brief 把快照中的课表按实验室和按班级批量写成文件
+ * @param labs 全部实验室(没有课程的实验室也输出一张空课表)
+ *
+ * 快照已按 (实验室, 时间段) 和 (班级, 时间段) 两种顺序各保存一份课程数组,
+ * 每张课表是其中连续的一段, 因此全部课表只需建立快照时对课程安排表的一次顺序读取。
+ * 课表按批分给线程池渲染; 每个工作线程复用自己的输出缓冲区, 积满一定大小再写入文件。
+ * 文件名取实验室地址/班级编号, 其中不能用于文件名的字符替换为 '_';
+ * 替换后相同(不区分大小写)的实验室附加实验室 id, 班级附加序号, 每张课表都有自己的文件;
+ * HTML 与 Markdown 格式另外生成一个索引文件。
+ *
+ * @return 输出目录能创建且所有文件都写入成功时返回 true
+ */
+bool exportTimetables(const TimetableSnapshot& snapshot, const std::vector<Laboratory>& labs,
+                      const TimetableExportOptions& options, TimetableExportReport& report);
+
+#endif // TIMETABLE_EXPORT_H
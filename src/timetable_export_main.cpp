@@ -0,0 +1,78 @@
+#include "database.h"
+#include "timetable_cache.h"
+#include "timetable_export.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// 批量导出课表(不需要Qt): 每个实验室、每个班级各一个文件
+// 用法: timetable_export <数据库文件> <输出目录> [html|markdown|ical] [线程数] [第1周周一 YYYY-MM-DD]
+
+static void printUsage() {
+    std::cerr << "用法: timetable_export <数据库文件> <输出目录> [html|markdown|ical] [线程数] [第1周周一日期]" << std::endl;
+    std::cerr << "  格式默认为 html; 线程数 <= 0 或省略时使用硬件并发数" << std::endl;
+    std::cerr << "  第1周周一日期(YYYY-MM-DD)只用于 ical 格式, 默认为 2025-09-01" << std::endl;
+    std::cerr << "输出目录下生成 labs/ 与 classes/ 两个子目录; html 与 markdown 另有索引文件" << std::endl;
+}
+
+static bool parseDate(const std::string& text, std::chrono::year_month_day& date) {
+    int year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    char tail = 0;
+    if (std::sscanf(text.c_str(), "%d-%u-%u%c", &year, &month, &day, &tail) != 3) {
+        return false;
+    }
+    date = std::chrono::year_month_day(std::chrono::year(year), std::chrono::month(month), std::chrono::day(day));
+    return date.ok();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 6) {
+        printUsage();
+        return 1;
+    }
+
+    TimetableExportOptions options;
+    options.outputDir = argv[2];
+    if (argc > 3 && !parseTimetableFormat(argv[3], options.format)) {
+        std::cerr << "未知的格式: " << argv[3] << std::endl;
+        printUsage();
+        return 1;
+    }
+    if (argc > 4) {
+        options.threadCount = std::atoi(argv[4]);
+    }
+    if (argc > 5 && !parseDate(argv[5], options.termStart)) {
+        std::cerr << "日期无效: " << argv[5] << std::endl;
+        return 1;
+    }
+
+    Database db(argv[1]);
+    if (!db.initialize()) {
+        std::cerr << "数据库初始化失败!" << std::endl;
+        return 1;
+    }
+
+    // 课表只读取一次: 快照按实验室与按班级各排好一份, 每张课表是其中连续的一段
+    auto start = std::chrono::steady_clock::now();
+    TimetableCache cache(&db);
+    auto snapshot = cache.snapshot();
+    std::vector<Laboratory> labs = db.getAllLaboratories();
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TimetableExportReport report;
+    bool ok = exportTimetables(*snapshot, labs, options, report);
+    std::cout << "读取课表 " << snapshot->size() << " 节, 耗时 " << std::fixed << std::setprecision(3)
+              << loadSeconds << " 秒" << std::endl;
+    std::cout << "导出 (" << timetableFormatName(options.format) << "): 实验室课表 " << report.labFiles
+              << " 个, 班级课表 " << report.classFiles << " 个, 共 " << report.bytes / 1024 << " KB, 耗时 "
+              << report.seconds << " 秒" << std::endl;
+    if (!ok) {
+        std::cerr << "导出失败: " << report.failedFiles << " 个文件未能写入" << std::endl;
+        return 1;
+    }
+    return 0;
+}
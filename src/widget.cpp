@@ -1,4 +1,5 @@
 #include "widget.h"
+#include <QCoreApplication>
 #include <QMessageBox>
 #include <QHeaderView>
 #include <sstream>
@@ -16,6 +17,7 @@ Widget::Widget(QWidget* parent)
     
     // 初始化调度器
     scheduler = new Scheduler(database);
+    timetableCache = new TimetableCache(database);
     
     // 设置UI
     setupUI();
@@ -29,6 +31,7 @@ Widget::Widget(QWidget* parent)
 }
 
 Widget::~Widget() {
+    delete timetableCache;
     delete scheduler;
     delete database;
 }
@@ -64,20 +67,25 @@ void Widget::setupLabTab() {
     labCapacitySpinBox->setValue(40);
     inputLayout->addWidget(labCapacitySpinBox, 1, 1);
     
+    inputLayout->addWidget(new QLabel("设备特性:"), 2, 0);
+    labFeaturesEdit = new QLineEdit();
+    labFeaturesEdit->setPlaceholderText("逗号分隔, 例如: fume_hood,gpu (可留空)");
+    inputLayout->addWidget(labFeaturesEdit, 2, 1);
+    
     QHBoxLayout* buttonLayout = new QHBoxLayout();
     addLabButton = new QPushButton("添加实验室");
     deleteLabButton = new QPushButton("删除选中实验室");
     buttonLayout->addWidget(addLabButton);
     buttonLayout->addWidget(deleteLabButton);
     buttonLayout->addStretch();
-    inputLayout->addLayout(buttonLayout, 2, 0, 1, 2);
+    inputLayout->addLayout(buttonLayout, 3, 0, 1, 2);
     
     layout->addWidget(inputGroup);
     
     // 表格区域
     labTable = new QTableWidget();
-    labTable->setColumnCount(3);
-    labTable->setHorizontalHeaderLabels({"ID", "实验室地址", "容纳人数"});
+    labTable->setColumnCount(5);
+    labTable->setHorizontalHeaderLabels({"ID", "实验室地址", "容纳人数", "设备特性", "不可用时间段"});
     labTable->horizontalHeader()->setStretchLastSection(true);
     labTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     labTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -121,6 +129,19 @@ void Widget::setupRequestTab() {
     prioritySpinBox->setToolTip("数字越小优先级越高");
     basicLayout->addWidget(prioritySpinBox, 1, 3);
     
+    basicLayout->addWidget(new QLabel("所需设备:"), 2, 0);
+    requestFeaturesEdit = new QLineEdit();
+    requestFeaturesEdit->setPlaceholderText("逗号分隔, 例如: oscilloscope (可留空)");
+    basicLayout->addWidget(requestFeaturesEdit, 2, 1, 1, 3);
+    
+    basicLayout->addWidget(new QLabel("课程:"), 3, 0);
+    requestCourseEdit = new QLineEdit();
+    requestCourseEdit->setPlaceholderText("同一课程的班级可共用实验室 (可留空)");
+    basicLayout->addWidget(requestCourseEdit, 3, 1);
+    
+    requestShareableCheck = new QCheckBox("允许与其他课程共用实验室");
+    basicLayout->addWidget(requestShareableCheck, 3, 2, 1, 2);
+    
     layout->addWidget(basicGroup);
     
     // 时间段选择
@@ -179,8 +200,8 @@ void Widget::setupRequestTab() {
     
     // 表格
     requestTable = new QTableWidget();
-    requestTable->setColumnCount(5);
-    requestTable->setHorizontalHeaderLabels({"ID", "班级", "人数", "教师", "优先级"});
+    requestTable->setColumnCount(7);
+    requestTable->setHorizontalHeaderLabels({"ID", "班级", "人数", "教师", "优先级", "所需设备", "课程"});
     requestTable->horizontalHeader()->setStretchLastSection(true);
     requestTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     requestTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -209,6 +230,18 @@ void Widget::setupScheduleTab() {
     infoLabel->setWordWrap(true);
     layout->addWidget(infoLabel);
     
+    roomSharingCheck = new QCheckBox("教室共享: 同一课程或允许共用的小班可按座位共用一个实验室");
+    layout->addWidget(roomSharingCheck);
+    
+    QHBoxLayout* optimizeLayout = new QHBoxLayout();
+    optimizeLayout->addWidget(new QLabel("优化时间(秒, 0 表示只做一次贪心求解):"));
+    optimizeSecondsSpinBox = new QSpinBox();
+    optimizeSecondsSpinBox->setRange(0, 600);
+    optimizeSecondsSpinBox->setValue(0);
+    optimizeLayout->addWidget(optimizeSecondsSpinBox);
+    optimizeLayout->addStretch();
+    layout->addLayout(optimizeLayout);
+    
     generateButton = new QPushButton("生成课程安排");
     generateButton->setMinimumHeight(40);
     QFont buttonFont = generateButton->font();
@@ -275,9 +308,12 @@ void Widget::addLaboratory() {
     
     int capacity = labCapacitySpinBox->value();
     
-    if (database->addLaboratory(location.toStdString(), capacity)) {
+    std::vector<std::string> features = splitFeatures(labFeaturesEdit->text());
+    
+    if (database->addLaboratory(location.toStdString(), capacity, features)) {
         QMessageBox::information(this, "成功", "实验室添加成功!");
         labLocationEdit->clear();
+        labFeaturesEdit->clear();
         refreshLabTable();
         
         // 更新查询下拉框
@@ -319,6 +355,14 @@ void Widget::refreshLabTable() {
         labTable->setItem(i, 0, new QTableWidgetItem(QString::number(labs[i].id)));
         labTable->setItem(i, 1, new QTableWidgetItem(QString::fromStdString(labs[i].location)));
         labTable->setItem(i, 2, new QTableWidgetItem(QString::number(labs[i].capacity)));
+        labTable->setItem(i, 3, new QTableWidgetItem(joinFeatures(labs[i].features)));
+        QStringList blackout;
+        for (int slot = 0; slot < kSlotCount; slot++) {
+            if (hasSlot(labs[i].blackout, slot)) {
+                blackout << timeSlotToString(slotFromIndex(slot));
+            }
+        }
+        labTable->setItem(i, 4, new QTableWidgetItem(blackout.join(", ")));
     }
 }
 
@@ -350,6 +394,9 @@ void Widget::addRequest() {
     request.studentCount = studentCountSpinBox->value();
     request.teacher = teacher.toStdString();
     request.priority = prioritySpinBox->value();
+    request.requiredFeatures = splitFeatures(requestFeaturesEdit->text());
+    request.course = requestCourseEdit->text().trimmed().toStdString();
+    request.shareable = requestShareableCheck->isChecked();
     
     // 收集时间段选择
     for (int w = 0; w < 2; w++) {
@@ -376,6 +423,9 @@ void Widget::addRequest() {
         QMessageBox::information(this, "成功", "申请添加成功!");
         classIdEdit->clear();
         teacherEdit->clear();
+        requestFeaturesEdit->clear();
+        requestCourseEdit->clear();
+        requestShareableCheck->setChecked(false);
         
         // 清除复选框
         for (int w = 0; w < 2; w++) {
@@ -419,6 +469,12 @@ void Widget::refreshRequestTable() {
         requestTable->setItem(i, 2, new QTableWidgetItem(QString::number(requests[i].studentCount)));
         requestTable->setItem(i, 3, new QTableWidgetItem(QString::fromStdString(requests[i].teacher)));
         requestTable->setItem(i, 4, new QTableWidgetItem(QString::number(requests[i].priority)));
+        requestTable->setItem(i, 5, new QTableWidgetItem(joinFeatures(requests[i].requiredFeatures)));
+        QString course = QString::fromStdString(requests[i].course);
+        if (requests[i].shareable) {
+            course += course.isEmpty() ? "(可共用)" : " (可共用)";
+        }
+        requestTable->setItem(i, 6, new QTableWidgetItem(course));
     }
 }
 
@@ -440,6 +496,23 @@ void Widget::generateSchedule() {
     scheduleResultText->clear();
     scheduleResultText->append("正在生成课程安排...\n");
     
+    scheduler->setRoomSharing(roomSharingCheck->isChecked() ? RoomSharing::BestFit : RoomSharing::Off);
+    
+    // 优化期间每找到一个更好的课表就显示一行进度(只处理绘制事件, 不接受新的点击)
+    AnytimeOptions anytime;
+    anytime.timeBudget = optimizeSecondsSpinBox->value();
+    if (anytime.timeBudget > 0) {
+        anytime.onIncumbent = [this](const AnytimeIncumbent& incumbent) {
+            scheduleResultText->append(QString("第 %1 轮 (%2, %3 秒): 成功 %4, 期望时间段 %5, 总分 %6")
+                                       .arg(incumbent.round).arg(incumbent.engine)
+                                       .arg(incumbent.seconds, 0, 'f', 2)
+                                       .arg(incumbent.scores.placed).arg(incumbent.scores.preferred)
+                                       .arg(incumbent.scores.total, 0, 'f', 1));
+            QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+            return true;
+        };
+    }
+    scheduler->setAnytime(anytime);
     int successCount = scheduler->generateSchedule();
     
     auto stats = scheduler->getScheduleStats();
@@ -449,6 +522,11 @@ void Widget::generateSchedule() {
     scheduleResultText->append(QString("成功分配: %1").arg(stats.successfulRequests));
     scheduleResultText->append(QString("失败数量: %1").arg(stats.failedRequests));
     scheduleResultText->append(QString("成功率: %1%").arg(stats.successRate, 0, 'f', 2));
+    scheduleResultText->append(QString("期望时间段: %1, 备选时间段: %2")
+                               .arg(stats.objective.preferred).arg(stats.objective.fallback));
+    scheduleResultText->append(QString("空置座位: %1, 教师换楼: %2 次")
+                               .arg(stats.objective.wastedSeats).arg(stats.objective.teacherTravel));
+    scheduleResultText->append(QString("目标函数总分: %1").arg(stats.objective.total, 0, 'f', 1));
     
     if (!stats.failedClasses.empty()) {
         scheduleResultText->append("\n未能分配的班级:");
@@ -475,27 +553,8 @@ void Widget::queryByLab() {
     }
     
     int labId = queryLabCombo->currentData().toInt();
-    auto schedules = database->getSchedulesByLab(labId);
-    
-    queryResultTable->setRowCount(schedules.size());
-    
-    for (size_t i = 0; i < schedules.size(); i++) {
-        auto request = database->getRequest(schedules[i].requestId);
-        auto lab = database->getLaboratory(schedules[i].labId);
-        
-        queryResultTable->setItem(i, 0, new QTableWidgetItem(
-            QString::fromStdString(request.classId)));
-        queryResultTable->setItem(i, 1, new QTableWidgetItem(
-            QString::fromStdString(request.teacher)));
-        queryResultTable->setItem(i, 2, new QTableWidgetItem(
-            QString::fromStdString(lab.location)));
-        queryResultTable->setItem(i, 3, new QTableWidgetItem(
-            QString("第%1周").arg(schedules[i].timeSlot.week)));
-        queryResultTable->setItem(i, 4, new QTableWidgetItem(
-            dayToString(schedules[i].timeSlot.day)));
-        queryResultTable->setItem(i, 5, new QTableWidgetItem(
-            periodToString(schedules[i].timeSlot.period)));
-    }
+    auto timetable = timetableCache->snapshot();
+    showTimetable(timetable->byLab(labId));
 }
 
 void Widget::queryByClass() {
@@ -505,31 +564,34 @@ void Widget::queryByClass() {
         return;
     }
     
-    auto schedules = database->getSchedulesByClass(classId.toStdString());
+    // 快照在本函数内保持有效, 其中的文本可直接引用
+    auto timetable = timetableCache->snapshot();
+    QByteArray key = classId.toUtf8();
+    auto entries = timetable->byClass(std::string_view(key.constData(), key.size()));
     
-    if (schedules.empty()) {
+    if (entries.empty()) {
         QMessageBox::information(this, "提示", "未找到该班级的课程安排!");
         return;
     }
     
-    queryResultTable->setRowCount(schedules.size());
-    
-    for (size_t i = 0; i < schedules.size(); i++) {
-        auto request = database->getRequest(schedules[i].requestId);
-        auto lab = database->getLaboratory(schedules[i].labId);
-        
-        queryResultTable->setItem(i, 0, new QTableWidgetItem(
-            QString::fromStdString(request.classId)));
-        queryResultTable->setItem(i, 1, new QTableWidgetItem(
-            QString::fromStdString(request.teacher)));
-        queryResultTable->setItem(i, 2, new QTableWidgetItem(
-            QString::fromStdString(lab.location)));
-        queryResultTable->setItem(i, 3, new QTableWidgetItem(
-            QString("第%1周").arg(schedules[i].timeSlot.week)));
-        queryResultTable->setItem(i, 4, new QTableWidgetItem(
-            dayToString(schedules[i].timeSlot.day)));
-        queryResultTable->setItem(i, 5, new QTableWidgetItem(
-            periodToString(schedules[i].timeSlot.period)));
+    showTimetable(entries);
+}
+
+void Widget::showTimetable(std::span<const TimetableEntry> entries) {
+    auto text = [](std::string_view view) {
+        return QString::fromUtf8(view.data(), static_cast<qsizetype>(view.size()));
+    };
+    
+    queryResultTable->setRowCount(entries.size());
+    
+    for (size_t i = 0; i < entries.size(); i++) {
+        const TimetableEntry& entry = entries[i];
+        queryResultTable->setItem(i, 0, new QTableWidgetItem(text(entry.classId)));
+        queryResultTable->setItem(i, 1, new QTableWidgetItem(text(entry.teacher)));
+        queryResultTable->setItem(i, 2, new QTableWidgetItem(text(entry.location)));
+        queryResultTable->setItem(i, 3, new QTableWidgetItem(text(entry.weekText)));
+        queryResultTable->setItem(i, 4, new QTableWidgetItem(text(entry.dayText)));
+        queryResultTable->setItem(i, 5, new QTableWidgetItem(text(entry.periodText)));
     }
 }
 
@@ -570,3 +632,22 @@ QString Widget::dayToString(int day) {
 QString Widget::periodToString(int period) {
     return period == 0 ? "上午(2-5节)" : "下午(6-9节)";
 }
+
+std::vector<std::string> Widget::splitFeatures(const QString& text) {
+    std::vector<std::string> features;
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        QString name = part.trimmed();
+        if (!name.isEmpty()) {
+            features.push_back(name.toStdString());
+        }
+    }
+    return features;
+}
+
+QString Widget::joinFeatures(const std::vector<std::string>& features) {
+    QStringList names;
+    for (const auto& name : features) {
+        names << QString::fromStdString(name);
+    }
+    return names.join(",");
+}
@@ -18,6 +18,7 @@
 #include <QMessageBox>
 #include "database.h"
 #include "scheduler.h"
+#include "timetable_cache.h"
 
 class Widget : public QWidget {
     Q_OBJECT
@@ -51,6 +52,7 @@ private:
     // 数据库和调度器
     Database* database;
     Scheduler* scheduler;
+    TimetableCache* timetableCache;  // 课表查询缓存, 课表重新生成后自动失效
     
     // UI组件
     QTabWidget* tabWidget;
@@ -59,6 +61,7 @@ private:
     QWidget* labTab;
     QLineEdit* labLocationEdit;
     QSpinBox* labCapacitySpinBox;
+    QLineEdit* labFeaturesEdit;
     QPushButton* addLabButton;
     QPushButton* deleteLabButton;
     QTableWidget* labTable;
@@ -69,6 +72,9 @@ private:
     QSpinBox* studentCountSpinBox;
     QLineEdit* teacherEdit;
     QSpinBox* prioritySpinBox;
+    QLineEdit* requestFeaturesEdit;
+    QLineEdit* requestCourseEdit;
+    QCheckBox* requestShareableCheck;
     QGroupBox* timeSlotGroup;
     QCheckBox* timeSlotChecks[2][5][2];  // [周次][星期][时段]
     QPushButton* addRequestButton;
@@ -77,6 +83,8 @@ private:
     
     // 课表生成标签页
     QWidget* scheduleTab;
+    QCheckBox* roomSharingCheck;
+    QSpinBox* optimizeSecondsSpinBox;  // 随时可停求解的时间预算, 0 表示不优化
     QPushButton* generateButton;
     QTextEdit* scheduleResultText;
     
@@ -96,9 +104,12 @@ private:
     void setupQueryTab();
     
     // 辅助函数
+    void showTimetable(std::span<const TimetableEntry> entries);
     QString timeSlotToString(const TimeSlot& slot);
     QString dayToString(int day);
     QString periodToString(int period);
+    std::vector<std::string> splitFeatures(const QString& text);
+    QString joinFeatures(const std::vector<std::string>& features);
 };
 
 #endif // WIDGET_H